@@ -0,0 +1,42 @@
+// Converts a metric dump written by batt::MetricBinaryFormatter to CSV.
+//
+//   metric_bin2csv <input-file> [<output-file>]
+//
+// If no output file is given, the CSV is written to stdout.
+//
+#include <batteries/metrics/metric_binary_formatter.hpp>
+
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3) {
+        std::cerr << "usage: " << argv[0] << " <input-file> [<output-file>]" << std::endl;
+        return 2;
+    }
+
+    std::ifstream src{argv[1], std::ios::binary};
+    if (!src) {
+        std::cerr << "could not open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::ofstream dst_file;
+    if (argc == 3) {
+        dst_file.open(argv[2]);
+        if (!dst_file) {
+            std::cerr << "could not open " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& dst = (argc == 3) ? dst_file : std::cout;
+
+    batt::Status status = batt::convert_metric_binary_to_csv(src, dst);
+    if (!status.ok()) {
+        std::cerr << "error: " << status << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -7,10 +7,15 @@
 
 #include <batteries/algo/parallel_copy.hpp>
 
+#include <batteries/async/slice_work.hpp>
 #include <batteries/async/work_context.hpp>
+#include <batteries/async/worker_pool.hpp>
 
 #include <batteries/int_types.hpp>
 
+#include <algorithm>
+#include <iterator>
+
 namespace batt {
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -172,7 +177,9 @@ void parallel_merge_fanout(WorkContext& context,                          //
                            usize max_tasks,                               //
                            batt::StaticType<Phase>)
 {
-    const usize max_tasks_per_phase = (max_tasks + 1) / 2;
+    // `max_tasks` may be 0 (e.g., the default of `hardware_concurrency() / 2` on a single-core machine).
+    //
+    const usize max_tasks_per_phase = std::max<usize>(1, (max_tasks + 1) / 2);
     isize fixed_part_size = std::distance(fixed_part_begin, fixed_part_end);
     const isize target_size =
         std::max((fixed_part_size + max_tasks_per_phase - 1) / max_tasks_per_phase, (min_task_size + 1) / 2);
@@ -257,6 +264,34 @@ void parallel_merge_fanout(WorkContext& context,                          //
     }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Returns the number of items from the first input among the first `diagonal` items of the (stable) merged
+// output, found by binary search along the diagonal of the merge path.  `src_0_size + src_1_size` must be at
+// least `diagonal`.
+//
+template <typename Src0, typename Src1, typename Compare>
+isize merge_path_co_rank(Src0 src_0_begin, isize src_0_size,  //
+                         Src1 src_1_begin, isize src_1_size,  //
+                         isize diagonal,                      //
+                         const Compare& compare)
+{
+    isize lower = std::max<isize>(0, diagonal - src_1_size);
+    isize upper = std::min<isize>(diagonal, src_0_size);
+
+    // Taking `i` items from the first input is too few if its next item belongs before the last item taken
+    // from the second (equal items come from the first input first).
+    //
+    while (lower < upper) {
+        const isize i = lower + (upper - lower) / 2;
+        if (!compare(*std::next(src_1_begin, diagonal - i - 1), *std::next(src_0_begin, i))) {
+            lower = i + 1;
+        } else {
+            upper = i;
+        }
+    }
+    return lower;
+}
+
 }  // namespace detail
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -303,6 +338,71 @@ void parallel_merge(WorkContext& context,                                      /
                                 batt::StaticType<detail::FirstPhase>{});
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Merge-path variant of parallel_merge: the output is divided into equal slices according to `params` (see
+// slice_work), and each task finds where its slice starts and ends in both inputs by binary search (see
+// detail::merge_path_co_rank), then merges it sequentially.  Unlike parallel_merge, the work is evenly
+// balanced no matter how the inputs are distributed, and it is divided in a single fan-out.
+//
+template <typename Src0, typename Src1, typename Dst, typename Compare>
+void parallel_merge_path(WorkContext& context,              //
+                         Src0 src_0_begin, Src0 src_0_end,  //
+                         Src1 src_1_begin, Src1 src_1_end,  //
+                         Dst dst_begin,                     //
+                         const Compare& compare,            //
+                         const WorkSliceParams& params)
+{
+    const isize src_0_size = std::distance(src_0_begin, src_0_end);
+    const isize src_1_size = std::distance(src_1_begin, src_1_end);
+
+    const WorkSlicePlan plan{params, InputSize{static_cast<usize>(src_0_size + src_1_size)}};
+
+    if (plan.n_tasks <= 1) {
+        std::merge(src_0_begin, src_0_end, src_1_begin, src_1_end, dst_begin, compare);
+        return;
+    }
+
+    slice_work(context, plan,
+               /*gen_work_fn=*/[&](usize /*task_index*/, isize task_offset, isize task_size) {
+                   return [src_0_begin, src_0_size, src_1_begin, src_1_size, dst_begin, compare,  //
+                           task_offset, task_size] {
+                       const isize task_end = task_offset + task_size;
+
+                       const isize src_0_shard_begin = detail::merge_path_co_rank(
+                           src_0_begin, src_0_size, src_1_begin, src_1_size, task_offset, compare);
+                       const isize src_0_shard_end = detail::merge_path_co_rank(
+                           src_0_begin, src_0_size, src_1_begin, src_1_size, task_end, compare);
+
+                       std::merge(std::next(src_0_begin, src_0_shard_begin),                //
+                                  std::next(src_0_begin, src_0_shard_end),                  //
+                                  std::next(src_1_begin, task_offset - src_0_shard_begin),  //
+                                  std::next(src_1_begin, task_end - src_0_shard_end),       //
+                                  std::next(dst_begin, task_offset),                        //
+                                  compare);
+                   };
+               });
+}
+
+// Merge-path variant of parallel_merge, with the default WorkSliceParams for `worker_pool` (so the number of
+// tasks scales with the size of the pool).
+//
+template <typename Src0, typename Src1, typename Dst, typename Compare>
+void parallel_merge_path(WorkerPool& worker_pool,           //
+                         Src0 src_0_begin, Src0 src_0_end,  //
+                         Src1 src_1_begin, Src1 src_1_end,  //
+                         Dst dst_begin,                     //
+                         const Compare& compare)
+{
+    ScopedWorkContext context{worker_pool};
+
+    parallel_merge_path(context,                 //
+                        src_0_begin, src_0_end,  //
+                        src_1_begin, src_1_end,  //
+                        dst_begin,               //
+                        compare,                 //
+                        WorkSliceParams::from_worker_pool(worker_pool));
+}
+
 }  // namespace batt
 
 #endif  // BATTERIES_ALGO_PARALLEL_MERGE_HPP
@@ -184,6 +184,18 @@ class ParallelMergeTest : public ::testing::Test
                              std::less<int>{});
     }
 
+    void do_merge_path()
+    {
+        this->actual_output.clear();
+        this->actual_output.resize(this->first_input.size() + this->second_input.size());
+
+        batt::parallel_merge_path(WorkerPool::default_pool(),                //
+                                  first_input.begin(), first_input.end(),    //
+                                  second_input.begin(), second_input.end(),  //
+                                  actual_output.begin(),                     //
+                                  std::less<int>{});
+    }
+
     template <typename InputDist>
     void test_all_seeds(std::pair<usize, usize> input_size, InputDist&& input_dist)
     {
@@ -191,6 +203,11 @@ class ParallelMergeTest : public ::testing::Test
             this->initialize_inputs(seed, input_size, input_dist);
             this->do_merge();
             EXPECT_THAT(this->actual_output, ::testing::ContainerEq(this->expected_output));
+
+            // `expected_output` is set by `do_merge`.
+            //
+            this->do_merge_path();
+            EXPECT_THAT(this->actual_output, ::testing::ContainerEq(this->expected_output));
         }
     }
 
@@ -339,4 +356,69 @@ TEST_F(ParallelMergeTest, RandomizedStable)
     }
 }
 
+TEST_F(ParallelMergeTest, MergePathRandomizedStable)
+{
+    using namespace batt::int_types;
+
+    auto order_by_first = [](const auto& l, const auto& r) {
+        return l.first < r.first;
+    };
+
+    for (usize seed = 0; seed < 100 * 1000; ++seed) {
+        std::default_random_engine rng{seed};
+        std::uniform_int_distribution<int> delta{0, 6};
+        std::uniform_int_distribution<usize> pick_size{0, 12};
+        std::uniform_int_distribution<usize> pick_tasks{1, 30};
+
+        std::vector<std::pair<int, int>> src0, src1, dst_actual, dst_expected;
+
+        const usize n0 = pick_size(rng);
+        const usize n1 = pick_size(rng);
+
+        int v = 0;
+        for (usize i = 0; i < n0; ++i) {
+            v += delta(rng);
+            src0.emplace_back(v, i);
+        }
+        v = 0;
+        for (usize i = 0; i < n1; ++i) {
+            v += delta(rng);
+            src1.emplace_back(v, i + n0);
+        }
+
+        dst_expected.resize(n0 + n1);
+        std::merge(src0.begin(), src0.end(), src1.begin(), src1.end(), dst_expected.begin(), order_by_first);
+
+        // Every task count (up to one task per output item) must produce the same, stable output.
+        //
+        dst_actual.resize(n0 + n1);
+        {
+            batt::ScopedWorkContext context{WorkerPool::null_pool()};
+
+            const batt::WorkSliceParams params{batt::TaskSize{1}, batt::TaskCount{pick_tasks(rng)}};
+
+            batt::parallel_merge_path(context, src0.begin(), src0.end(), src1.begin(), src1.end(),
+                                      dst_actual.begin(), order_by_first, params);
+        }
+
+        EXPECT_THAT(dst_actual, ::testing::ContainerEq(dst_expected)) << BATT_INSPECT(seed);
+    }
+}
+
+TEST(ParallelMergePathTest, CoRank)
+{
+    // Merging {1, 3, 3, 5} with {2, 3, 4}: 1 2 3 3 3 4 5, where the 3s from the first input come first.
+    //
+    const std::vector<int> src0{1, 3, 3, 5};
+    const std::vector<int> src1{2, 3, 4};
+
+    const std::vector<isize> expected{0, 1, 1, 2, 3, 3, 3, 4};
+    for (isize diagonal = 0; diagonal <= 7; ++diagonal) {
+        EXPECT_EQ(batt::detail::merge_path_co_rank(src0.begin(), 4, src1.begin(), 3, diagonal,  //
+                                                   std::less<int>{}),
+                  expected[diagonal])
+            << BATT_INSPECT(diagonal);
+    }
+}
+
 }  // namespace
@@ -0,0 +1,232 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022-2023 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_ALGO_PARALLEL_RADIX_SORT_HPP
+#define BATTERIES_ALGO_PARALLEL_RADIX_SORT_HPP
+
+#include <batteries/algo/parallel_copy.hpp>
+#include <batteries/algo/parallel_running_total.hpp>
+#include <batteries/algo/running_total.hpp>
+
+#include <batteries/async/slice_work.hpp>
+#include <batteries/async/work_context.hpp>
+#include <batteries/async/worker_pool.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/int_types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace batt {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+namespace detail {
+
+// Radix sort digits are one byte wide.
+//
+constexpr usize kRadixSortDigitBits = 8;
+constexpr usize kRadixSortBuckets = usize{1} << kRadixSortDigitBits;
+
+// The size of the per-bucket write-combining buffer used by each task during the scatter phase.
+//
+constexpr usize kRadixSortBufferBytes = 256;
+
+template <typename T>
+constexpr usize radix_sort_buffer_items()
+{
+    return std::max<usize>(1, kRadixSortBufferBytes / sizeof(T));
+}
+
+template <typename KeyFn, typename Iter>
+using RadixSortKey = std::decay_t<decltype(std::declval<KeyFn&>()(*std::declval<Iter&>()))>;
+
+// Stably sorts `src` into `dst` by the digit of `key_fn` at `shift`.  `counts` and `buffers` are scratch
+// space (to be reused between passes).
+//
+// Returns false (without touching `dst`) if all items have the same digit, in which case there's no need to
+// move them.
+//
+template <typename Src, typename Dst, typename KeyFn, typename ValueType>
+bool parallel_radix_sort_pass(WorkerPool& worker_pool, const WorkSlicePlan& plan,  //
+                              Src src, Dst dst, const KeyFn& key_fn, usize shift,  //
+                              const WorkSliceParams& params,                       //
+                              std::vector<usize>& counts,                          //
+                              std::vector<std::vector<ValueType>>& buffers)
+{
+    const usize n_tasks = plan.n_tasks;
+
+    const auto digit_of = [&key_fn, shift](const auto& item) -> usize {
+        return static_cast<usize>((key_fn(item) >> shift) & (kRadixSortBuckets - 1));
+    };
+
+    // Count the items of each slice by digit.  `counts` is bucket-major (`counts[bucket * n_tasks + task]`),
+    // so that the running total of `counts` is the scatter offset of each (task, bucket).
+    //
+    counts.resize(kRadixSortBuckets * n_tasks);
+    {
+        ScopedWorkContext context{worker_pool};
+
+        slice_work(context, plan,
+                   /*gen_work_fn=*/[&](usize task_index, isize task_offset, isize task_size) {
+                       return [&counts, &digit_of, n_tasks, task_index,
+                               task_begin = std::next(src, task_offset), task_size] {
+                           std::array<usize, kRadixSortBuckets> local_counts;
+                           local_counts.fill(0);
+
+                           std::for_each(task_begin, std::next(task_begin, task_size), [&](const auto& item) {
+                               local_counts[digit_of(item)] += 1;
+                           });
+
+                           for (usize bucket = 0; bucket < kRadixSortBuckets; ++bucket) {
+                               counts[bucket * n_tasks + task_index] = local_counts[bucket];
+                           }
+                       };
+                   });
+    }
+
+    const RunningTotal offsets = parallel_running_total(worker_pool, counts.begin(), counts.end(), params);
+
+    for (usize bucket = 0; bucket < kRadixSortBuckets; ++bucket) {
+        if (offsets[(bucket + 1) * n_tasks] - offsets[bucket * n_tasks] == plan.input_size) {
+            return false;
+        }
+    }
+
+    // Scatter each slice's items to their buckets, staging them in small per-bucket buffers so that each
+    // write to `dst` is a contiguous run.
+    //
+    constexpr usize kBufferItems = radix_sort_buffer_items<ValueType>();
+
+    buffers.resize(n_tasks);
+    {
+        ScopedWorkContext context{worker_pool};
+
+        slice_work(context, plan,
+                   /*gen_work_fn=*/[&](usize task_index, isize task_offset, isize task_size) {
+                       return [&offsets, &digit_of, &buffers, dst, n_tasks, task_index,
+                               task_begin = std::next(src, task_offset), task_size] {
+                           std::array<usize, kRadixSortBuckets> next_offset;
+                           std::array<usize, kRadixSortBuckets> buffered;
+                           for (usize bucket = 0; bucket < kRadixSortBuckets; ++bucket) {
+                               next_offset[bucket] = offsets[bucket * n_tasks + task_index];
+                           }
+                           buffered.fill(0);
+
+                           std::vector<ValueType>& buffer = buffers[task_index];
+                           buffer.resize(kRadixSortBuckets * kBufferItems);
+
+                           const auto flush = [&](usize bucket) {
+                               auto buffer_begin = std::next(buffer.begin(), bucket * kBufferItems);
+                               std::move(buffer_begin, std::next(buffer_begin, buffered[bucket]),
+                                         std::next(dst, next_offset[bucket]));
+                               next_offset[bucket] += buffered[bucket];
+                               buffered[bucket] = 0;
+                           };
+
+                           std::for_each(task_begin, std::next(task_begin, task_size), [&](auto& item) {
+                               const usize bucket = digit_of(item);
+                               buffer[bucket * kBufferItems + buffered[bucket]] = std::move(item);
+                               buffered[bucket] += 1;
+                               if (buffered[bucket] == kBufferItems) {
+                                   flush(bucket);
+                               }
+                           });
+
+                           for (usize bucket = 0; bucket < kRadixSortBuckets; ++bucket) {
+                               flush(bucket);
+                           }
+                       };
+                   });
+    }
+
+    return true;
+}
+
+}  // namespace detail
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Stably sorts [first, last) in ascending order of `key_fn(item)`, which must return an unsigned integer,
+// using a least-significant-digit radix sort on the threads of `worker_pool`.
+//
+// Each pass (one per byte of the key) counts the digits of each slice of the input in parallel (slicing
+// according to `params`), computes the scatter offsets with parallel_running_total, and then moves the items
+// into a scratch buffer of the same size as the input (or back), in parallel.  Passes in which every item
+// has the same digit are skipped.
+//
+// `Iter` must be a random access iterator, and its value type must be default-constructible and
+// move-assignable.
+//
+template <typename Iter, typename KeyFn>
+void parallel_radix_sort(WorkerPool& worker_pool, Iter first, Iter last, const KeyFn& key_fn,
+                         const WorkSliceParams& params)
+{
+    using ValueType = typename std::iterator_traits<Iter>::value_type;
+    using Key = detail::RadixSortKey<KeyFn, Iter>;
+
+    static_assert(std::is_integral_v<Key> && std::is_unsigned_v<Key>,
+                  "parallel_radix_sort requires an unsigned integer key");
+
+    const WorkSlicePlan plan{params, first, last};
+    if (plan.input_size < 2) {
+        return;
+    }
+
+    std::vector<ValueType> scratch(plan.input_size);
+    std::vector<usize> counts;
+    std::vector<std::vector<ValueType>> buffers;
+    bool in_scratch = false;
+
+    for (usize shift = 0; shift < sizeof(Key) * 8; shift += detail::kRadixSortDigitBits) {
+        bool moved = false;
+        if (in_scratch) {
+            moved = detail::parallel_radix_sort_pass(worker_pool, plan, scratch.begin(), first, key_fn, shift,
+                                                     params, counts, buffers);
+        } else {
+            moved = detail::parallel_radix_sort_pass(worker_pool, plan, first, scratch.begin(), key_fn, shift,
+                                                     params, counts, buffers);
+        }
+        if (moved) {
+            in_scratch = !in_scratch;
+        }
+    }
+
+    if (in_scratch) {
+        ScopedWorkContext context{worker_pool};
+
+        parallel_copy(context,                                   //
+                      std::make_move_iterator(scratch.begin()),  //
+                      std::make_move_iterator(scratch.end()),    //
+                      first,                                     //
+                      /*min_task_size=*/params.min_task_size,    //
+                      /*max_tasks=*/params.max_tasks);
+    }
+}
+
+// Stably sorts [first, last) in ascending order of `key_fn(item)`, with the default WorkSliceParams for
+// `worker_pool`.
+//
+template <typename Iter, typename KeyFn>
+void parallel_radix_sort(WorkerPool& worker_pool, Iter first, Iter last, const KeyFn& key_fn)
+{
+    parallel_radix_sort(worker_pool, first, last, key_fn, WorkSliceParams::from_worker_pool(worker_pool));
+}
+
+// Sorts a range of unsigned integers in ascending order.
+//
+template <typename Iter>
+void parallel_radix_sort(WorkerPool& worker_pool, Iter first, Iter last)
+{
+    parallel_radix_sort(worker_pool, first, last, [](const auto& key) {
+        return key;
+    });
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_ALGO_PARALLEL_RADIX_SORT_HPP
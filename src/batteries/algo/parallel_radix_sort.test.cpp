@@ -0,0 +1,158 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022-2023 Anthony Paul Astolfi
+//
+#include <batteries/algo/parallel_radix_sort.hpp>
+//
+#include <batteries/algo/parallel_radix_sort.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. sort empty range, single item
+//  2. sort random u32 and u64 keys
+//     a. default pool, default params
+//     b. null pool
+//     c. many small slices
+//  3. narrow key ranges (passes skipped; result ends up in either buffer)
+//  4. u8 and u16 keys
+//  5. key/value pairs (stability)
+//
+
+using namespace batt::int_types;
+
+template <typename T>
+std::vector<T> random_keys(usize count, usize seed, T max_key = ~T{0})
+{
+    std::default_random_engine rng{seed};
+    std::uniform_int_distribution<u64> pick_key{0, max_key};
+
+    std::vector<T> keys(count);
+    for (T& key : keys) {
+        key = static_cast<T>(pick_key(rng));
+    }
+    return keys;
+}
+
+template <typename T>
+void sort_and_verify(std::vector<T> keys, batt::WorkerPool& worker_pool, const batt::WorkSliceParams& params)
+{
+    std::vector<T> expected = keys;
+    std::sort(expected.begin(), expected.end());
+
+    batt::parallel_radix_sort(
+        worker_pool, keys.begin(), keys.end(),
+        [](T key) {
+            return key;
+        },
+        params);
+
+    EXPECT_THAT(keys, ::testing::ContainerEq(expected));
+}
+
+TEST(AlgoParallelRadixSortTest, EmptyAndSingleItem)
+{
+    std::vector<u64> keys;
+    batt::parallel_radix_sort(batt::WorkerPool::default_pool(), keys.begin(), keys.end());
+    EXPECT_TRUE(keys.empty());
+
+    keys.emplace_back(17);
+    batt::parallel_radix_sort(batt::WorkerPool::default_pool(), keys.begin(), keys.end());
+    EXPECT_THAT(keys, ::testing::ElementsAre(17u));
+}
+
+TEST(AlgoParallelRadixSortTest, DefaultPool)
+{
+    for (usize seed = 0; seed < 10; ++seed) {
+        std::vector<u32> keys32 = random_keys<u32>(100 * 1000 + seed, seed);
+        std::vector<u32> expected32 = keys32;
+        std::sort(expected32.begin(), expected32.end());
+
+        batt::parallel_radix_sort(batt::WorkerPool::default_pool(), keys32.begin(), keys32.end());
+
+        EXPECT_THAT(keys32, ::testing::ContainerEq(expected32));
+
+        std::vector<u64> keys64 = random_keys<u64>(100 * 1000 + seed, seed);
+        std::vector<u64> expected64 = keys64;
+        std::sort(expected64.begin(), expected64.end());
+
+        batt::parallel_radix_sort(batt::WorkerPool::default_pool(), keys64.begin(), keys64.end());
+
+        EXPECT_THAT(keys64, ::testing::ContainerEq(expected64));
+    }
+}
+
+TEST(AlgoParallelRadixSortTest, NullPool)
+{
+    sort_and_verify(random_keys<u64>(20 * 1000, /*seed=*/1), batt::WorkerPool::null_pool(),
+                    batt::WorkSliceParams{batt::TaskSize{1000}, batt::TaskCount{8}});
+}
+
+TEST(AlgoParallelRadixSortTest, ManySlices)
+{
+    sort_and_verify(random_keys<u32>(20 * 1000, /*seed=*/2), batt::WorkerPool::default_pool(),
+                    batt::WorkSliceParams{batt::TaskSize{100}, batt::TaskCount{200}});
+}
+
+TEST(AlgoParallelRadixSortTest, NarrowKeyRanges)
+{
+    // Only the low 1, 2, ... bytes of the keys vary; the other passes are skipped, so the sorted data ends up
+    // in the input or the scratch buffer.
+    //
+    for (u64 max_key : {u64{0}, u64{1}, u64{0xff}, u64{0xffff}, u64{0xffffff}, u64{0xffffffffff}}) {
+        sort_and_verify(random_keys<u64>(10 * 1000, /*seed=*/max_key, max_key),
+                        batt::WorkerPool::default_pool(),
+                        batt::WorkSliceParams{batt::TaskSize{256}, batt::TaskCount{8}});
+    }
+
+    // Keys that differ only in a high byte.
+    //
+    std::vector<u64> keys = random_keys<u64>(10 * 1000, /*seed=*/3, /*max_key=*/0xff);
+    for (u64& key : keys) {
+        key <<= 40;
+    }
+    sort_and_verify(std::move(keys), batt::WorkerPool::default_pool(),
+                    batt::WorkSliceParams{batt::TaskSize{256}, batt::TaskCount{8}});
+}
+
+TEST(AlgoParallelRadixSortTest, SmallKeyTypes)
+{
+    sort_and_verify(random_keys<u8>(10 * 1000, /*seed=*/4), batt::WorkerPool::default_pool(),
+                    batt::WorkSliceParams{batt::TaskSize{256}, batt::TaskCount{8}});
+
+    sort_and_verify(random_keys<u16>(10 * 1000, /*seed=*/5), batt::WorkerPool::default_pool(),
+                    batt::WorkSliceParams{batt::TaskSize{256}, batt::TaskCount{8}});
+}
+
+TEST(AlgoParallelRadixSortTest, KeyValuePairsAreStable)
+{
+    std::vector<u32> keys = random_keys<u32>(50 * 1000, /*seed=*/6, /*max_key=*/0x3ffff);
+
+    std::vector<std::pair<u32, usize>> items;
+    for (usize i = 0; i < keys.size(); ++i) {
+        items.emplace_back(keys[i], i);
+    }
+
+    std::vector<std::pair<u32, usize>> expected = items;
+    std::stable_sort(expected.begin(), expected.end(), [](const auto& l, const auto& r) {
+        return l.first < r.first;
+    });
+
+    batt::parallel_radix_sort(
+        batt::WorkerPool::default_pool(), items.begin(), items.end(),
+        [](const std::pair<u32, usize>& item) {
+            return item.first;
+        },
+        batt::WorkSliceParams{batt::TaskSize{1000}, batt::TaskCount{8}});
+
+    EXPECT_THAT(items, ::testing::ContainerEq(expected));
+}
+
+}  // namespace
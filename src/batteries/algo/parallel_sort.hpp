@@ -0,0 +1,178 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022-2023 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_ALGO_PARALLEL_SORT_HPP
+#define BATTERIES_ALGO_PARALLEL_SORT_HPP
+
+#include <batteries/algo/parallel_copy.hpp>
+#include <batteries/algo/parallel_merge.hpp>
+
+#include <batteries/async/slice_work.hpp>
+#include <batteries/async/work_context.hpp>
+#include <batteries/async/worker_pool.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/int_types.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace batt {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+namespace detail {
+
+// Merges each adjacent pair of the sorted runs of `src` (the run boundaries are `run_offsets`, the first of
+// which is always 0 and the last the size of the input) into `dst`, moving elements.  An unpaired last run is
+// moved as-is.  `run_offsets` is updated to the boundaries of the merged runs.
+//
+template <typename Src, typename Dst, typename Compare>
+void parallel_sort_merge_pass(WorkerPool& worker_pool, Src src, Dst dst, std::vector<isize>& run_offsets,
+                              const Compare& compare, const WorkSliceParams& params)
+{
+    const usize n_runs = run_offsets.size() - 1;
+    const usize n_merges = n_runs / 2;
+
+    // Divide the available tasks between the merges done at the same time.
+    //
+    const usize max_tasks_per_merge = std::max<usize>(2, params.max_tasks / std::max<usize>(1, n_merges));
+
+    std::vector<isize> merged_offsets;
+    merged_offsets.reserve(n_merges + 2);
+    {
+        ScopedWorkContext context{worker_pool};
+
+        for (usize i = 0; i < n_runs; i += 2) {
+            const isize begin = run_offsets[i];
+            merged_offsets.emplace_back(begin);
+
+            if (i + 1 == n_runs) {
+                context.async_run([src, dst, begin, end = run_offsets[i + 1]] {
+                    std::copy(std::make_move_iterator(std::next(src, begin)),
+                              std::make_move_iterator(std::next(src, end)), std::next(dst, begin));
+                });
+                continue;
+            }
+
+            const isize middle = run_offsets[i + 1];
+            const isize end = run_offsets[i + 2];
+
+            auto merge_fn = [&context, src, dst, begin, middle, end, &compare, &params, max_tasks_per_merge] {
+                parallel_merge_path(context,                                          //
+                                    std::make_move_iterator(std::next(src, begin)),   //
+                                    std::make_move_iterator(std::next(src, middle)),  //
+                                    std::make_move_iterator(std::next(src, middle)),  //
+                                    std::make_move_iterator(std::next(src, end)),     //
+                                    std::next(dst, begin),                            //
+                                    compare,                                          //
+                                    WorkSliceParams{params.min_task_size, TaskCount{max_tasks_per_merge}});
+            };
+
+            if (i + 2 == n_runs) {
+                merge_fn();
+            } else {
+                context.async_run(merge_fn);
+            }
+        }
+    }
+    merged_offsets.emplace_back(run_offsets.back());
+
+    run_offsets = std::move(merged_offsets);
+}
+
+}  // namespace detail
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Sorts [first, last) using the threads of `worker_pool`; the sort is not stable.
+//
+// The input is divided into one run per task (as planned by `params`), each run is sorted with std::sort,
+// and then pairs of adjacent runs are merged with parallel_merge_path, alternating between the input range
+// and a scratch buffer of the same size, until there is a single run.
+//
+// `Iter` must be a random access iterator, and its value type must be default-constructible and
+// move-assignable.
+//
+template <typename Iter, typename Compare>
+void parallel_sort(WorkerPool& worker_pool, Iter first, Iter last, Compare&& compare,
+                   const WorkSliceParams& params)
+{
+    using ValueType = typename std::iterator_traits<Iter>::value_type;
+
+    const WorkSlicePlan plan{params, first, last};
+
+    if (plan.n_tasks <= 1) {
+        std::sort(first, last, compare);
+        return;
+    }
+
+    // Sort each leaf run.
+    //
+    std::vector<isize> run_offsets;
+    run_offsets.reserve(plan.n_tasks + 1);
+    {
+        ScopedWorkContext context{worker_pool};
+
+        slice_work(context, plan,
+                   /*gen_work_fn=*/[&](usize /*task_index*/, isize task_offset, isize task_size) {
+                       run_offsets.emplace_back(task_offset);
+                       return [first, task_offset, task_size, &compare] {
+                           auto task_begin = std::next(first, task_offset);
+                           std::sort(task_begin, std::next(task_begin, task_size), compare);
+                       };
+                   });
+    }
+    run_offsets.emplace_back(plan.input_size);
+
+    // Merge runs, ping-ponging between the input and the scratch buffer.
+    //
+    std::vector<ValueType> scratch(plan.input_size);
+    bool in_scratch = false;
+
+    while (run_offsets.size() > 2) {
+        if (in_scratch) {
+            detail::parallel_sort_merge_pass(worker_pool, scratch.begin(), first, run_offsets, compare,
+                                             params);
+        } else {
+            detail::parallel_sort_merge_pass(worker_pool, first, scratch.begin(), run_offsets, compare,
+                                             params);
+        }
+        in_scratch = !in_scratch;
+    }
+
+    if (in_scratch) {
+        ScopedWorkContext context{worker_pool};
+
+        parallel_copy(context,                                   //
+                      std::make_move_iterator(scratch.begin()),  //
+                      std::make_move_iterator(scratch.end()),    //
+                      first,                                     //
+                      /*min_task_size=*/params.min_task_size,    //
+                      /*max_tasks=*/params.max_tasks);
+    }
+}
+
+// Sorts [first, last) using the threads of `worker_pool`, with the default WorkSliceParams for the pool.
+//
+template <typename Iter, typename Compare>
+void parallel_sort(WorkerPool& worker_pool, Iter first, Iter last, Compare&& compare)
+{
+    parallel_sort(worker_pool, first, last, BATT_FORWARD(compare),
+                  WorkSliceParams::from_worker_pool(worker_pool));
+}
+
+// Sorts [first, last) in ascending order using the threads of `worker_pool`.
+//
+template <typename Iter>
+void parallel_sort(WorkerPool& worker_pool, Iter first, Iter last)
+{
+    parallel_sort(worker_pool, first, last, std::less<>{});
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_ALGO_PARALLEL_SORT_HPP
@@ -0,0 +1,134 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022-2023 Anthony Paul Astolfi
+//
+#include <batteries/algo/parallel_sort.hpp>
+//
+#include <batteries/algo/parallel_sort.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. sort empty range
+//  2. sort range smaller than one task (no merging)
+//  3. sort large range of random elements
+//     a. default pool, default params
+//     b. null pool
+//     c. odd and even numbers of leaf runs
+//  4. custom comparator (descending)
+//  5. non-trivial value type (std::string)
+//
+
+using namespace batt::int_types;
+
+std::vector<u64> random_keys(usize count, usize seed, u64 max_key = ~u64{0})
+{
+    std::default_random_engine rng{seed};
+    std::uniform_int_distribution<u64> pick_key{0, max_key};
+
+    std::vector<u64> keys(count);
+    for (u64& key : keys) {
+        key = pick_key(rng);
+    }
+    return keys;
+}
+
+TEST(AlgoParallelSortTest, EmptyRange)
+{
+    std::vector<u64> keys;
+
+    batt::parallel_sort(batt::WorkerPool::default_pool(), keys.begin(), keys.end());
+
+    EXPECT_TRUE(keys.empty());
+}
+
+TEST(AlgoParallelSortTest, SingleTask)
+{
+    std::vector<u64> keys = random_keys(100, /*seed=*/1);
+    std::vector<u64> expected = keys;
+    std::sort(expected.begin(), expected.end());
+
+    batt::parallel_sort(batt::WorkerPool::default_pool(), keys.begin(), keys.end(), std::less<u64>{},
+                        batt::WorkSliceParams{batt::TaskSize{1000}, batt::TaskCount{8}});
+
+    EXPECT_THAT(keys, ::testing::ContainerEq(expected));
+}
+
+TEST(AlgoParallelSortTest, DefaultPool)
+{
+    for (usize seed = 0; seed < 10; ++seed) {
+        std::vector<u64> keys = random_keys(100 * 1000 + seed, seed);
+        std::vector<u64> expected = keys;
+        std::sort(expected.begin(), expected.end());
+
+        batt::parallel_sort(batt::WorkerPool::default_pool(), keys.begin(), keys.end());
+
+        EXPECT_THAT(keys, ::testing::ContainerEq(expected));
+    }
+}
+
+TEST(AlgoParallelSortTest, NullPool)
+{
+    std::vector<u64> keys = random_keys(50 * 1000, /*seed=*/2);
+    std::vector<u64> expected = keys;
+    std::sort(expected.begin(), expected.end());
+
+    batt::parallel_sort(batt::WorkerPool::null_pool(), keys.begin(), keys.end(), std::less<u64>{},
+                        batt::WorkSliceParams{batt::TaskSize{1000}, batt::TaskCount{16}});
+
+    EXPECT_THAT(keys, ::testing::ContainerEq(expected));
+}
+
+TEST(AlgoParallelSortTest, LeafRunCounts)
+{
+    // Use a small key range so there are many equal keys, and try every leaf run count from 2 to 17 (so the
+    // result ends up in either buffer, and some merge passes have an unpaired run).
+    //
+    for (usize n_tasks = 2; n_tasks <= 17; ++n_tasks) {
+        std::vector<u64> keys = random_keys(10 * 1000 + n_tasks, n_tasks, /*max_key=*/100);
+        std::vector<u64> expected = keys;
+        std::sort(expected.begin(), expected.end());
+
+        batt::parallel_sort(batt::WorkerPool::default_pool(), keys.begin(), keys.end(), std::less<u64>{},
+                            batt::WorkSliceParams{batt::TaskSize{64}, batt::TaskCount{n_tasks}});
+
+        EXPECT_THAT(keys, ::testing::ContainerEq(expected)) << BATT_INSPECT(n_tasks);
+    }
+}
+
+TEST(AlgoParallelSortTest, Descending)
+{
+    std::vector<u64> keys = random_keys(20 * 1000, /*seed=*/3);
+    std::vector<u64> expected = keys;
+    std::sort(expected.begin(), expected.end(), std::greater<u64>{});
+
+    batt::parallel_sort(batt::WorkerPool::default_pool(), keys.begin(), keys.end(), std::greater<u64>{},
+                        batt::WorkSliceParams{batt::TaskSize{256}, batt::TaskCount{8}});
+
+    EXPECT_THAT(keys, ::testing::ContainerEq(expected));
+}
+
+TEST(AlgoParallelSortTest, Strings)
+{
+    std::vector<std::string> strs;
+    for (u64 key : random_keys(20 * 1000, /*seed=*/4)) {
+        strs.emplace_back(std::to_string(key));
+    }
+    std::vector<std::string> expected = strs;
+    std::sort(expected.begin(), expected.end());
+
+    batt::parallel_sort(batt::WorkerPool::default_pool(), strs.begin(), strs.end(), std::less<>{},
+                        batt::WorkSliceParams{batt::TaskSize{256}, batt::TaskCount{7}});
+
+    EXPECT_THAT(strs, ::testing::ContainerEq(expected));
+}
+
+}  // namespace
@@ -225,6 +225,65 @@ class SeqBufferSource
     SmallVec<ConstBuffer, 2> active_buffers_;
 };
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// A BufferSource impl over an in-memory sequence of reference-counted SharedConstBuffer slices.
+//
+// Copying a SharedBufferSource never copies the data itself; each copy is an independent reader over the
+// same underlying storage.  This makes it cheap to hand the same bytes (e.g. an HttpData body) to several
+// consumers at once.
+//
+class SharedBufferSource
+{
+   public:
+    SharedBufferSource() = default;
+
+    explicit SharedBufferSource(const SharedConstBuffer& buffer) noexcept
+    {
+        this->append(buffer);
+    }
+
+    // Adds `buffer` to the end of the stream.
+    //
+    void append(const SharedConstBuffer& buffer)
+    {
+        if (buffer.size() != 0) {
+            this->size_ += buffer.size();
+            this->buffers_.emplace_back(buffer);
+        }
+    }
+
+    usize size() const
+    {
+        return this->size_;
+    }
+
+    StatusOr<SmallVec<ConstBuffer, 2>> fetch_at_least(i64 min_count)
+    {
+        if (this->size_ < BATT_CHECKED_CAST(usize, min_count) || (min_count != 0 && this->size_ == 0)) {
+            return {StatusCode::kEndOfStream};
+        }
+        return SmallVec<ConstBuffer, 2>(this->buffers_.begin(), this->buffers_.end());
+    }
+
+    void consume(i64 count)
+    {
+        BATT_CHECK_LE(BATT_CHECKED_CAST(usize, count), this->size_);
+
+        this->size_ -= count;
+        consume_buffers(this->buffers_, count);
+    }
+
+    void close_for_read()
+    {
+        this->buffers_.clear();
+        this->size_ = 0;
+    }
+
+   private:
+    SmallVec<SharedConstBuffer, 2> buffers_;
+    usize size_ = 0;
+};
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 // BufferSource | seq::take_n(byte_count)
 //
@@ -243,6 +302,13 @@ class TakeNSource
 
     StatusOr<SmallVec<ConstBuffer, 2>> fetch_at_least(i64 min_count)
     {
+        // Don't block waiting for data from `src_` past the limit; it may never come (e.g., the next message
+        // on a keep-alive connection).
+        //
+        if (this->limit_ == 0 && min_count > 0) {
+            return {StatusCode::kEndOfStream};
+        }
+
         StatusOr<SmallVec<ConstBuffer, 2>> buffers = this->src_.fetch_at_least(min_count);
         BATT_REQUIRE_OK(buffers);
 
@@ -292,11 +358,60 @@ TakeNSource<Src> operator|(Src&& src, seq::TakeNBinder binder)
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 // BufferSource | seq::skip_n(byte_count)
 //
+template <typename Src>
+class SkipNSource
+{
+   public:
+    explicit SkipNSource(Src&& src, usize n) noexcept : n_to_skip_{n}, src_{BATT_FORWARD(src)}
+    {
+    }
+
+    usize size() const
+    {
+        const usize src_size = this->src_.size();
+        return src_size > this->n_to_skip_ ? src_size - this->n_to_skip_ : 0;
+    }
+
+    StatusOr<SmallVec<ConstBuffer, 2>> fetch_at_least(i64 min_count)
+    {
+        // The skipped data is only consumed from `src_` once we need to look past it.
+        //
+        while (this->n_to_skip_ > 0) {
+            StatusOr<SmallVec<ConstBuffer, 2>> skipped = this->src_.fetch_at_least(1);
+            BATT_REQUIRE_OK(skipped);
+
+            const usize n_to_consume = std::min(boost::asio::buffer_size(*skipped), this->n_to_skip_);
+            if (n_to_consume == 0) {
+                return skipped;
+            }
+            this->src_.consume(BATT_CHECKED_CAST(i64, n_to_consume));
+            this->n_to_skip_ -= n_to_consume;
+        }
+
+        return this->src_.fetch_at_least(min_count);
+    }
+
+    void consume(i64 count)
+    {
+        BATT_CHECK(this->n_to_skip_ == 0 || count == 0) << "consume called before fetch_at_least!";
+
+        this->src_.consume(count);
+    }
+
+    void close_for_read()
+    {
+        this->src_.close_for_read();
+    }
+
+   private:
+    usize n_to_skip_;
+    Src src_;
+};
+
 template <typename Src, typename = EnableIfBufferSource<Src>>
-void operator|(Src&& src, SkipNBinder binder)
+SkipNSource<Src> operator|(Src&& src, SkipNBinder binder)
 {
-    // TODO [tastolfi 2022-03-23]
-    BATT_PANIC() << "TODO [tastolfi 2022-03-28] implement me!";
+    return SkipNSource<Src>{BATT_FORWARD(src), binder.n};
 }
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -321,6 +436,112 @@ class MapBufferSource
    private:
 };
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+namespace seq {
+
+template <typename Fn>
+struct InspectConsumedBinder {
+    Fn fn;
+};
+
+// Passes data through unchanged, invoking `fn(ConstBuffer)` exactly once on every byte, in stream order, as
+// it is consumed.
+//
+template <typename Fn>
+inline auto inspect_consumed(Fn&& fn)
+{
+    return InspectConsumedBinder<Fn>{BATT_FORWARD(fn)};
+}
+
+// Passes data through unchanged, calling `accumulator.update(ConstBuffer)` on all data as it is consumed;
+// e.g. to checksum a stream on its way through (see batt::Crc32c).
+//
+template <typename Accumulator>
+inline auto checksum(Accumulator& accumulator)
+{
+    return inspect_consumed([&accumulator](const ConstBuffer& buffer) {
+        accumulator.update(buffer);
+    });
+}
+
+}  // namespace seq
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// BufferSource | seq::inspect_consumed(void(ConstBuffer))
+//
+// Because `fetch_at_least` may return the same data many times, the inspect function is invoked from
+// `consume`, using the buffers most recently returned by `fetch_at_least` (no data is copied).
+//
+template <typename Src, typename Fn>
+class InspectBufferSource
+{
+   public:
+    explicit InspectBufferSource(Src&& src, Fn&& fn) noexcept : src_{BATT_FORWARD(src)}, fn_{BATT_FORWARD(fn)}
+    {
+    }
+
+    usize size() const
+    {
+        return this->src_.size();
+    }
+
+    StatusOr<SmallVec<ConstBuffer, 2>> fetch_at_least(i64 min_count)
+    {
+        StatusOr<SmallVec<ConstBuffer, 2>> fetched = this->src_.fetch_at_least(min_count);
+        BATT_REQUIRE_OK(fetched);
+
+        this->fetched_ = *fetched;
+
+        return fetched;
+    }
+
+    void consume(i64 count)
+    {
+        usize n_to_inspect = BATT_CHECKED_CAST(usize, count);
+
+        // If the caller is consuming data that it hasn't fetched, we must fetch it now so it can be
+        // inspected.
+        //
+        if (boost::asio::buffer_size(this->fetched_) < n_to_inspect) {
+            StatusOr<SmallVec<ConstBuffer, 2>> fetched = this->src_.fetch_at_least(count);
+            BATT_CHECK_OK(fetched) << "consume(count) called with count > available data";
+            this->fetched_ = std::move(*fetched);
+        }
+
+        for (const ConstBuffer& buffer : this->fetched_) {
+            if (n_to_inspect == 0) {
+                break;
+            }
+            const ConstBuffer prefix = resize_buffer(buffer, n_to_inspect);
+            this->fn_(prefix);
+            n_to_inspect -= prefix.size();
+        }
+
+        // The buffers returned by `fetch_at_least` are invalidated by `consume`.
+        //
+        this->fetched_.clear();
+        this->src_.consume(count);
+    }
+
+    void close_for_read()
+    {
+        this->fetched_.clear();
+        this->src_.close_for_read();
+    }
+
+   private:
+    Src src_;
+    Fn fn_;
+    SmallVec<ConstBuffer, 2> fetched_;
+};
+
+template <typename Src, typename Fn, typename = EnableIfBufferSource<Src>>
+inline InspectBufferSource<Src, Fn> operator|(Src&& src, seq::InspectConsumedBinder<Fn>&& binder)
+{
+    return InspectBufferSource<Src, Fn>{BATT_FORWARD(src), BATT_FORWARD(binder.fn)};
+}
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 // BufferSource | seq::for_each()
 //
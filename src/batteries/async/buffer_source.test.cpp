@@ -9,6 +9,7 @@
 #include <gtest/gtest.h>
 
 #include <batteries/async/stream_buffer.hpp>
+#include <batteries/crc32c.hpp>
 #include <batteries/seq/boxed.hpp>
 
 namespace {
@@ -53,8 +54,12 @@ TEST(BufferSourceTest, TakePrefix)
 
             auto data = sb_prefix.fetch_at_least(1);
 
-            ASSERT_TRUE(data.ok());
-            EXPECT_EQ(boost::asio::buffer_size(*data), std::min(prefix_size, kTestData.size()));
+            if (prefix_size == 0) {
+                EXPECT_EQ(data.status(), batt::StatusCode::kEndOfStream);
+            } else {
+                ASSERT_TRUE(data.ok());
+                EXPECT_EQ(boost::asio::buffer_size(*data), std::min(prefix_size, kTestData.size()));
+            }
 
             batt::StatusOr<std::vector<char>> bytes = sb_prefix | batt::seq::collect_vec();
 
@@ -65,6 +70,90 @@ TEST(BufferSourceTest, TakePrefix)
     }
 }
 
+// An AsyncWriteStream that appends everything written to it to a string, completing each write immediately.
+//
+struct StringWriteStream {
+    std::string data;
+
+    template <typename ConstBufferSequence, typename Handler>
+    void async_write_some(const ConstBufferSequence& buffers, Handler&& handler)
+    {
+        usize n_written = 0;
+        for (const batt::ConstBuffer& buffer : buffers) {
+            this->data.append(static_cast<const char*>(buffer.data()), buffer.size());
+            n_written += buffer.size();
+        }
+        BATT_FORWARD(handler)(batt::ErrorCode{}, n_written);
+    }
+};
+
+TEST(BufferSourceTest, TakePrefixWriteTo)
+{
+    // The source ends exactly at the limit.
+    {
+        batt::StreamBuffer sb{16};
+        ASSERT_TRUE(sb.write_all(batt::ConstBuffer{"hello", 5}).ok());
+        sb.close_for_write();
+
+        StringWriteStream dst;
+        batt::StatusOr<usize> n_written = sb | batt::seq::take_n(5) | batt::seq::write_to(dst);
+
+        ASSERT_TRUE(n_written.ok()) << BATT_INSPECT(n_written.status());
+        EXPECT_EQ(*n_written, 5u);
+        EXPECT_EQ(dst.data, "hello");
+    }
+
+    // More data follows the limit, and the source is still open (like a keep-alive connection); writing the
+    // prefix must not wait for the source to close.
+    {
+        batt::StreamBuffer sb{16};
+        ASSERT_TRUE(sb.write_all(batt::ConstBuffer{"hello world", 11}).ok());
+
+        StringWriteStream dst;
+        batt::StatusOr<usize> n_written = sb | batt::seq::take_n(5) | batt::seq::write_to(dst);
+
+        ASSERT_TRUE(n_written.ok()) << BATT_INSPECT(n_written.status());
+        EXPECT_EQ(*n_written, 5u);
+        EXPECT_EQ(dst.data, "hello");
+        EXPECT_EQ(sb.size(), 6u);
+    }
+}
+
+TEST(BufferSourceTest, SkipPrefix)
+{
+    constexpr usize kBufferSize = 16;
+    const std::string_view kTestData{"0123456789"};
+
+    for (usize offset = 0; offset < kBufferSize; ++offset) {
+        for (usize prefix_size = 0; prefix_size <= kTestData.size(); ++prefix_size) {
+            batt::StreamBuffer sb{kBufferSize};
+
+            if (offset > 0) {
+                ASSERT_TRUE(sb.prepare_exactly(offset).ok());
+                sb.commit(offset);
+                sb.consume(offset);
+            }
+
+            ASSERT_TRUE(sb.write_all(batt::ConstBuffer{kTestData.data(), kTestData.size()}).ok());
+
+            sb.close_for_write();
+
+            batt::BufferSource sb_suffix = sb | batt::skip_n(prefix_size);
+
+            // Nothing is consumed from the source until data is fetched.
+            //
+            EXPECT_EQ(sb.size(), kTestData.size());
+            EXPECT_EQ(sb_suffix.size(), kTestData.size() - prefix_size);
+
+            batt::StatusOr<std::vector<char>> bytes = sb_suffix | batt::seq::collect_vec();
+
+            ASSERT_TRUE(bytes.ok()) << BATT_INSPECT(bytes.status());
+            EXPECT_THAT((std::string_view{bytes->data(), bytes->size()}),
+                        ::testing::StrEq(kTestData.substr(prefix_size)));
+        }
+    }
+}
+
 TEST(BufferSourceTest, PrependBuffers)
 {
     batt::StreamBuffer rest{1024};
@@ -97,4 +186,96 @@ TEST(BufferSourceTest, PrependBuffersEndOfStream)
     EXPECT_EQ(fetched.status(), batt::StatusCode::kEndOfStream);
 }
 
+TEST(BufferSourceTest, SharedBufferSourceCopiesShareData)
+{
+    const std::string first_str = "All for one ";
+    const std::string second_str = "and one for all.";
+
+    batt::SharedConstBuffer first = batt::SharedConstBuffer::copy_of(batt::as_const_buffer(first_str));
+    batt::SharedConstBuffer second = batt::SharedConstBuffer::copy_of(batt::as_const_buffer(second_str));
+
+    batt::SharedBufferSource src{first};
+    src.append(second);
+
+    EXPECT_EQ(src.size(), first_str.size() + second_str.size());
+
+    batt::SharedBufferSource src_copy = src;
+    {
+        batt::StatusOr<batt::SmallVec<batt::ConstBuffer, 2>> fetched = src_copy.fetch_at_least(1);
+
+        ASSERT_TRUE(fetched.ok()) << BATT_INSPECT(fetched.status());
+        ASSERT_EQ(fetched->size(), 2u);
+        EXPECT_EQ((*fetched)[0].data(), first.data());
+        EXPECT_EQ((*fetched)[1].data(), second.data());
+    }
+
+    src_copy.consume(5);
+
+    batt::BufferSource erased_src = batt::SharedBufferSource{src};
+    batt::BufferSource erased_src_copy = batt::SharedBufferSource{src_copy};
+
+    batt::StatusOr<std::vector<char>> bytes = erased_src | batt::seq::collect_vec();
+    batt::StatusOr<std::vector<char>> copy_bytes = erased_src_copy | batt::seq::collect_vec();
+
+    ASSERT_TRUE(bytes.ok()) << bytes.status();
+    ASSERT_TRUE(copy_bytes.ok()) << copy_bytes.status();
+
+    EXPECT_THAT((std::string_view{bytes->data(), bytes->size()}), ::testing::StrEq(first_str + second_str));
+    EXPECT_THAT((std::string_view{copy_bytes->data(), copy_bytes->size()}),
+                ::testing::StrEq((first_str + second_str).substr(5)));
+
+    EXPECT_EQ(src_copy.fetch_at_least(src_copy.size() + 1).status(), batt::StatusCode::kEndOfStream);
+}
+
+TEST(BufferSourceTest, InspectConsumedChecksum)
+{
+    const std::string data = "Every byte that flows through here is checksummed exactly once.";
+
+    for (usize step : {1, 5, 16, 1000}) {
+        batt::StreamBuffer stream{1024};
+        ASSERT_TRUE(stream.write_all(batt::as_const_buffer(data)).ok());
+        stream.close_for_write();
+
+        batt::Crc32c crc;
+        auto src = stream | batt::seq::checksum(crc);
+
+        // Fetch repeatedly without consuming, then consume in irregular increments (sometimes without
+        // fetching first); each byte must be counted once.
+        //
+        usize consumed = 0;
+        while (consumed < data.size()) {
+            const usize n = std::min(step, data.size() - consumed);
+            if (consumed % 2 == 0) {
+                ASSERT_TRUE(src.fetch_at_least(1).ok());
+                ASSERT_TRUE(src.fetch_at_least(n).ok());
+            }
+            src.consume(n);
+            consumed += n;
+        }
+
+        EXPECT_EQ(src.fetch_at_least(1).status(), batt::StatusCode::kEndOfStream);
+        EXPECT_EQ(crc.value(), batt::crc32c(batt::as_const_buffer(data))) << BATT_INSPECT(step);
+    }
+}
+
+TEST(BufferSourceTest, InspectConsumedPassThrough)
+{
+    const std::string data = "Nothing to see here; move along.";
+
+    batt::StreamBuffer stream{1024};
+    ASSERT_TRUE(stream.write_all(batt::as_const_buffer(data)).ok());
+    stream.close_for_write();
+
+    std::string inspected;
+    batt::BufferSource src = stream | batt::seq::inspect_consumed([&inspected](const batt::ConstBuffer& b) {
+                                 inspected += batt::as_str(b);
+                             });
+
+    batt::StatusOr<std::vector<char>> bytes = src | batt::seq::collect_vec();
+
+    ASSERT_TRUE(bytes.ok()) << bytes.status();
+    EXPECT_THAT((std::string_view{bytes->data(), bytes->size()}), ::testing::StrEq(data));
+    EXPECT_THAT(inspected, ::testing::StrEq(data));
+}
+
 }  // namespace
@@ -0,0 +1,396 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_ASYNC_BUFFER_SOURCE_TEE_HPP
+#define BATTERIES_ASYNC_BUFFER_SOURCE_TEE_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/async/buffer_source.hpp>
+#include <batteries/async/watch.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/buffer.hpp>
+#include <batteries/checked_cast.hpp>
+#include <batteries/int_types.hpp>
+#include <batteries/optional.hpp>
+#include <batteries/shared_ptr.hpp>
+#include <batteries/small_vec.hpp>
+#include <batteries/status.hpp>
+#include <batteries/utility.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace batt {
+
+namespace detail {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// The state shared by all the readers created by a single call to `tee`.
+//
+// Data is pulled from the upstream source by whichever reader first needs it, copied exactly once into a
+// reference-counted block, and then handed out (without further copying) to every reader.  Blocks are
+// released as soon as the slowest reader has consumed past them.  The total amount of buffered data never
+// exceeds `max_buffered`, so a slow reader applies backpressure to the rest.
+//
+template <typename Src>
+class TeeBufferSourceState : public RefCounted<TeeBufferSourceState<Src>>
+{
+   public:
+    explicit TeeBufferSourceState(Src&& src, usize max_buffered) noexcept
+        : src_{BATT_FORWARD(src)}
+        , max_buffered_{max_buffered}
+    {
+    }
+
+    // Registers a new reader at stream position `pos`; returns the reader's index.
+    //
+    usize add_reader(i64 pos)
+    {
+        std::unique_lock<std::mutex> lock{this->mutex_};
+
+        for (usize i = 0; i < this->reader_pos_.size(); ++i) {
+            if (!this->reader_pos_[i]) {
+                this->reader_pos_[i] = pos;
+                return i;
+            }
+        }
+        this->reader_pos_.emplace_back(pos);
+        return this->reader_pos_.size() - 1;
+    }
+
+    // Creates a new reader at the same position as `reader_i`; returns the new reader's index.
+    //
+    usize fork_reader(usize reader_i)
+    {
+        i64 pos = 0;
+        {
+            std::unique_lock<std::mutex> lock{this->mutex_};
+            pos = *this->reader_pos_[reader_i];
+        }
+        return this->add_reader(pos);
+    }
+
+    // Removes the given reader, possibly releasing buffered data (and unblocking other readers waiting for
+    // buffer space).  When the last reader is removed, the upstream source is closed.
+    //
+    void remove_reader(usize reader_i)
+    {
+        bool close_src = false;
+        {
+            std::unique_lock<std::mutex> lock{this->mutex_};
+
+            this->reader_pos_[reader_i] = None;
+            this->trim_locked();
+            close_src = !this->pulling_ && this->no_readers_locked();
+        }
+        if (close_src) {
+            this->src_.close_for_read();
+        }
+        this->version_.fetch_add(1);
+    }
+
+    usize size(usize reader_i) const
+    {
+        std::unique_lock<std::mutex> lock{this->mutex_};
+
+        return BATT_CHECKED_CAST(usize, this->end_ - *this->reader_pos_[reader_i]);
+    }
+
+    StatusOr<SmallVec<ConstBuffer, 2>> fetch_at_least(usize reader_i, i64 min_count)
+    {
+        if (BATT_CHECKED_CAST(usize, min_count) > this->max_buffered_) {
+            // We could never satisfy this request without exceeding the buffer limit.
+            //
+            return {StatusCode::kInvalidArgument};
+        }
+
+        for (;;) {
+            std::unique_lock<std::mutex> lock{this->mutex_};
+
+            const i64 pos = *this->reader_pos_[reader_i];
+            if (this->end_ - pos >= min_count && (min_count != 0 || this->end_ != pos)) {
+                return this->collect_locked(pos);
+            }
+            if (!this->final_status_.ok()) {
+                return this->final_status_;
+            }
+
+            // Only one reader may pull from the upstream source at a time; if some other reader is doing so,
+            // or if there is no room to buffer more data, then wait for something to change.
+            //
+            const i64 space = BATT_CHECKED_CAST(i64, this->max_buffered_) - (this->end_ - this->min_pos_);
+            if (this->pulling_ || space <= 0) {
+                const i64 observed = this->version_.get_value();
+                lock.unlock();
+                BATT_REQUIRE_OK(this->version_.await_not_equal(observed));
+                continue;
+            }
+
+            this->pulling_ = true;
+            lock.unlock();
+
+            Status pull_status = this->pull(space);
+
+            bool close_src = false;
+            lock.lock();
+            this->pulling_ = false;
+            if (!pull_status.ok()) {
+                this->final_status_ = pull_status;
+            }
+            close_src = this->no_readers_locked();
+            lock.unlock();
+
+            if (close_src) {
+                this->src_.close_for_read();
+            }
+            this->version_.fetch_add(1);
+        }
+    }
+
+    void consume(usize reader_i, i64 count)
+    {
+        {
+            std::unique_lock<std::mutex> lock{this->mutex_};
+
+            i64& pos = *this->reader_pos_[reader_i];
+            BATT_CHECK_LE(pos + count, this->end_);
+            pos += count;
+            this->trim_locked();
+        }
+        this->version_.fetch_add(1);
+    }
+
+   private:
+    // Fetches up to `space` bytes from the upstream source and appends them to the shared chunk list.  Must
+    // only be called by the reader that set `pulling_`, with the mutex *unlocked*.
+    //
+    Status pull(i64 space)
+    {
+        StatusOr<SmallVec<ConstBuffer, 2>> fetched = this->src_.fetch_at_least(1);
+        BATT_REQUIRE_OK(fetched);
+
+        const usize n_to_copy = std::min(boost::asio::buffer_size(*fetched), BATT_CHECKED_CAST(usize, space));
+
+        SharedPtr<SharedBufferStorage> storage = SharedBufferStorage::allocate(n_to_copy);
+        boost::asio::buffer_copy(MutableBuffer{storage->data(), n_to_copy}, *fetched);
+        this->src_.consume(n_to_copy);
+
+        std::unique_lock<std::mutex> lock{this->mutex_};
+
+        this->chunks_.emplace_back(std::move(storage));
+        this->end_ += n_to_copy;
+        this->trim_locked();
+
+        return OkStatus();
+    }
+
+    SmallVec<ConstBuffer, 2> collect_locked(i64 pos) const
+    {
+        SmallVec<ConstBuffer, 2> buffers;
+        i64 chunk_begin = this->begin_;
+        for (const SharedConstBuffer& chunk : this->chunks_) {
+            const i64 chunk_end = chunk_begin + chunk.size();
+            if (pos < chunk_end) {
+                ConstBuffer buffer = chunk;
+                if (pos > chunk_begin) {
+                    buffer += (pos - chunk_begin);
+                }
+                buffers.emplace_back(buffer);
+            }
+            chunk_begin = chunk_end;
+        }
+        return buffers;
+    }
+
+    // Releases all chunks that have been fully consumed by every reader.
+    //
+    void trim_locked()
+    {
+        i64 min_pos = this->end_;
+        for (const Optional<i64>& pos : this->reader_pos_) {
+            if (pos) {
+                min_pos = std::min(min_pos, *pos);
+            }
+        }
+        this->min_pos_ = min_pos;
+
+        while (!this->chunks_.empty() && this->begin_ + i64(this->chunks_.front().size()) <= min_pos) {
+            this->begin_ += this->chunks_.front().size();
+            this->chunks_.pop_front();
+        }
+    }
+
+    bool no_readers_locked() const
+    {
+        return std::none_of(this->reader_pos_.begin(), this->reader_pos_.end(), [](const Optional<i64>& pos) {
+            return bool{pos};
+        });
+    }
+
+    // Only accessed by the reader currently pulling (see `pulling_`), or after all readers are gone.
+    //
+    Src src_;
+
+    const usize max_buffered_;
+
+    // Protects all the fields below, *except* `version_`.
+    //
+    mutable std::mutex mutex_;
+
+    // The buffered data, [begin_, end_) in absolute stream offsets.
+    //
+    std::deque<SharedConstBuffer> chunks_;
+    i64 begin_ = 0;
+    i64 end_ = 0;
+
+    // The position of the slowest active reader; used to calculate how much more data may be buffered.
+    //
+    i64 min_pos_ = 0;
+
+    // The current position of each reader; None if the reader has been closed.
+    //
+    std::vector<Optional<i64>> reader_pos_;
+
+    // True while some reader is fetching from `src_`.
+    //
+    bool pulling_ = false;
+
+    // The error status (usually kEndOfStream) returned by `src_` once it is exhausted.
+    //
+    Status final_status_;
+
+    // Incremented whenever data is added, consumed, or a reader is removed; used to wake blocked readers.
+    //
+    Watch<i64> version_{0};
+};
+
+}  // namespace detail
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// One of the readers created by `tee(src, n_readers)`.
+//
+// Each reader sees the entire stream of data produced by `src`, independently of the others.  Copying a
+// TeeBufferSource creates a new reader positioned at the same point in the stream as the original.
+//
+template <typename Src>
+class TeeBufferSource
+{
+   public:
+    using State = detail::TeeBufferSourceState<Src>;
+
+    static constexpr usize kDefaultMaxBuffered = 64 * 1024;
+
+    explicit TeeBufferSource(const SharedPtr<State>& state) noexcept
+        : state_{state}
+        , reader_i_{this->state_->add_reader(0)}
+    {
+    }
+
+    TeeBufferSource(const TeeBufferSource& that) noexcept
+        : state_{that.state_}
+        , reader_i_{this->state_ ? this->state_->fork_reader(that.reader_i_) : 0}
+    {
+    }
+
+    TeeBufferSource(TeeBufferSource&& that) noexcept
+        : state_{std::move(that.state_)}
+        , reader_i_{that.reader_i_}
+    {
+        that.state_ = nullptr;
+    }
+
+    TeeBufferSource& operator=(const TeeBufferSource& that)
+    {
+        TeeBufferSource copy{that};
+        return *this = std::move(copy);
+    }
+
+    TeeBufferSource& operator=(TeeBufferSource&& that) noexcept
+    {
+        if (this != &that) {
+            this->close_for_read();
+            this->state_ = std::move(that.state_);
+            this->reader_i_ = that.reader_i_;
+            that.state_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~TeeBufferSource() noexcept
+    {
+        this->close_for_read();
+    }
+
+    usize size() const
+    {
+        if (!this->state_) {
+            return 0;
+        }
+        return this->state_->size(this->reader_i_);
+    }
+
+    StatusOr<SmallVec<ConstBuffer, 2>> fetch_at_least(i64 min_count)
+    {
+        if (!this->state_) {
+            return {StatusCode::kClosed};
+        }
+        return this->state_->fetch_at_least(this->reader_i_, min_count);
+    }
+
+    void consume(i64 count)
+    {
+        if (this->state_) {
+            this->state_->consume(this->reader_i_, count);
+        }
+    }
+
+    void close_for_read()
+    {
+        if (this->state_) {
+            this->state_->remove_reader(this->reader_i_);
+            this->state_ = nullptr;
+        }
+    }
+
+   private:
+    SharedPtr<State> state_;
+    usize reader_i_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/*! \brief Splits a single BufferSource into `n_readers` independent BufferSources, each of which sees all
+ * the data produced by `src`.
+ *
+ * Data is copied out of `src` exactly once, no matter how many readers there are; all readers share the
+ * same reference-counted chunks.  At most `max_buffered` bytes are held at any one time, so the readers
+ * can only run ahead of the slowest reader by that much.  Consequently, `fetch_at_least(n)` on one of the
+ * readers fails with StatusCode::kInvalidArgument if `n > max_buffered`.
+ *
+ * The readers may be used concurrently from different Tasks.  When the last reader is closed or destroyed,
+ * `src.close_for_read()` is called.
+ */
+template <typename Src, typename = EnableIfBufferSource<Src>>
+inline std::vector<TeeBufferSource<Src>> tee(Src&& src, usize n_readers,
+                                             usize max_buffered = TeeBufferSource<Src>::kDefaultMaxBuffered)
+{
+    BATT_CHECK_GT(max_buffered, 0u);
+
+    auto state = make_shared<typename TeeBufferSource<Src>::State>(BATT_FORWARD(src), max_buffered);
+
+    std::vector<TeeBufferSource<Src>> readers;
+    readers.reserve(n_readers);
+    for (usize i = 0; i < n_readers; ++i) {
+        readers.emplace_back(state);
+    }
+    return readers;
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_ASYNC_BUFFER_SOURCE_TEE_HPP
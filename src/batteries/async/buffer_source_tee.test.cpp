@@ -0,0 +1,149 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/async/buffer_source_tee.hpp>
+//
+#include <batteries/async/buffer_source_tee.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <batteries/async/stream_buffer.hpp>
+#include <batteries/async/task.hpp>
+
+#include <boost/asio/io_context.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace batt::int_types;
+
+std::string make_test_data(usize size)
+{
+    std::string data;
+    data.reserve(size);
+    for (usize i = 0; i < size; ++i) {
+        data.push_back(char('a' + (i * 7 + i / 13) % 26));
+    }
+    return data;
+}
+
+TEST(BufferSourceTeeTest, AllReadersSeeAllData)
+{
+    const std::string test_data = make_test_data(5000);
+
+    for (usize n_readers : {1, 2, 3, 5}) {
+        for (usize max_buffered : {1, 17, 100, 8192}) {
+            boost::asio::io_context io;
+            batt::StreamBuffer input{256};
+
+            std::vector<batt::TeeBufferSource<batt::StreamBuffer&>> readers =
+                batt::tee(input, n_readers, max_buffered);
+
+            ASSERT_EQ(readers.size(), n_readers);
+
+            std::vector<batt::StatusOr<std::vector<char>>> results(n_readers);
+            std::vector<std::unique_ptr<batt::Task>> tasks;
+
+            for (usize i = 0; i < n_readers; ++i) {
+                tasks.emplace_back(std::make_unique<batt::Task>(io.get_executor(), [&, i] {
+                    // Make each reader consume in different sized increments, so they make progress at
+                    // different rates.
+                    //
+                    std::vector<char> bytes;
+                    const usize step = 1 + i * 3;
+                    for (;;) {
+                        batt::StatusOr<batt::SmallVec<batt::ConstBuffer, 2>> fetched =
+                            readers[i].fetch_at_least(1);
+                        if (fetched.status() == batt::StatusCode::kEndOfStream) {
+                            break;
+                        }
+                        ASSERT_TRUE(fetched.ok()) << BATT_INSPECT(fetched.status());
+
+                        const usize n = std::min(step, boost::asio::buffer_size(*fetched));
+                        bytes.resize(bytes.size() + n);
+                        boost::asio::buffer_copy(batt::MutableBuffer{bytes.data() + bytes.size() - n, n},
+                                                 *fetched);
+                        readers[i].consume(n);
+                        batt::Task::yield();
+                    }
+                    results[i] = std::move(bytes);
+                }));
+            }
+
+            batt::Task writer{io.get_executor(), [&] {
+                                  batt::Status status = input.write_all(batt::as_const_buffer(test_data));
+                                  ASSERT_TRUE(status.ok()) << status;
+                                  input.close_for_write();
+                              }};
+
+            io.run();
+
+            writer.join();
+            for (auto& task : tasks) {
+                task->join();
+            }
+
+            for (usize i = 0; i < n_readers; ++i) {
+                ASSERT_TRUE(results[i].ok()) << BATT_INSPECT(results[i].status());
+                EXPECT_THAT((std::string_view{results[i]->data(), results[i]->size()}),
+                            ::testing::StrEq(test_data))
+                    << BATT_INSPECT(i) << BATT_INSPECT(n_readers) << BATT_INSPECT(max_buffered);
+            }
+        }
+    }
+}
+
+TEST(BufferSourceTeeTest, SlowReaderLimitsBuffering)
+{
+    const std::string test_data = make_test_data(100);
+
+    batt::StreamBuffer input{256};
+    ASSERT_TRUE(input.write_all(batt::as_const_buffer(test_data)).ok());
+    input.close_for_write();
+
+    std::vector<batt::TeeBufferSource<batt::StreamBuffer&>> readers =
+        batt::tee(input, /*n_readers=*/2, /*max_buffered=*/32);
+
+    // Requests larger than the buffer limit can never be satisfied.
+    //
+    EXPECT_EQ(readers[0].fetch_at_least(33).status(), batt::StatusCode::kInvalidArgument);
+
+    batt::StatusOr<batt::SmallVec<batt::ConstBuffer, 2>> fetched = readers[0].fetch_at_least(32);
+    ASSERT_TRUE(fetched.ok()) << BATT_INSPECT(fetched.status());
+    EXPECT_EQ(boost::asio::buffer_size(*fetched), 32u);
+
+    // Nothing more can be pulled from upstream until the slow reader catches up.
+    //
+    readers[0].consume(32);
+    EXPECT_EQ(readers[0].size(), 0u);
+    EXPECT_EQ(readers[1].size(), 32u);
+    EXPECT_EQ(input.size(), test_data.size() - 32);
+
+    readers[1].consume(10);
+
+    fetched = readers[0].fetch_at_least(10);
+    ASSERT_TRUE(fetched.ok()) << BATT_INSPECT(fetched.status());
+    EXPECT_EQ(boost::asio::buffer_size(*fetched), 10u);
+    EXPECT_EQ(input.size(), test_data.size() - 42);
+
+    // Copying a reader forks a new reader at the same position.
+    //
+    batt::TeeBufferSource<batt::StreamBuffer&> fork = readers[1];
+    EXPECT_EQ(fork.size(), readers[1].size());
+
+    // Closing the slow readers removes their backpressure.
+    //
+    readers[1].close_for_read();
+    fork.close_for_read();
+
+    readers[0].consume(10);
+    batt::StatusOr<std::vector<char>> rest = readers[0] | batt::seq::collect_vec();
+
+    ASSERT_TRUE(rest.ok()) << BATT_INSPECT(rest.status());
+    EXPECT_THAT((std::string_view{rest->data(), rest->size()}), ::testing::StrEq(test_data.substr(42)));
+}
+
+}  // namespace
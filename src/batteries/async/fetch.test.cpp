@@ -371,4 +371,138 @@ TEST_F(AsyncFetchTest, TransferChunkedData)
     });
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+class FakeFetchStream
+{
+   public:
+    using Self = FakeFetchStream;
+
+    explicit FakeFetchStream(std::vector<std::string> chunks) noexcept : chunks_{std::move(chunks)}
+    {
+    }
+
+    batt::StatusOr<batt::BasicScopedChunk<Self>> fetch_chunk()
+    {
+        // Simulate I/O latency by yielding to other tasks.
+        //
+        batt::Task::yield();
+
+        if (this->next_ == this->chunks_.size()) {
+            return {boost::asio::error::eof};
+        }
+        const std::string& chunk = this->chunks_[this->next_];
+        return batt::BasicScopedChunk<Self>{
+            this, batt::ConstBuffer{chunk.data() + this->offset_, chunk.size() - this->offset_}};
+    }
+
+    void consume(usize count)
+    {
+        this->offset_ += count;
+        this->fetched_bytes += count;
+        if (this->offset_ == this->chunks_[this->next_].size()) {
+            this->next_ += 1;
+            this->offset_ = 0;
+        }
+    }
+
+    usize fetched_bytes = 0;
+
+   private:
+    std::vector<std::string> chunks_;
+    usize next_ = 0;
+    usize offset_ = 0;
+};
+
+class FakeWriteStream
+{
+   public:
+    explicit FakeWriteStream(const FakeFetchStream& src, usize max_write_size) noexcept
+        : src_{src}
+        , max_write_size_{max_write_size}
+    {
+    }
+
+    batt::StatusOr<usize> write(const batt::ConstBuffer& buffer)
+    {
+        batt::Task::yield();
+
+        if (this->fail_after && this->data.size() >= *this->fail_after) {
+            return {batt::StatusCode::kUnavailable};
+        }
+
+        const usize n = std::min(buffer.size(), this->max_write_size_);
+        this->data.append(static_cast<const char*>(buffer.data()), n);
+
+        // Track how far ahead the fetch side gets.  (The source is only told to consume a chunk once it has
+        // been entirely copied into the pipeline buffer, so this may be negative.)
+        //
+        this->max_lead = std::max(this->max_lead, (i64)this->src_.fetched_bytes - (i64)this->data.size());
+
+        return n;
+    }
+
+    std::string data;
+    i64 max_lead = 0;
+    batt::Optional<usize> fail_after;
+
+   private:
+    const FakeFetchStream& src_;
+    usize max_write_size_;
+};
+
+TEST_F(AsyncFetchTest, TransferChunkedDataPipelined)
+{
+    std::vector<std::string> chunks;
+    std::string expected;
+    for (usize i = 0; i < 50; ++i) {
+        chunks.emplace_back(std::string(10 + i, char('a' + i % 26)));
+        expected += chunks.back();
+    }
+
+    for (usize buffer_size : {16, 64, 4096}) {
+        FakeFetchStream src{chunks};
+        FakeWriteStream dst{src, /*max_write_size=*/7};
+
+        batt::StatusOr<usize> result;
+
+        this->run_test([&] {
+            result = batt::transfer_chunked_data_pipelined(src, dst, this->io_context.get_executor(),
+                                                           buffer_size);
+        });
+        this->io_context.restart();
+
+        ASSERT_TRUE(result.ok()) << BATT_INSPECT(result);
+        EXPECT_EQ(*result, expected.size());
+        EXPECT_THAT(dst.data, ::testing::StrEq(expected));
+
+        // The fetch side should run ahead of the write side (given enough room), but never by more than the
+        // buffer size.
+        //
+        if (buffer_size > expected.size()) {
+            EXPECT_GT(dst.max_lead, 7) << BATT_INSPECT(buffer_size);
+        }
+        EXPECT_LE(dst.max_lead, (i64)buffer_size) << BATT_INSPECT(buffer_size);
+    }
+}
+
+TEST_F(AsyncFetchTest, TransferChunkedDataPipelinedWriteError)
+{
+    std::vector<std::string> chunks(100, std::string(100, 'x'));
+
+    FakeFetchStream src{chunks};
+    FakeWriteStream dst{src, /*max_write_size=*/1000};
+    dst.fail_after = 500;
+
+    batt::StatusOr<usize> result;
+
+    this->run_test([&] {
+        result = batt::transfer_chunked_data_pipelined(src, dst, this->io_context.get_executor(), 256);
+    });
+
+    EXPECT_EQ(result.status(), batt::StatusCode::kUnavailable);
+    EXPECT_LT(src.fetched_bytes, 1000u);
+}
+
 }  // namespace
+
@@ -0,0 +1,394 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_ASYNC_FRAMED_RECORDS_HPP
+#define BATTERIES_ASYNC_FRAMED_RECORDS_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/async/buffer_source.hpp>
+#include <batteries/async/stream_buffer.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/buffer.hpp>
+#include <batteries/checked_cast.hpp>
+#include <batteries/int_types.hpp>
+#include <batteries/optional.hpp>
+#include <batteries/small_vec.hpp>
+#include <batteries/status.hpp>
+#include <batteries/utility.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+#include <array>
+#include <limits>
+
+namespace batt {
+
+// How the length of each record is encoded in front of the record data.
+//
+enum struct RecordLengthFormat {
+    // LEB128 (protobuf-style) unsigned varint, at most 5 bytes.
+    //
+    kVarint,
+
+    // Little-endian u32, always 4 bytes.
+    //
+    kFixedU32,
+};
+
+namespace detail {
+
+constexpr usize kMaxVarint32Size = 5;
+
+}  // namespace detail
+
+// Returns the number of bytes needed to encode a length prefix for a record of `record_size` bytes.
+//
+inline usize framed_record_header_size(RecordLengthFormat format, usize record_size)
+{
+    switch (format) {
+    case RecordLengthFormat::kFixedU32:
+        return sizeof(u32);
+
+    case RecordLengthFormat::kVarint: {
+        usize n = 1;
+        while (record_size >= 0x80) {
+            record_size >>= 7;
+            ++n;
+        }
+        return n;
+    }
+    }
+    BATT_PANIC() << "bad RecordLengthFormat: " << (int)format;
+    BATT_UNREACHABLE();
+}
+
+// Writes the length prefix for a record of `record_size` bytes to `dst`, which must be at least
+// `framed_record_header_size(format, record_size)` bytes.  Returns the number of bytes written.
+//
+inline usize encode_framed_record_header(RecordLengthFormat format, usize record_size, u8* dst)
+{
+    BATT_CHECK_LE(record_size, std::numeric_limits<u32>::max());
+
+    switch (format) {
+    case RecordLengthFormat::kFixedU32:
+        for (usize i = 0; i < sizeof(u32); ++i) {
+            dst[i] = (record_size >> (i * 8)) & 0xff;
+        }
+        return sizeof(u32);
+
+    case RecordLengthFormat::kVarint: {
+        usize n = 0;
+        while (record_size >= 0x80) {
+            dst[n++] = (record_size & 0x7f) | 0x80;
+            record_size >>= 7;
+        }
+        dst[n++] = record_size;
+        return n;
+    }
+    }
+    BATT_PANIC() << "bad RecordLengthFormat: " << (int)format;
+    BATT_UNREACHABLE();
+}
+
+// Writes a single length-prefixed record to `dst`, as a single commit.
+//
+inline Status write_framed_record(StreamBuffer& dst, const ConstBuffer& record, RecordLengthFormat format)
+{
+    std::array<u8, detail::kMaxVarint32Size> header;
+    const usize header_size = encode_framed_record_header(format, record.size(), header.data());
+
+    StatusOr<SmallVec<MutableBuffer, 2>> prepared = dst.prepare_exactly(header_size + record.size());
+    BATT_REQUIRE_OK(prepared);
+
+    boost::asio::buffer_copy(*prepared, std::array<ConstBuffer, 2>{
+                                            ConstBuffer{header.data(), header_size},
+                                            record,
+                                        });
+    dst.commit(header_size + record.size());
+
+    return OkStatus();
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Reads a stream of length-prefixed records from a BufferSource; models the Seq concept with Item type
+// ConstBuffer.
+//
+// Records are returned as views into the buffers returned by `Src::fetch_at_least`, so no data is copied as
+// long as each record is contiguous in the source.  (StreamBuffer guarantees this; other sources may split a
+// record across buffers, in which case it is gathered into an internal buffer.)  Consumption of records is
+// batched: the source is only told to `consume` when more data must be fetched, so a run of records that
+// were fetched together costs a single `consume` call.
+//
+// A ConstBuffer returned by `peek()` or `next()` is valid until the next call to `next()`.
+//
+// When `next()` returns None, `status()` tells why: StatusCode::kEndOfStream on a clean end of stream,
+// or some other error (e.g. StatusCode::kDataLoss if the stream ends in the middle of a record).
+//
+template <typename Src>
+class FramedRecordReader
+{
+   public:
+    using Item = ConstBuffer;
+
+    static constexpr usize kDefaultMaxRecordSize = 16 * 1024 * 1024;
+
+    explicit FramedRecordReader(Src&& src, RecordLengthFormat format,
+                                usize max_record_size = kDefaultMaxRecordSize) noexcept
+        : src_{BATT_FORWARD(src)}
+        , format_{format}
+        , max_record_size_{max_record_size}
+    {
+    }
+
+    FramedRecordReader(const FramedRecordReader&) = delete;
+    FramedRecordReader& operator=(const FramedRecordReader&) = delete;
+
+    ~FramedRecordReader() noexcept
+    {
+        this->consume_returned();
+    }
+
+    // The source from which records are read.
+    //
+    Src& source()
+    {
+        return this->src_;
+    }
+
+    Status status() const
+    {
+        return this->status_;
+    }
+
+    Optional<ConstBuffer> peek()
+    {
+        if (!this->peeked_) {
+            this->peeked_ = this->read_record(/*may_fetch=*/true);
+        }
+        return this->peeked_;
+    }
+
+    Optional<ConstBuffer> next()
+    {
+        Optional<ConstBuffer> record = this->peek();
+        if (record) {
+            this->cursor_ += this->peeked_size_;
+            this->peeked_ = None;
+        }
+        return record;
+    }
+
+    // Like `next()`, except that a record is only returned if it is entirely contained in data already
+    // fetched from the source; this never blocks, and returning None does not change `status()`.
+    //
+    Optional<ConstBuffer> next_buffered()
+    {
+        if (!this->peeked_) {
+            this->peeked_ = this->read_record(/*may_fetch=*/false);
+            if (!this->peeked_) {
+                return None;
+            }
+        }
+        return this->next();
+    }
+
+    // Consumes all records returned so far from the source (normally this is deferred until more data must
+    // be fetched).  Invalidates all previously returned records.
+    //
+    void consume_returned()
+    {
+        this->peeked_ = None;
+        this->fetched_.clear();
+        if (this->cursor_ != 0) {
+            this->src_.consume(this->cursor_);
+            this->cursor_ = 0;
+        }
+    }
+
+   private:
+    // Returns the number of fetched bytes past the cursor.
+    //
+    usize available() const
+    {
+        return boost::asio::buffer_size(this->fetched_) - this->cursor_;
+    }
+
+    // Makes sure that at least `min_count` bytes are available past the cursor, fetching more data from the
+    // source if necessary (and allowed).  On failure, sets `status_` and returns false.
+    //
+    bool ensure_available(usize min_count, bool may_fetch)
+    {
+        if (this->available() >= min_count) {
+            return true;
+        }
+        if (!may_fetch) {
+            return false;
+        }
+        this->consume_returned();
+
+        StatusOr<SmallVec<ConstBuffer, 2>> fetched = this->src_.fetch_at_least(min_count);
+        if (!fetched.ok()) {
+            this->status_ = fetched.status();
+            if (this->status_ == StatusCode::kEndOfStream && this->src_.fetch_at_least(1).ok()) {
+                // The stream ended in the middle of a record.
+                //
+                this->status_ = {StatusCode::kDataLoss};
+            }
+            return false;
+        }
+        this->fetched_ = std::move(*fetched);
+        return true;
+    }
+
+    // Returns the byte at offset `i` past the cursor; `i` must be less than `this->available()`.
+    //
+    u8 byte_at(usize i) const
+    {
+        i += this->cursor_;
+        for (const ConstBuffer& buffer : this->fetched_) {
+            if (i < buffer.size()) {
+                return static_cast<const u8*>(buffer.data())[i];
+            }
+            i -= buffer.size();
+        }
+        BATT_PANIC() << "byte_at: index out of range";
+        BATT_UNREACHABLE();
+    }
+
+    // Returns a contiguous view of the `count` bytes starting at `offset` past the cursor (which must be
+    // available), gathering them into `gather_buffer_` if they are split across buffers.
+    //
+    ConstBuffer contiguous(usize offset, usize count)
+    {
+        usize skip = this->cursor_ + offset;
+        for (const ConstBuffer& buffer : this->fetched_) {
+            if (skip < buffer.size()) {
+                if (buffer.size() - skip >= count) {
+                    return ConstBuffer{static_cast<const u8*>(buffer.data()) + skip, count};
+                }
+                break;
+            }
+            skip -= buffer.size();
+        }
+
+        this->gather_buffer_.resize(count);
+        boost::asio::buffer_copy(MutableBuffer{this->gather_buffer_.data(), count},
+                                 consume_buffers_copy(this->fetched_, this->cursor_ + offset));
+        return ConstBuffer{this->gather_buffer_.data(), count};
+    }
+
+    Optional<ConstBuffer> read_record(bool may_fetch)
+    {
+        if (!this->status_.ok()) {
+            return None;
+        }
+
+        // Parse the length prefix.
+        //
+        usize header_size = 0;
+        u64 record_size = 0;
+
+        switch (this->format_) {
+        case RecordLengthFormat::kFixedU32:
+            if (!this->ensure_available(sizeof(u32), may_fetch)) {
+                return None;
+            }
+            for (usize i = 0; i < sizeof(u32); ++i) {
+                record_size |= u64{this->byte_at(i)} << (i * 8);
+            }
+            header_size = sizeof(u32);
+            break;
+
+        case RecordLengthFormat::kVarint:
+            for (;;) {
+                if (header_size == detail::kMaxVarint32Size) {
+                    this->status_ = {StatusCode::kDataLoss};
+                    return None;
+                }
+                if (!this->ensure_available(header_size + 1, may_fetch)) {
+                    return None;
+                }
+                const u8 next_byte = this->byte_at(header_size);
+                record_size |= u64{next_byte & 0x7fu} << (header_size * 7);
+                header_size += 1;
+                if ((next_byte & 0x80) == 0) {
+                    break;
+                }
+            }
+            break;
+        }
+
+        if (record_size > this->max_record_size_) {
+            this->status_ = {StatusCode::kInvalidArgument};
+            return None;
+        }
+
+        // Make sure the entire record is available.
+        //
+        const usize frame_size = header_size + record_size;
+        if (!this->ensure_available(frame_size, may_fetch)) {
+            return None;
+        }
+
+        this->peeked_size_ = frame_size;
+        return this->contiguous(header_size, record_size);
+    }
+
+    Src src_;
+    const RecordLengthFormat format_;
+    const usize max_record_size_;
+
+    // The most recent result of `src_.fetch_at_least`.
+    //
+    SmallVec<ConstBuffer, 2> fetched_;
+
+    // The number of bytes at the front of `fetched_` that belong to records already returned by `next()`;
+    // these are consumed from `src_` in one go when more data is needed.
+    //
+    usize cursor_ = 0;
+
+    // The record returned by `peek()`, if any, and its size including the length prefix.
+    //
+    Optional<ConstBuffer> peeked_;
+    usize peeked_size_ = 0;
+
+    // Used to assemble records that span more than one fetched buffer.
+    //
+    SmallVec<u8, 256> gather_buffer_;
+
+    Status status_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+namespace seq {
+
+struct FramedRecordsBinder {
+    RecordLengthFormat format;
+    usize max_record_size;
+};
+
+inline FramedRecordsBinder framed_records(
+    RecordLengthFormat format,
+    usize max_record_size = FramedRecordReader<BufferSource>::kDefaultMaxRecordSize)
+{
+    return FramedRecordsBinder{format, max_record_size};
+}
+
+}  // namespace seq
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// BufferSource | seq::framed_records(format)
+//
+template <typename Src, typename = EnableIfBufferSource<Src>>
+inline FramedRecordReader<Src> operator|(Src&& src, seq::FramedRecordsBinder binder)
+{
+    return FramedRecordReader<Src>{BATT_FORWARD(src), binder.format, binder.max_record_size};
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_ASYNC_FRAMED_RECORDS_HPP
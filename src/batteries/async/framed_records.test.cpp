@@ -0,0 +1,244 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/async/framed_records.hpp>
+//
+#include <batteries/async/framed_records.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace batt::int_types;
+
+std::vector<std::string> make_test_records()
+{
+    std::vector<std::string> records;
+    for (usize size : {0, 1, 5, 127, 128, 200, 16383, 16384, 3, 0, 70}) {
+        std::string record;
+        for (usize i = 0; i < size; ++i) {
+            record.push_back(char('A' + (size + i) % 26));
+        }
+        records.emplace_back(std::move(record));
+    }
+    return records;
+}
+
+// A BufferSource wrapper that counts calls to `consume`.
+//
+template <typename Src>
+class CountConsumeSource
+{
+   public:
+    explicit CountConsumeSource(Src&& src, usize* consume_count) noexcept
+        : src_{BATT_FORWARD(src)}
+        , consume_count_{consume_count}
+    {
+    }
+
+    usize size() const
+    {
+        return this->src_.size();
+    }
+
+    batt::StatusOr<batt::SmallVec<batt::ConstBuffer, 2>> fetch_at_least(i64 min_count)
+    {
+        return this->src_.fetch_at_least(min_count);
+    }
+
+    void consume(i64 count)
+    {
+        *this->consume_count_ += 1;
+        this->src_.consume(count);
+    }
+
+    void close_for_read()
+    {
+        this->src_.close_for_read();
+    }
+
+   private:
+    Src src_;
+    usize* consume_count_;
+};
+
+TEST(FramedRecordsTest, HeaderEncoding)
+{
+    std::array<u8, 5> header;
+
+    EXPECT_EQ(batt::encode_framed_record_header(batt::RecordLengthFormat::kVarint, 0, header.data()), 1u);
+    EXPECT_EQ(header[0], 0u);
+
+    EXPECT_EQ(batt::encode_framed_record_header(batt::RecordLengthFormat::kVarint, 300, header.data()), 2u);
+    EXPECT_EQ(header[0], 0xacu);
+    EXPECT_EQ(header[1], 0x02u);
+
+    EXPECT_EQ(
+        batt::encode_framed_record_header(batt::RecordLengthFormat::kFixedU32, 0x01020304, header.data()),
+        4u);
+    EXPECT_THAT((std::vector<u8>(header.begin(), header.begin() + 4)), ::testing::ElementsAre(4, 3, 2, 1));
+
+    for (usize n : {0, 1, 127, 128, 16383, 16384, 2097151, 2097152}) {
+        EXPECT_EQ(batt::framed_record_header_size(batt::RecordLengthFormat::kVarint, n),
+                  batt::encode_framed_record_header(batt::RecordLengthFormat::kVarint, n, header.data()));
+    }
+}
+
+TEST(FramedRecordsTest, RoundTrip)
+{
+    const std::vector<std::string> records = make_test_records();
+
+    for (batt::RecordLengthFormat format :
+         {batt::RecordLengthFormat::kVarint, batt::RecordLengthFormat::kFixedU32}) {
+        batt::StreamBuffer stream{64 * 1024};
+
+        for (const std::string& record : records) {
+            ASSERT_TRUE(batt::write_framed_record(stream, batt::as_const_buffer(record), format).ok());
+        }
+        stream.close_for_write();
+
+        usize consume_count = 0;
+        {
+            auto reader = CountConsumeSource<batt::StreamBuffer&>{stream, &consume_count} |
+                          batt::seq::framed_records(format);
+
+            for (const std::string& expected : records) {
+                batt::Optional<batt::ConstBuffer> peeked = reader.peek();
+                batt::Optional<batt::ConstBuffer> record = reader.next();
+
+                ASSERT_TRUE(record) << BATT_INSPECT(reader.status());
+                ASSERT_TRUE(peeked);
+                EXPECT_EQ(peeked->data(), record->data());
+                EXPECT_THAT(batt::as_str(*record), ::testing::StrEq(expected));
+            }
+
+            EXPECT_FALSE(reader.next());
+            EXPECT_EQ(reader.status(), batt::StatusCode::kEndOfStream);
+        }
+
+        // All data was written before reading started, so all records should have been consumed in one go.
+        //
+        EXPECT_EQ(consume_count, 1u);
+        EXPECT_EQ(stream.size(), 0u);
+    }
+}
+
+TEST(FramedRecordsTest, RecordsSplitAcrossBuffers)
+{
+    const std::vector<std::string> records = make_test_records();
+
+    // Build a source whose buffers are very small, so most records (and some length prefixes) are split.
+    //
+    std::string encoded;
+    for (const std::string& record : records) {
+        std::array<u8, 5> header;
+        const usize header_size = batt::encode_framed_record_header(batt::RecordLengthFormat::kVarint,
+                                                                    record.size(), header.data());
+        encoded.append((const char*)header.data(), header_size);
+        encoded += record;
+    }
+
+    batt::SharedBufferSource src;
+    for (usize offset = 0; offset < encoded.size(); offset += 7) {
+        src.append(batt::SharedConstBuffer::copy_of(
+            batt::ConstBuffer{encoded.data() + offset, std::min<usize>(7, encoded.size() - offset)}));
+    }
+
+    auto reader = std::move(src) | batt::seq::framed_records(batt::RecordLengthFormat::kVarint);
+
+    for (const std::string& expected : records) {
+        batt::Optional<batt::ConstBuffer> record = reader.next();
+
+        ASSERT_TRUE(record) << BATT_INSPECT(reader.status());
+        EXPECT_THAT(batt::as_str(*record), ::testing::StrEq(expected));
+    }
+
+    EXPECT_FALSE(reader.next());
+    EXPECT_EQ(reader.status(), batt::StatusCode::kEndOfStream);
+}
+
+TEST(FramedRecordsTest, TruncatedRecord)
+{
+    batt::StreamBuffer stream{1024};
+
+    ASSERT_TRUE(batt::write_framed_record(stream, batt::as_const_buffer("complete"),
+                                          batt::RecordLengthFormat::kFixedU32)
+                    .ok());
+
+    const std::array<u8, 6> partial = {10, 0, 0, 0, 'x', 'y'};
+    ASSERT_TRUE(stream.write_all(batt::ConstBuffer{partial.data(), partial.size()}).ok());
+    stream.close_for_write();
+
+    auto reader = stream | batt::seq::framed_records(batt::RecordLengthFormat::kFixedU32);
+
+    batt::Optional<batt::ConstBuffer> record = reader.next();
+
+    ASSERT_TRUE(record);
+    EXPECT_THAT(batt::as_str(*record), ::testing::StrEq("complete"));
+    EXPECT_FALSE(reader.next());
+    EXPECT_EQ(reader.status(), batt::StatusCode::kDataLoss);
+}
+
+TEST(FramedRecordsTest, RecordTooLarge)
+{
+    batt::StreamBuffer stream{1024};
+
+    ASSERT_TRUE(batt::write_framed_record(stream, batt::as_const_buffer("0123456789"),
+                                          batt::RecordLengthFormat::kVarint)
+                    .ok());
+    stream.close_for_write();
+
+    auto reader =
+        stream | batt::seq::framed_records(batt::RecordLengthFormat::kVarint, /*max_record_size=*/9);
+
+    EXPECT_FALSE(reader.next());
+    EXPECT_EQ(reader.status(), batt::StatusCode::kInvalidArgument);
+}
+
+TEST(FramedRecordsTest, NextBufferedNeverBlocks)
+{
+    batt::StreamBuffer stream{1024};
+
+    ASSERT_TRUE(batt::write_framed_record(stream, batt::as_const_buffer("one"),
+                                          batt::RecordLengthFormat::kVarint)
+                    .ok());
+    ASSERT_TRUE(batt::write_framed_record(stream, batt::as_const_buffer("two"),
+                                          batt::RecordLengthFormat::kVarint)
+                    .ok());
+
+    // Only part of the third record is written.
+    //
+    const std::array<u8, 3> partial = {5, 't', 'h'};
+    ASSERT_TRUE(stream.write_all(batt::ConstBuffer{partial.data(), partial.size()}).ok());
+
+    auto reader = stream | batt::seq::framed_records(batt::RecordLengthFormat::kVarint);
+
+    // Nothing has been fetched yet.
+    //
+    EXPECT_FALSE(reader.next_buffered());
+
+    batt::Optional<batt::ConstBuffer> record = reader.next();
+    ASSERT_TRUE(record);
+    EXPECT_THAT(batt::as_str(*record), ::testing::StrEq("one"));
+
+    record = reader.next_buffered();
+    ASSERT_TRUE(record);
+    EXPECT_THAT(batt::as_str(*record), ::testing::StrEq("two"));
+
+    EXPECT_FALSE(reader.next_buffered());
+    EXPECT_TRUE(reader.status().ok());
+
+    ASSERT_TRUE(stream.write_all(batt::as_const_buffer("ree")).ok());
+    stream.close_for_write();
+
+    record = reader.next();
+    ASSERT_TRUE(record);
+    EXPECT_THAT(batt::as_str(*record), ::testing::StrEq("three"));
+}
+
+}  // namespace
+
@@ -218,6 +218,15 @@ class Mutex
         return ConstLock{*this};
     }
 
+    /** \brief Returns true iff the mutex is currently locked (or some task/thread is waiting to lock it).
+     * This is inherently racy; it is meant for diagnostics, not synchronization.
+     */
+    bool is_locked() const noexcept
+    {
+        const StatusOr<u64> current_ticket = this->current_ticket_.get_value();
+        return !current_ticket.ok() || *current_ticket != this->next_ticket_.load();
+    }
+
     /** \brief Performs the specified action by passing a reference to the protected object to the specified
      * action.
      *
@@ -59,7 +59,7 @@ class Pinnable
         // increase again (because of the self-pin acquired at construction time and released at destruction
         // time).
         //
-        BATT_CHECK_EQ(this->pin_count_.load(std::memory_order_release), 0);
+        BATT_CHECK_EQ(this->pin_count_.load(std::memory_order_acquire), 0);
     }
 
     void pin()
@@ -72,6 +72,13 @@ class Pinnable
         this->pin_count_.fetch_sub(1, std::memory_order_release);
     }
 
+    // Returns true iff there are pins on this object other than the self-pin.
+    //
+    bool is_pinned() const
+    {
+        return this->pin_count_.load(std::memory_order_acquire) > 1;
+    }
+
    private:
     // The pin count starts out as 1; this way we avoid A/B/A issues where the pin count drops down to zero
     // then goes back up.
@@ -201,6 +201,111 @@ class StreamBuffer
     Watch<i64> commit_pos_;
 };
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Wraps the producer (write) side of a StreamBuffer, invoking `fn(ConstBuffer)` exactly once on every byte,
+// in stream order, as it is committed.  Data is inspected in place within the StreamBuffer; nothing is
+// copied.
+//
+// Example (checksum all data written to a StreamBuffer):
+//
+// ```c++
+// batt::Crc32c crc;
+// auto writer = batt::inspect_writes(stream_buffer, [&crc](const batt::ConstBuffer& b) {
+//     crc.update(b);
+// });
+// writer.write_all(data);
+// ```
+//
+template <typename Fn>
+class InspectStreamBufferWriter
+{
+   public:
+    explicit InspectStreamBufferWriter(StreamBuffer& buffer, Fn&& fn) noexcept
+        : buffer_{buffer}
+        , fn_{BATT_FORWARD(fn)}
+    {
+    }
+
+    StreamBuffer& buffer() const
+    {
+        return this->buffer_;
+    }
+
+    usize space() const
+    {
+        return this->buffer_.space();
+    }
+
+    StatusOr<SmallVec<MutableBuffer, 2>> prepare_exactly(i64 exact_count)
+    {
+        StatusOr<SmallVec<MutableBuffer, 2>> prepared = this->buffer_.prepare_exactly(exact_count);
+        BATT_REQUIRE_OK(prepared);
+
+        this->prepared_ = *prepared;
+
+        return prepared;
+    }
+
+    StatusOr<SmallVec<MutableBuffer, 2>> prepare_at_least(i64 min_count)
+    {
+        StatusOr<SmallVec<MutableBuffer, 2>> prepared = this->buffer_.prepare_at_least(min_count);
+        BATT_REQUIRE_OK(prepared);
+
+        this->prepared_ = *prepared;
+
+        return prepared;
+    }
+
+    // `count` must not exceed the size of the buffers returned by the most recent call to `prepare_*`.
+    //
+    void commit(i64 count)
+    {
+        usize n_to_inspect = BATT_CHECKED_CAST(usize, count);
+        BATT_CHECK_LE(n_to_inspect, boost::asio::buffer_size(this->prepared_));
+
+        for (const MutableBuffer& buffer : this->prepared_) {
+            if (n_to_inspect == 0) {
+                break;
+            }
+            const ConstBuffer prefix = resize_buffer(buffer, n_to_inspect);
+            this->fn_(prefix);
+            n_to_inspect -= prefix.size();
+        }
+        this->prepared_.clear();
+        this->buffer_.commit(count);
+    }
+
+    Status write_all(ConstBuffer buffer)
+    {
+        while (buffer.size() > 0) {
+            StatusOr<SmallVec<MutableBuffer, 2>> prepared = this->prepare_at_least(1);
+            BATT_REQUIRE_OK(prepared);
+
+            const usize n_copied = boost::asio::buffer_copy(*prepared, buffer);
+            this->commit(n_copied);
+            buffer += n_copied;
+        }
+
+        return OkStatus();
+    }
+
+    void close_for_write()
+    {
+        this->buffer_.close_for_write();
+    }
+
+   private:
+    StreamBuffer& buffer_;
+    Fn fn_;
+    SmallVec<MutableBuffer, 2> prepared_;
+};
+
+template <typename Fn>
+inline InspectStreamBufferWriter<Fn> inspect_writes(StreamBuffer& buffer, Fn&& fn)
+{
+    return InspectStreamBufferWriter<Fn>{buffer, BATT_FORWARD(fn)};
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
 template <typename T>
@@ -5,10 +5,56 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <batteries/crc32c.hpp>
+
+#include <string>
+
 namespace {
 
+using namespace batt::int_types;
+
 TEST(AsyncStreamBufferTest, Test)
 {
 }
 
+TEST(AsyncStreamBufferTest, InspectWritesChecksum)
+{
+    // Use a small buffer so that writes wrap around the end.
+    //
+    batt::StreamBuffer stream{16};
+
+    batt::Crc32c write_crc;
+    auto writer = batt::inspect_writes(stream, [&write_crc](const batt::ConstBuffer& b) {
+        write_crc.update(b);
+    });
+
+    const std::string data = "Wrap around, wrap around, the data goes round and round.";
+    std::string received;
+
+    for (usize offset = 0; offset < data.size(); offset += 5) {
+        const usize n = std::min<usize>(5, data.size() - offset);
+        ASSERT_TRUE(writer.write_all(batt::ConstBuffer{data.data() + offset, n}).ok());
+
+        batt::StatusOr<batt::SmallVec<batt::ConstBuffer, 2>> fetched = stream.fetch_at_least(n);
+        ASSERT_TRUE(fetched.ok()) << BATT_INSPECT(fetched.status());
+        for (const batt::ConstBuffer& b : *fetched) {
+            received += batt::as_str(b);
+        }
+        stream.consume(boost::asio::buffer_size(*fetched));
+    }
+
+    // Committing less than was prepared only inspects the committed part.
+    //
+    batt::StatusOr<batt::SmallVec<batt::MutableBuffer, 2>> prepared = writer.prepare_at_least(4);
+    ASSERT_TRUE(prepared.ok());
+    boost::asio::buffer_copy(*prepared, batt::as_const_buffer("!!!!"));
+    writer.commit(1);
+    writer.close_for_write();
+
+    EXPECT_EQ(stream.size(), 1u);
+    EXPECT_THAT(received, ::testing::StrEq(data));
+    EXPECT_EQ(write_crc.value(), batt::crc32c(batt::as_const_buffer(data + "!")));
+}
+
 }  // namespace
+
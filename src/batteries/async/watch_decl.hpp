@@ -7,17 +7,40 @@
 
 #include <batteries/async/handler.hpp>
 #include <batteries/finally.hpp>
+#include <batteries/int_types.hpp>
 #include <batteries/optional.hpp>
 #include <batteries/seq/natural_order.hpp>
 #include <batteries/status.hpp>
 #include <batteries/type_traits.hpp>
 
+#include <atomic>
 #include <bitset>
 #include <mutex>
 #include <thread>
 
 namespace batt {
 
+/** \brief Process-wide counts of contention on the spin lock that protects the observer list of every
+ * WatchAtomic.
+ */
+struct WatchSpinStats {
+    /** \brief The number of times a thread found the lock held and had to spin.
+     */
+    std::atomic<u64> contended_locks{0};
+
+    /** \brief The total number of spin iterations (each one yields the thread).
+     */
+    std::atomic<u64> spins{0};
+};
+
+/** \brief Returns the process-wide WatchSpinStats.
+ */
+inline WatchSpinStats& watch_spin_stats()
+{
+    static WatchSpinStats instance_;
+    return instance_;
+}
+
 /**
  * A batt::Watch is like a `std::atomic` that you can block on, synchronously and asynchronously; see also
  * [batt::WatchAtomic](/_autogen/Classes/classbatt_1_1WatchAtomic).  Like `std::atomic`, it has methods to
@@ -699,12 +722,23 @@ class WatchAtomic
 
     u32 lock_observers() const
     {
+        u32 prior_state = this->spin_state_.fetch_or(kLocked);
+        if ((prior_state & kLocked) == 0) {
+            return prior_state;
+        }
+
+        // Only the contended path is counted, so this costs nothing when there is no contention.
+        //
+        WatchSpinStats& stats = watch_spin_stats();
+        stats.contended_locks.fetch_add(1, std::memory_order_relaxed);
         for (;;) {
-            const u32 prior_state = this->spin_state_.fetch_or(kLocked);
+            stats.spins.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::yield();
+
+            prior_state = this->spin_state_.fetch_or(kLocked);
             if ((prior_state & kLocked) == 0) {
                 return prior_state;
             }
-            std::this_thread::yield();
         }
     }
 
@@ -17,6 +17,8 @@
 #include <boost/asio/buffer.hpp>
 
 #include <array>
+#include <cstring>
+#include <memory>
 #include <string_view>
 #include <type_traits>
 
@@ -362,6 +364,126 @@ class MutableBufferView
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 
+/*! \brief A heap-allocated, reference-counted block of bytes of arbitrary (fixed) size; the backing storage
+ * for SharedConstBuffer.
+ */
+class SharedBufferStorage : public RefCounted<SharedBufferStorage>
+{
+   public:
+    /*! \brief Allocates a new block of `size` bytes; the contents are left uninitialized.
+     */
+    static SharedPtr<SharedBufferStorage> allocate(usize size)
+    {
+        return make_shared<SharedBufferStorage>(size);
+    }
+
+    explicit SharedBufferStorage(usize size) noexcept : size_{size}, data_{new char[size]}
+    {
+    }
+
+    char* data()
+    {
+        return this->data_.get();
+    }
+
+    const char* data() const
+    {
+        return this->data_.get();
+    }
+
+    usize size() const
+    {
+        return this->size_;
+    }
+
+   private:
+    usize size_;
+    std::unique_ptr<char[]> data_;
+};
+
+/*! \brief An immutable, reference-counted slice of a SharedBufferStorage block.
+ *
+ * Copying a SharedConstBuffer only touches a reference count; the underlying bytes are never copied, so the
+ * same data can be handed to any number of independent consumers.  The storage is released when the last
+ * slice referring to it goes away.
+ */
+class SharedConstBuffer
+{
+   public:
+    /*! \brief Returns a new SharedConstBuffer containing a copy of the bytes in `src`.
+     */
+    static SharedConstBuffer copy_of(const ConstBuffer& src)
+    {
+        SharedPtr<SharedBufferStorage> storage = SharedBufferStorage::allocate(src.size());
+        std::memcpy(storage->data(), src.data(), src.size());
+        return SharedConstBuffer{std::move(storage)};
+    }
+
+    SharedConstBuffer() = default;
+
+    explicit SharedConstBuffer(SharedPtr<SharedBufferStorage>&& storage) noexcept
+        : storage_{std::move(storage)}
+        , buffer_{this->storage_->data(), this->storage_->size()}
+    {
+    }
+
+    explicit SharedConstBuffer(SharedPtr<SharedBufferStorage>&& storage, usize offset, usize length) noexcept
+        : storage_{std::move(storage)}
+        , buffer_{this->storage_->data() + offset, length}
+    {
+        BATT_ASSERT_LE(offset + length, this->storage_->size());
+    }
+
+    operator ConstBuffer() const
+    {
+        return this->buffer_;
+    }
+
+    const void* data() const
+    {
+        return this->buffer_.data();
+    }
+
+    usize size() const
+    {
+        return this->buffer_.size();
+    }
+
+    SharedConstBuffer& operator+=(usize delta)
+    {
+        this->buffer_ += delta;
+        return *this;
+    }
+
+    /*! \brief Returns the block of storage into which this slice points.
+     */
+    const SharedPtr<SharedBufferStorage>& storage() const
+    {
+        return this->storage_;
+    }
+
+   private:
+    SharedPtr<SharedBufferStorage> storage_;
+    ConstBuffer buffer_;
+};
+
+/*! \brief Returns a SharedConstBuffer that is a slice of `b`, sharing the same storage.  The semantics of
+ * `slice` are identical to slice_buffer(const ConstBuffer&, const Interval<SizeT>&).
+ */
+template <typename SizeT>
+inline SharedConstBuffer slice_buffer(const SharedConstBuffer& b, const Interval<SizeT>& slice)
+{
+    const ConstBuffer sliced = slice_buffer(ConstBuffer{b}, slice);
+    if (!b.storage()) {
+        return SharedConstBuffer{};
+    }
+    const char* const base = b.storage()->data();
+    return SharedConstBuffer{SharedPtr<SharedBufferStorage>{b.storage()},
+                             usize(static_cast<const char*>(sliced.data()) - base), sliced.size()};
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 inline ConstBufferView::ConstBufferView(const MutableBufferView& other) noexcept : impl_{other.impl_}
@@ -477,6 +599,11 @@ inline ConstBuffer as_const_buffer(const char (&c_str)[kLength])
     return ConstBuffer{&c_str, kLength - 1};
 }
 
+inline ConstBuffer as_const_buffer(const SharedConstBuffer& buffer)
+{
+    return buffer;
+}
+
 }  // namespace batt
 
 #endif  // BATTERIES_BUFFER_HPP
@@ -149,4 +149,37 @@ TEST(BufferTest, AsConstBuffer)
     }
 }
 
+TEST(SharedConstBufferTest, CopyAndSlice)
+{
+    const std::string_view test_str = "The rain in Spain falls mainly on the plain.";
+
+    batt::SharedConstBuffer buffer = batt::SharedConstBuffer::copy_of(batt::as_const_buffer(test_str));
+
+    ASSERT_EQ(buffer.size(), test_str.size());
+    EXPECT_NE(buffer.data(), test_str.data());
+    EXPECT_THAT(batt::as_str(buffer), ::testing::StrEq(test_str));
+    EXPECT_EQ(buffer.storage()->use_count(), 1u);
+
+    batt::SharedConstBuffer copy = buffer;
+
+    EXPECT_EQ(copy.data(), buffer.data());
+    EXPECT_EQ(buffer.storage()->use_count(), 2u);
+
+    copy += 4;
+
+    EXPECT_THAT(batt::as_str(copy), ::testing::StrEq(test_str.substr(4)));
+
+    batt::SharedConstBuffer slice = batt::slice_buffer(copy, batt::Interval<usize>{5, 10});
+
+    EXPECT_EQ(slice.storage(), buffer.storage());
+    EXPECT_THAT(batt::as_str(slice), ::testing::StrEq("in Sp"));
+    EXPECT_EQ(buffer.storage()->use_count(), 3u);
+
+    buffer = batt::SharedConstBuffer{};
+    copy = batt::SharedConstBuffer{};
+
+    EXPECT_EQ(slice.storage()->use_count(), 1u);
+    EXPECT_THAT(batt::as_str(slice), ::testing::StrEq("in Sp"));
+}
+
 }  // namespace
@@ -17,6 +17,13 @@ namespace batt {
 
 #define BATT_SEQ_SPECIALIZE_ALGORITHMS 0
 
+// Define this preprocessor symbol to 1 to make BATT_LOCK_MUTEX collect per-call-site lock wait/hold time
+// metrics (see batteries/metrics/contention_metrics.hpp).
+//
+#ifndef BATT_MUTEX_CONTENTION_METRICS
+#define BATT_MUTEX_CONTENTION_METRICS 0
+#endif
+
 #if BATT_HEADER_ONLY
 #define BATT_INLINE_IMPL inline
 #else
@@ -0,0 +1,95 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_CRC32C_HPP
+#define BATTERIES_CRC32C_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/buffer.hpp>
+#include <batteries/int_types.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+namespace batt {
+
+/*! \brief Extends the CRC32C (Castagnoli) checksum `crc` with the given bytes, returning the new checksum.
+ *
+ * `crc` should be 0 for the first call; thereafter, passing the result of the previous call computes the
+ * checksum of the concatenation of all data passed so far.  Uses the SSE4.2 `crc32` instruction if the CPU
+ * supports it (detected at runtime), otherwise falls back to a portable table-driven implementation.
+ */
+u32 crc32c_extend(u32 crc, const void* data, usize size);
+
+/*! \brief The portable (non-SIMD) implementation of crc32c_extend; always available.
+ */
+u32 crc32c_extend_portable(u32 crc, const void* data, usize size);
+
+/*! \brief Returns true iff crc32c_extend uses hardware acceleration on this machine.
+ */
+bool crc32c_is_hardware_accelerated();
+
+/*! \brief Returns the CRC32C checksum of the passed data.
+ */
+inline u32 crc32c(const ConstBuffer& buffer)
+{
+    return crc32c_extend(0, buffer.data(), buffer.size());
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/*! \brief Incrementally computes the CRC32C checksum of a stream of data.
+ */
+class Crc32c
+{
+   public:
+    using value_type = u32;
+
+    Crc32c() = default;
+
+    explicit Crc32c(u32 initial_value) noexcept : value_{initial_value}
+    {
+    }
+
+    /*! \brief Adds the passed bytes to the end of the checksummed data.
+     */
+    void update(const ConstBuffer& buffer)
+    {
+        this->value_ = crc32c_extend(this->value_, buffer.data(), buffer.size());
+    }
+
+    /*! \brief Adds all the buffers in the passed ConstBufferSequence (in order) to the checksummed data.
+     */
+    template <typename ConstBufferSequence>
+    void update_all(const ConstBufferSequence& buffers)
+    {
+        auto first = boost::asio::buffer_sequence_begin(buffers);
+        auto last = boost::asio::buffer_sequence_end(buffers);
+        for (; first != last; ++first) {
+            this->update(ConstBuffer{*first});
+        }
+    }
+
+    /*! \brief The checksum of all data passed to `update` so far.
+     */
+    u32 value() const
+    {
+        return this->value_;
+    }
+
+    void reset()
+    {
+        this->value_ = 0;
+    }
+
+   private:
+    u32 value_ = 0;
+};
+
+}  // namespace batt
+
+#if BATT_HEADER_ONLY
+#include <batteries/crc32c_impl.hpp>
+#endif  // BATT_HEADER_ONLY
+
+#endif  // BATTERIES_CRC32C_HPP
@@ -0,0 +1,87 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/crc32c.hpp>
+//
+#include <batteries/crc32c.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace batt::int_types;
+
+// Test vectors from RFC 3720 (iSCSI), appendix B.4, plus the standard "check" value.
+//
+TEST(Crc32cTest, KnownValues)
+{
+    EXPECT_EQ(batt::crc32c(batt::as_const_buffer("")), 0u);
+    EXPECT_EQ(batt::crc32c(batt::as_const_buffer("123456789")), 0xe3069283u);
+
+    std::vector<u8> zeros(32, 0x00);
+    std::vector<u8> ones(32, 0xff);
+    std::vector<u8> ascending(32);
+    for (usize i = 0; i < ascending.size(); ++i) {
+        ascending[i] = i;
+    }
+
+    EXPECT_EQ(batt::crc32c(batt::as_const_buffer(zeros)), 0x8a9136aau);
+    EXPECT_EQ(batt::crc32c(batt::as_const_buffer(ones)), 0x62a8ab43u);
+    EXPECT_EQ(batt::crc32c(batt::as_const_buffer(ascending)), 0x46dd794eu);
+}
+
+TEST(Crc32cTest, IncrementalMatchesOneShot)
+{
+    std::default_random_engine rng{1};
+    std::uniform_int_distribution<int> pick_byte{0, 255};
+
+    std::vector<u8> data(4099);
+    for (u8& b : data) {
+        b = pick_byte(rng);
+    }
+
+    const u32 expected = batt::crc32c_extend_portable(0, data.data(), data.size());
+
+    EXPECT_EQ(batt::crc32c(batt::as_const_buffer(data)), expected);
+
+    // Try many different split points and alignments.
+    //
+    for (usize step : {1, 3, 7, 8, 13, 64, 1000}) {
+        batt::Crc32c crc;
+        for (usize offset = 0; offset < data.size(); offset += step) {
+            crc.update(batt::ConstBuffer{data.data() + offset, std::min(step, data.size() - offset)});
+        }
+        EXPECT_EQ(crc.value(), expected) << BATT_INSPECT(step);
+    }
+
+    for (usize offset = 0; offset < 16; ++offset) {
+        EXPECT_EQ(batt::crc32c_extend(0, data.data() + offset, data.size() - offset),
+                  batt::crc32c_extend_portable(0, data.data() + offset, data.size() - offset))
+            << BATT_INSPECT(offset) << BATT_INSPECT(batt::crc32c_is_hardware_accelerated());
+    }
+}
+
+TEST(Crc32cTest, UpdateAll)
+{
+    const std::string first = "The quick brown fox ";
+    const std::string second = "jumps over the lazy dog.";
+
+    std::vector<batt::ConstBuffer> buffers{batt::as_const_buffer(first), batt::as_const_buffer(second)};
+
+    batt::Crc32c crc;
+    crc.update_all(buffers);
+
+    EXPECT_EQ(crc.value(), batt::crc32c(batt::as_const_buffer(first + second)));
+
+    crc.reset();
+
+    EXPECT_EQ(crc.value(), 0u);
+}
+
+}  // namespace
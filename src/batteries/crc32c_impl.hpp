@@ -0,0 +1,144 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_CRC32C_IMPL_HPP
+#define BATTERIES_CRC32C_IMPL_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/crc32c.hpp>
+#include <batteries/hint.hpp>
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BATT_CRC32C_X86_DISPATCH 1
+#include <nmmintrin.h>
+#else
+#define BATT_CRC32C_X86_DISPATCH 0
+#endif
+
+namespace batt {
+namespace detail {
+
+// The reflected CRC32C (Castagnoli) polynomial.
+//
+constexpr u32 kCrc32cPolynomial = 0x82f63b78u;
+
+using Crc32cTables = std::array<std::array<u32, 256>, 8>;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+inline const Crc32cTables& crc32c_tables()
+{
+    // Tables for the "slicing-by-8" algorithm; table[k][b] is the CRC of byte `b` followed by `k` zero bytes.
+    //
+    static const Crc32cTables tables = [] {
+        Crc32cTables t;
+        for (u32 b = 0; b < 256; ++b) {
+            u32 crc = b;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (kCrc32cPolynomial & (0u - (crc & 1u)));
+            }
+            t[0][b] = crc;
+        }
+        for (u32 b = 0; b < 256; ++b) {
+            for (usize k = 1; k < t.size(); ++k) {
+                t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xff];
+            }
+        }
+        return t;
+    }();
+
+    return tables;
+}
+
+#if BATT_CRC32C_X86_DISPATCH
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+__attribute__((target("sse4.2"))) inline u32 crc32c_extend_sse42(u32 crc, const u8* p, usize n)
+{
+    u64 state = ~crc;
+
+    // Process leading bytes one at a time until `p` is 8-byte aligned.
+    //
+    while (n > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+        state = _mm_crc32_u8(static_cast<u32>(state), *p);
+        ++p;
+        --n;
+    }
+    while (n >= 8) {
+        u64 word;
+        std::memcpy(&word, p, sizeof(word));
+        state = _mm_crc32_u64(state, word);
+        p += 8;
+        n -= 8;
+    }
+    while (n > 0) {
+        state = _mm_crc32_u8(static_cast<u32>(state), *p);
+        ++p;
+        --n;
+    }
+
+    return ~static_cast<u32>(state);
+}
+#endif  // BATT_CRC32C_X86_DISPATCH
+
+}  // namespace detail
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL u32 crc32c_extend_portable(u32 crc, const void* data, usize size)
+{
+    const detail::Crc32cTables& t = detail::crc32c_tables();
+    const u8* p = static_cast<const u8*>(data);
+    u32 state = ~crc;
+
+    while (size >= 8) {
+        u32 lo, hi;
+        std::memcpy(&lo, p, sizeof(lo));
+        std::memcpy(&hi, p + 4, sizeof(hi));
+        lo ^= state;
+        state = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+                t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size > 0) {
+        state = (state >> 8) ^ t[0][(state ^ *p) & 0xff];
+        ++p;
+        --size;
+    }
+
+    return ~state;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL bool crc32c_is_hardware_accelerated()
+{
+#if BATT_CRC32C_X86_DISPATCH
+    static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+    return has_sse42;
+#else
+    return false;
+#endif
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL u32 crc32c_extend(u32 crc, const void* data, usize size)
+{
+#if BATT_CRC32C_X86_DISPATCH
+    if (BATT_HINT_TRUE(crc32c_is_hardware_accelerated())) {
+        return detail::crc32c_extend_sse42(crc, static_cast<const u8*>(data), size);
+    }
+#endif
+    return crc32c_extend_portable(crc, data, size);
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_CRC32C_IMPL_HPP
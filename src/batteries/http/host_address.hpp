@@ -15,11 +15,14 @@
 #include <batteries/stream_util.hpp>
 #include <batteries/utility.hpp>
 
+#include <boost/asio/generic/stream_protocol.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
 #include <boost/functional/hash.hpp>
 
 #include <string>
+#include <string_view>
 
 namespace batt {
 
@@ -33,6 +36,27 @@ struct HostAddress {
     friend usize hash_value(const HostAddress& host_key);
 };
 
+// The URL scheme for HTTP over a Unix domain (local stream) socket.  The HostAddress hostname is the path of
+// the socket; in a URL, it is given either as the percent-encoded host (e.g.
+// "unix://%2Fvar%2Frun%2Fapp.sock/v1/status"), or, if there is no host, as the path (e.g.
+// "unix:///var/run/app.sock", which requests "/").
+//
+inline constexpr std::string_view kUnixSocketScheme = "unix";
+
+// Returns true iff `host_address` names a Unix domain socket (see kUnixSocketScheme).
+//
+inline bool is_unix_socket(const HostAddress& host_address)
+{
+    return host_address.scheme == kUnixSocketScheme;
+}
+
+// The endpoint of a Unix domain socket address (see kUnixSocketScheme).
+//
+inline boost::asio::generic::stream_protocol::endpoint unix_socket_endpoint(const HostAddress& host_address)
+{
+    return boost::asio::local::stream_protocol::endpoint{host_address.hostname};
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 inline StatusOr<SmallVec<boost::asio::ip::tcp::endpoint>> await_resolve(
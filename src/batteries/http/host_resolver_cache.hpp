@@ -0,0 +1,161 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_HTTP_HOST_RESOLVER_CACHE_HPP
+#define BATTERIES_HTTP_HOST_RESOLVER_CACHE_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/http/host_address.hpp>
+
+#include <batteries/async/mutex.hpp>
+#include <batteries/async/queue.hpp>
+#include <batteries/async/task.hpp>
+#include <batteries/async/watch.hpp>
+
+#include <batteries/int_types.hpp>
+#include <batteries/optional.hpp>
+#include <batteries/shared_ptr.hpp>
+#include <batteries/small_fn.hpp>
+#include <batteries/small_vec.hpp>
+#include <batteries/status.hpp>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <chrono>
+#include <unordered_map>
+
+namespace batt {
+
+// Configuration for HostResolverCache.
+//
+struct HostResolverCacheOptions {
+    // How long a successful result may be returned from the cache.
+    //
+    std::chrono::steady_clock::duration ttl = std::chrono::seconds{60};
+
+    // How old a cached result must be before it is refreshed in the background; must not exceed `ttl`.
+    //
+    std::chrono::steady_clock::duration refresh_after = std::chrono::seconds{45};
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Caches the results of resolving HostAddress values to TCP endpoints.
+//
+// - Successful results are cached for `Options::ttl`.
+// - Once an entry is older than `Options::refresh_after`, the next lookup still returns the cached
+//   endpoints, but also schedules a refresh, which runs on a background task; so a host that is in regular
+//   use never makes its callers wait on the resolver again after the first lookup.
+// - Concurrent lookups of the same host that miss the cache are collapsed into a single resolver call
+//   (single-flight); all callers receive its result.  Failures are not cached.
+//
+// The Asio resolver does not report record TTLs, so the TTL is a fixed, configurable duration.
+//
+class HostResolverCache
+{
+   public:
+    using Clock = std::chrono::steady_clock;
+    using Endpoints = SmallVec<boost::asio::ip::tcp::endpoint>;
+    using ResolveFn = SmallFn<StatusOr<Endpoints>(const HostAddress&)>;
+
+    using Options = HostResolverCacheOptions;
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+    // Creates a cache that resolves hosts using an Asio resolver on `io`.
+    //
+    explicit HostResolverCache(boost::asio::io_context& io, const Options& options = Options{}) noexcept;
+
+    // Creates a cache that resolves hosts by calling `resolve_fn`; background refreshes run on `ex`.
+    //
+    explicit HostResolverCache(const boost::asio::any_io_executor& ex, ResolveFn&& resolve_fn,
+                               const Options& options = Options{}) noexcept;
+
+    HostResolverCache(const HostResolverCache&) = delete;
+    HostResolverCache& operator=(const HostResolverCache&) = delete;
+
+    // Calls `this->halt()` and `this->join()`.
+    //
+    ~HostResolverCache() noexcept;
+
+    // Returns the endpoints for `host_address`, from the cache if possible.
+    //
+    StatusOr<Endpoints> await_resolve(const HostAddress& host_address);
+
+    // Removes any cached result for `host_address`, so the next lookup goes to the resolver.
+    //
+    void invalidate(const HostAddress& host_address);
+
+    // Stops background refreshing.  Lookups still work after this, but stale entries are no longer
+    // refreshed before they expire.
+    //
+    void halt();
+
+    // Waits for the background refresh task (if any) to finish.
+    //
+    void join();
+
+   private:
+    // A resolver call shared by all the callers that missed the cache for the same host at the same time.
+    //
+    struct Lookup : RefCounted<Lookup> {
+        Watch<bool> done{false};
+        StatusOr<Endpoints> result{StatusCode::kUnknown};
+    };
+
+    struct Entry {
+        // The most recent successful result, if any.
+        //
+        Optional<Endpoints> endpoints;
+        Clock::time_point refresh_at;
+        Clock::time_point expires_at;
+
+        // Set while a blocking lookup for this host is in progress.
+        //
+        SharedPtr<Lookup> in_flight;
+
+        // Set while this host is waiting for/undergoing a background refresh.
+        //
+        bool refresh_pending = false;
+    };
+
+    using EntryMap = std::unordered_map<HostAddress, Entry, boost::hash<HostAddress>>;
+
+    // Stores a successful result in `entry`.
+    //
+    void update_entry(Entry& entry, const Endpoints& endpoints, Clock::time_point now);
+
+    // Must be called with `entries_` locked.
+    //
+    void schedule_refresh(Entry& entry, const HostAddress& host_address);
+
+    void refresh_task_main();
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+    boost::asio::any_io_executor executor_;
+
+    ResolveFn resolve_fn_;
+
+    const Options options_;
+
+    Mutex<EntryMap> entries_;
+
+    Queue<HostAddress> refresh_queue_;
+
+    // Started the first time a refresh is needed; protected by the lock on `entries_`.
+    //
+    Optional<Task> refresh_task_;
+};
+
+}  // namespace batt
+
+#endif  // BATTERIES_HTTP_HOST_RESOLVER_CACHE_HPP
+
+#if BATT_HEADER_ONLY
+#include <batteries/http/host_resolver_cache_impl.hpp>
+#endif  // BATT_HEADER_ONLY
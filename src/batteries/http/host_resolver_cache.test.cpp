@@ -0,0 +1,219 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/http/host_resolver_cache.hpp>
+//
+#include <batteries/http/host_resolver_cache.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/asio/executor_work_guard.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace batt::int_types;
+
+using Endpoints = batt::HostResolverCache::Endpoints;
+
+const batt::HostAddress kHost{"http", "example.test", batt::None};
+
+// Returns a single endpoint whose port number identifies the resolver call that produced it.
+//
+Endpoints make_endpoints(usize call_number)
+{
+    Endpoints endpoints;
+    endpoints.emplace_back(boost::asio::ip::make_address_v4("127.0.0.1"),
+                           BATT_CHECKED_CAST(u16, call_number));
+    return endpoints;
+}
+
+class HostResolverCacheTest : public ::testing::Test
+{
+   protected:
+    void TearDown() override
+    {
+        this->work_guard_ = batt::None;
+        this->io_thread_.join();
+    }
+
+    batt::HostResolverCache::ResolveFn counting_resolver()
+    {
+        return [this](const batt::HostAddress&) -> batt::StatusOr<Endpoints> {
+            const usize n = this->resolve_count_.fetch_add(1) + 1;
+            if (n <= this->fail_count_) {
+                return {batt::StatusCode::kUnavailable};
+            }
+            return make_endpoints(n);
+        };
+    }
+
+    std::atomic<usize> resolve_count_{0};
+    usize fail_count_ = 0;
+
+    boost::asio::io_context io_;
+
+    batt::Optional<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> work_guard_{
+        this->io_.get_executor()};
+
+    std::thread io_thread_{[this] {
+        this->io_.run();
+    }};
+};
+
+TEST_F(HostResolverCacheTest, ResultIsCached)
+{
+    batt::HostResolverCache cache{this->io_.get_executor(), this->counting_resolver()};
+
+    for (usize i = 0; i < 10; ++i) {
+        batt::StatusOr<Endpoints> result = cache.await_resolve(kHost);
+
+        ASSERT_TRUE(result.ok());
+        ASSERT_EQ(result->size(), 1u);
+        EXPECT_EQ(result->front().port(), 1u);
+    }
+    EXPECT_EQ(this->resolve_count_.load(), 1u);
+
+    // A different host is a different cache entry.
+    //
+    batt::StatusOr<Endpoints> other =
+        cache.await_resolve(batt::HostAddress{"http", "other.test", batt::None});
+
+    ASSERT_TRUE(other.ok());
+    EXPECT_EQ(other->front().port(), 2u);
+
+    cache.invalidate(kHost);
+
+    batt::StatusOr<Endpoints> after_invalidate = cache.await_resolve(kHost);
+
+    ASSERT_TRUE(after_invalidate.ok());
+    EXPECT_EQ(after_invalidate->front().port(), 3u);
+}
+
+TEST_F(HostResolverCacheTest, FailuresAreNotCached)
+{
+    this->fail_count_ = 1;
+
+    batt::HostResolverCache cache{this->io_.get_executor(), this->counting_resolver()};
+
+    batt::StatusOr<Endpoints> first = cache.await_resolve(kHost);
+
+    EXPECT_EQ(first.status(), batt::StatusCode::kUnavailable);
+
+    batt::StatusOr<Endpoints> second = cache.await_resolve(kHost);
+
+    ASSERT_TRUE(second.ok());
+    EXPECT_EQ(second->front().port(), 2u);
+}
+
+TEST_F(HostResolverCacheTest, ConcurrentMissesShareOneLookup)
+{
+    batt::Watch<bool> release_resolver{false};
+    std::atomic<usize> resolve_count{0};
+
+    batt::HostResolverCache cache{this->io_.get_executor(),
+                                  [&](const batt::HostAddress&) -> batt::StatusOr<Endpoints> {
+                                      resolve_count.fetch_add(1);
+                                      BATT_CHECK_OK(release_resolver.await_equal(true));
+                                      return make_endpoints(42);
+                                  }};
+
+    constexpr usize kThreadCount = 8;
+
+    std::atomic<usize> ok_count{0};
+    std::vector<std::thread> threads;
+    for (usize i = 0; i < kThreadCount; ++i) {
+        threads.emplace_back([&] {
+            batt::StatusOr<Endpoints> result = cache.await_resolve(kHost);
+            if (result.ok() && result->front().port() == 42) {
+                ok_count.fetch_add(1);
+            }
+        });
+    }
+
+    // Give all the threads a chance to pile up behind the first lookup.
+    //
+    while (resolve_count.load() == 0) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    release_resolver.set_value(true);
+
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(resolve_count.load(), 1u);
+    EXPECT_EQ(ok_count.load(), kThreadCount);
+}
+
+TEST_F(HostResolverCacheTest, StaleEntriesRefreshInBackground)
+{
+    batt::HostResolverCache::Options options;
+    options.ttl = std::chrono::seconds{60};
+    options.refresh_after = std::chrono::milliseconds{10};
+
+    batt::HostResolverCache cache{this->io_.get_executor(), this->counting_resolver(), options};
+
+    batt::StatusOr<Endpoints> first = cache.await_resolve(kHost);
+
+    ASSERT_TRUE(first.ok());
+    EXPECT_EQ(first->front().port(), 1u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // The entry is stale but not expired, so the cached result comes back immediately, and a refresh is
+    // started in the background.
+    //
+    batt::StatusOr<Endpoints> stale = cache.await_resolve(kHost);
+
+    ASSERT_TRUE(stale.ok());
+    EXPECT_EQ(stale->front().port(), 1u);
+
+    while (this->resolve_count_.load() < 2) {
+        std::this_thread::yield();
+    }
+
+    // Wait for the refreshed result to be published.
+    //
+    for (;;) {
+        batt::StatusOr<Endpoints> refreshed = cache.await_resolve(kHost);
+        ASSERT_TRUE(refreshed.ok());
+        if (refreshed->front().port() != 1u) {
+            EXPECT_EQ(refreshed->front().port(), 2u);
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    cache.halt();
+    cache.join();
+}
+
+TEST_F(HostResolverCacheTest, ExpiredEntriesResolveAgain)
+{
+    batt::HostResolverCache::Options options;
+    options.ttl = std::chrono::milliseconds{10};
+    options.refresh_after = std::chrono::milliseconds{10};
+
+    batt::HostResolverCache cache{this->io_.get_executor(), this->counting_resolver(), options};
+
+    batt::StatusOr<Endpoints> first = cache.await_resolve(kHost);
+
+    ASSERT_TRUE(first.ok());
+    EXPECT_EQ(first->front().port(), 1u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    batt::StatusOr<Endpoints> second = cache.await_resolve(kHost);
+
+    ASSERT_TRUE(second.ok());
+    EXPECT_EQ(second->front().port(), 2u);
+}
+
+}  // namespace
@@ -0,0 +1,197 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_HTTP_HOST_RESOLVER_CACHE_IMPL_HPP
+#define BATTERIES_HTTP_HOST_RESOLVER_CACHE_IMPL_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/http/host_resolver_cache.hpp>
+
+#include <batteries/assert.hpp>
+
+namespace batt {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL /*explicit*/ HostResolverCache::HostResolverCache(boost::asio::io_context& io,
+                                                                   const Options& options) noexcept
+    : HostResolverCache{io.get_executor(),
+                        [&io](const HostAddress& host_address) {
+                            return batt::await_resolve(io, host_address);
+                        },
+                        options}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL /*explicit*/ HostResolverCache::HostResolverCache(const boost::asio::any_io_executor& ex,
+                                                                   ResolveFn&& resolve_fn,
+                                                                   const Options& options) noexcept
+    : executor_{ex}
+    , resolve_fn_{std::move(resolve_fn)}
+    , options_{options}
+{
+    BATT_CHECK_LE(this->options_.refresh_after, this->options_.ttl);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL HostResolverCache::~HostResolverCache() noexcept
+{
+    this->halt();
+    this->join();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL auto HostResolverCache::await_resolve(const HostAddress& host_address) -> StatusOr<Endpoints>
+{
+    SharedPtr<Lookup> lookup;
+    {
+        auto locked_entries = this->entries_.lock();
+        Entry& entry = (*locked_entries)[host_address];
+
+        const Clock::time_point now = Clock::now();
+
+        if (entry.endpoints && now < entry.expires_at) {
+            if (now >= entry.refresh_at) {
+                this->schedule_refresh(entry, host_address);
+            }
+            return *entry.endpoints;
+        }
+
+        if (entry.in_flight) {
+            lookup = entry.in_flight;
+        } else {
+            entry.in_flight = batt::make_shared<Lookup>();
+        }
+    }
+
+    // Another caller is already resolving this host; wait for its result.
+    //
+    if (lookup) {
+        BATT_CHECK_OK(lookup->done.await_equal(true));
+        return lookup->result;
+    }
+
+    // This caller is the leader: call the resolver and publish the result to any followers.
+    //
+    StatusOr<Endpoints> result = this->resolve_fn_(host_address);
+    {
+        auto locked_entries = this->entries_.lock();
+        Entry& entry = (*locked_entries)[host_address];
+
+        if (result.ok()) {
+            this->update_entry(entry, *result, Clock::now());
+        }
+        std::swap(lookup, entry.in_flight);
+    }
+    lookup->result = result;
+    lookup->done.set_value(true);
+
+    return result;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void HostResolverCache::invalidate(const HostAddress& host_address)
+{
+    auto locked_entries = this->entries_.lock();
+
+    auto iter = locked_entries->find(host_address);
+    if (iter != locked_entries->end()) {
+        iter->second.endpoints = None;
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void HostResolverCache::halt()
+{
+    this->refresh_queue_.close();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void HostResolverCache::join()
+{
+    // Once the queue is closed, `refresh_task_` can no longer be started; so it is safe to join it outside
+    // the lock (which the task itself needs in order to finish).
+    //
+    BATT_CHECK(this->refresh_queue_.is_closed());
+
+    Task* task = nullptr;
+    {
+        auto locked_entries = this->entries_.lock();
+        if (this->refresh_task_) {
+            task = &*this->refresh_task_;
+        }
+    }
+    if (task) {
+        task->join();
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void HostResolverCache::update_entry(Entry& entry, const Endpoints& endpoints,
+                                                      Clock::time_point now)
+{
+    entry.endpoints = endpoints;
+    entry.refresh_at = now + this->options_.refresh_after;
+    entry.expires_at = now + this->options_.ttl;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void HostResolverCache::schedule_refresh(Entry& entry, const HostAddress& host_address)
+{
+    if (entry.refresh_pending || entry.in_flight) {
+        return;
+    }
+    if (!this->refresh_queue_.push(host_address)) {
+        return;
+    }
+    entry.refresh_pending = true;
+
+    if (!this->refresh_task_) {
+        this->refresh_task_.emplace(
+            this->executor_,
+            [this] {
+                this->refresh_task_main();
+            },
+            "HostResolverCache::refresh_task");
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void HostResolverCache::refresh_task_main()
+{
+    for (;;) {
+        StatusOr<HostAddress> host_address = this->refresh_queue_.await_next();
+        if (!host_address.ok()) {
+            break;
+        }
+
+        StatusOr<Endpoints> result = this->resolve_fn_(*host_address);
+
+        auto locked_entries = this->entries_.lock();
+        Entry& entry = (*locked_entries)[*host_address];
+
+        entry.refresh_pending = false;
+
+        // On failure, keep serving the old result until it expires.
+        //
+        if (result.ok()) {
+            this->update_entry(entry, *result, Clock::now());
+        }
+    }
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_HTTP_HOST_RESOLVER_CACHE_IMPL_HPP
@@ -9,11 +9,35 @@
 //
 #include <batteries/async/buffer_source.hpp>
 #include <batteries/async/stream_buffer.hpp>
+#include <batteries/http/http_data.hpp>
 
-#include <batteries/pico_http/parser.hpp>
+#include <batteries/assert.hpp>
+#include <batteries/buffer.hpp>
+#include <batteries/checked_cast.hpp>
+#include <batteries/finally.hpp>
+#include <batteries/int_types.hpp>
+#include <batteries/small_vec.hpp>
+#include <batteries/status.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+#include <cstring>
 
 namespace batt {
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Decodes an HTTP/1.1 "Transfer-Encoding: chunked" body from `Src`; models the BufferSource concept.
+//
+// The decoder is incremental: each byte of the source is examined at most once, and the decoder state
+// between fetches is constant-size (where it is within the current chunk), regardless of how the source
+// data is split across fetches.  Chunk payloads are never copied or scanned; the buffers returned by
+// `fetch_at_least` are views into the buffers returned by `Src::fetch_at_least`.  Only the chunk-size lines,
+// the CRLFs that follow each chunk, and the trailer (if any) are scanned, using `memchr` (which is
+// vectorized by the C library) to find line ends.
+//
+// Source data is consumed as soon as the corresponding decoded data is consumed, so a slow reader never
+// holds more framing bytes in the source than it has payload bytes outstanding.
+//
 template <typename Src>
 class HttpChunkDecoder
 {
@@ -21,11 +45,8 @@ class HttpChunkDecoder
     explicit HttpChunkDecoder(Src&& src,
                               IncludeHttpTrailer consume_trailer = IncludeHttpTrailer{false}) noexcept
         : src_{BATT_FORWARD(src)}
+        , consume_trailer_{consume_trailer}
     {
-        std::memset(&this->decoder_checkpoint_, 0, sizeof(pico_http::ChunkedDecoder));
-        this->decoder_checkpoint_.consume_trailer = consume_trailer;
-
-        this->decoder_latest_ = this->decoder_checkpoint_;
     }
 
     // The current number of bytes available as consumable data.
@@ -39,7 +60,7 @@ class HttpChunkDecoder
     //
     bool done() const
     {
-        return this->done_;
+        return this->state_ == State::kDone;
     }
 
     // Returns a ConstBufferSequence containing at least `min_count` bytes of data.
@@ -54,18 +75,25 @@ class HttpChunkDecoder
         // Keep decoding chunks from the src stream until we have at least the minimum amount of bytes.
         //
         while (this->size() < min_count) {
-            if (this->done_) {
+            if (this->done()) {
                 if (this->size() == 0) {
                     this->release_decoded_chunks();
                 }
                 return {StatusCode::kEndOfStream};
             }
 
-            const i64 src_min_count = BATT_CHECKED_CAST(i64, this->decoded_src_size_) +
-                                      (min_count_i - BATT_CHECKED_CAST(i64, this->size()));
+            // Each decoded byte needs at least one more source byte, so ask for that many; if the source ends
+            // before then, retry for just one more byte so that any remaining framing (e.g. the last chunk)
+            // is still decoded.
+            //
+            const usize n_scanned = this->scan_pos_ - this->src_pos_;
+            const usize n_wanted = n_scanned + (min_count - this->size());
 
-            auto fetched = this->src_.fetch_at_least(src_min_count);
-            if (!fetched.ok() && fetched.status() == StatusCode::kEndOfStream && !this->done_) {
+            StatusOr<SmallVec<ConstBuffer, 2>> fetched = this->src_.fetch_at_least(n_wanted);
+            if (fetched.status() == StatusCode::kEndOfStream && n_wanted > n_scanned + 1) {
+                fetched = this->src_.fetch_at_least(n_scanned + 1);
+            }
+            if (fetched.status() == StatusCode::kEndOfStream) {
                 if (this->size() == 0) {
                     this->release_decoded_chunks();
                 }
@@ -73,45 +101,25 @@ class HttpChunkDecoder
             }
             BATT_REQUIRE_OK(fetched);
 
-            this->decoded_src_size_ = 0;
-            this->decoded_chunks_.clear();
-            this->decoder_latest_ = this->decoder_checkpoint_;
-
-            usize n_to_consume_from_src = 0;
+            this->fetched_ = std::move(*fetched);
 
-            const auto on_loop_exit = finally([&] {
-                if (n_to_consume_from_src > 0) {
-                    this->consume_from_src(n_to_consume_from_src);
+            // Decode only the bytes that have not been seen before.
+            //
+            usize skip = n_scanned;
+            for (const ConstBuffer& src_buffer : this->fetched_) {
+                if (skip >= src_buffer.size()) {
+                    skip -= src_buffer.size();
+                    continue;
                 }
-                this->output_available_ = boost::asio::buffer_size(this->decoded_chunks_);
-            });
-
-            for (ConstBuffer src_buffer : *fetched) {
-                StatusOr<pico_http::DecodeResult> result =
-                    pico_http::decode_chunked(&this->decoder_latest_, src_buffer, &this->decoded_chunks_);
-
-                BATT_REQUIRE_OK(result);
-
-                this->decoded_src_size_ += result->bytes_consumed;
-
-                if (this->output_consumed_ != 0) {
-                    const usize decoded_size = boost::asio::buffer_size(this->decoded_chunks_);
-                    if (this->output_consumed_ >= decoded_size) {
-                        this->output_consumed_ -= decoded_size;
-                        this->decoded_chunks_.clear();
-                        this->decoder_checkpoint_ = this->decoder_latest_;
-                        n_to_consume_from_src += result->bytes_consumed;
-                    }
-                }
-
-                if (result->done) {
-                    this->done_ = true;
+                BATT_REQUIRE_OK(this->decode(src_buffer + skip));
+                skip = 0;
+                if (this->done()) {
                     break;
                 }
             }
         }
 
-        return consume_buffers_copy(this->decoded_chunks_, this->output_consumed_);
+        return this->decoded_buffers();
     }
 
     // Consume the specified number of bytes from the front of the stream so that future calls to
@@ -119,13 +127,32 @@ class HttpChunkDecoder
     //
     void consume(i64 count)
     {
-        this->output_consumed_ += count;
+        this->output_consumed_ += BATT_CHECKED_CAST(usize, count);
 
         BATT_CHECK_LE(this->output_consumed_, this->output_available_);
 
         if (this->output_consumed_ == this->output_available_) {
             this->release_decoded_chunks();
+            return;
+        }
+
+        // Drop the segments that have been consumed entirely, then release the source data up to the first
+        // unconsumed payload byte.
+        //
+        usize n_dropped = 0;
+        while (this->output_consumed_ >= this->segments_[n_dropped].size()) {
+            this->output_consumed_ -= this->segments_[n_dropped].size();
+            this->output_available_ -= this->segments_[n_dropped].size();
+            ++n_dropped;
         }
+        this->segments_.erase(this->segments_.begin(), this->segments_.begin() + n_dropped);
+
+        Segment& first = this->segments_.front();
+        first.begin += this->output_consumed_;
+        this->output_available_ -= this->output_consumed_;
+        this->output_consumed_ = 0;
+
+        this->consume_from_src(first.begin);
     }
 
     // Unblocks any current and future calls to `prepare_at_least` (and all other fetch/read methods).  This
@@ -137,31 +164,257 @@ class HttpChunkDecoder
     }
 
    private:
+    enum struct State : u8 {
+        kChunkSize,
+        kChunkExt,
+        kChunkData,
+        kChunkCrlf,
+        kTrailerLineHead,
+        kTrailerLineMiddle,
+        kDone,
+    };
+
+    // A decoded payload range [begin, end), in source stream offsets.
+    //
+    struct Segment {
+        usize begin;
+        usize end;
+
+        usize size() const
+        {
+            return this->end - this->begin;
+        }
+    };
+
+    static int decode_hex(char ch)
+    {
+        if ('0' <= ch && ch <= '9') {
+            return ch - '0';
+        } else if ('A' <= ch && ch <= 'F') {
+            return ch - 'A' + 0xa;
+        } else if ('a' <= ch && ch <= 'f') {
+            return ch - 'a' + 0xa;
+        } else {
+            return -1;
+        }
+    }
+
+    // Runs the decoder over `input`, which must be the source data at `this->scan_pos_`.  Stops at the end of
+    // `input` or when the terminating chunk (and trailer, if requested) has been decoded.
+    //
+    Status decode(const ConstBuffer& input)
+    {
+        const char* const begin = static_cast<const char*>(input.data());
+        const char* const end = begin + input.size();
+        const char* p = begin;
+
+        const auto on_return = finally([&] {
+            this->scan_pos_ += (p - begin);
+        });
+
+        // Advances `p` to just past the next LF; returns false if there isn't one in the input.
+        //
+        const auto skip_line = [&p, end]() -> bool {
+            const void* lf = std::memchr(p, '\n', end - p);
+            if (!lf) {
+                p = end;
+                return false;
+            }
+            p = static_cast<const char*>(lf) + 1;
+            return true;
+        };
+
+        for (;;) {
+            switch (this->state_) {
+            case State::kChunkSize:
+                for (;; ++p) {
+                    if (p == end) {
+                        return OkStatus();
+                    }
+                    const int v = decode_hex(*p);
+                    if (v < 0) {
+                        if (this->hex_count_ == 0) {
+                            return {StatusCode::kInvalidArgument};
+                        }
+                        break;
+                    }
+                    if (this->hex_count_ == sizeof(usize) * 2) {
+                        return {StatusCode::kInvalidArgument};
+                    }
+                    this->bytes_left_in_chunk_ = this->bytes_left_in_chunk_ * 16 + v;
+                    ++this->hex_count_;
+                }
+                this->hex_count_ = 0;
+                this->state_ = State::kChunkExt;
+                // fall-through
+            case State::kChunkExt:
+                // RFC 7230 A.2 "Line folding in chunk extensions is disallowed"
+                //
+                if (!skip_line()) {
+                    return OkStatus();
+                }
+                if (this->bytes_left_in_chunk_ == 0) {
+                    if (this->consume_trailer_) {
+                        this->state_ = State::kTrailerLineHead;
+                        break;
+                    }
+                    this->state_ = State::kDone;
+                    return OkStatus();
+                }
+                this->state_ = State::kChunkData;
+                // fall-through
+            case State::kChunkData: {
+                const usize n = std::min<usize>(end - p, this->bytes_left_in_chunk_);
+                if (n > 0) {
+                    this->add_segment(this->scan_pos_ + (p - begin), n);
+                    p += n;
+                    this->bytes_left_in_chunk_ -= n;
+                }
+                if (this->bytes_left_in_chunk_ != 0) {
+                    return OkStatus();
+                }
+                this->state_ = State::kChunkCrlf;
+            }
+                // fall-through
+            case State::kChunkCrlf:
+                for (;; ++p) {
+                    if (p == end) {
+                        return OkStatus();
+                    }
+                    if (*p != '\r') {
+                        break;
+                    }
+                }
+                if (*p != '\n') {
+                    return {StatusCode::kInvalidArgument};
+                }
+                ++p;
+                this->state_ = State::kChunkSize;
+                break;
+
+            case State::kTrailerLineHead:
+                for (;; ++p) {
+                    if (p == end) {
+                        return OkStatus();
+                    }
+                    if (*p != '\r') {
+                        break;
+                    }
+                }
+                if (*p++ == '\n') {
+                    this->state_ = State::kDone;
+                    return OkStatus();
+                }
+                this->state_ = State::kTrailerLineMiddle;
+                // fall-through
+            case State::kTrailerLineMiddle:
+                if (!skip_line()) {
+                    return OkStatus();
+                }
+                this->state_ = State::kTrailerLineHead;
+                break;
+
+            case State::kDone:
+                return OkStatus();
+            }
+        }
+    }
+
+    void add_segment(usize begin, usize size)
+    {
+        if (!this->segments_.empty() && this->segments_.back().end == begin) {
+            this->segments_.back().end += size;
+        } else {
+            this->segments_.emplace_back(Segment{begin, begin + size});
+        }
+        this->output_available_ += size;
+    }
+
+    // Returns views of the unconsumed decoded data, which is contained in `this->fetched_`.
+    //
+    SmallVec<ConstBuffer, 2> decoded_buffers() const
+    {
+        SmallVec<ConstBuffer, 2> result;
+
+        auto src_iter = this->fetched_.begin();
+        usize src_iter_pos = this->src_pos_;
+
+        usize skip = this->output_consumed_;
+        for (const Segment& segment : this->segments_) {
+            if (skip >= segment.size()) {
+                skip -= segment.size();
+                continue;
+            }
+            usize pos = segment.begin + skip;
+            skip = 0;
+
+            // The segment may span more than one source buffer.
+            //
+            while (pos < segment.end) {
+                while (pos >= src_iter_pos + src_iter->size()) {
+                    src_iter_pos += src_iter->size();
+                    ++src_iter;
+                    BATT_CHECK_NE(src_iter, this->fetched_.end());
+                }
+                const usize n = std::min(segment.end, src_iter_pos + src_iter->size()) - pos;
+                result.emplace_back(
+                    ConstBuffer{static_cast<const u8*>(src_iter->data()) + (pos - src_iter_pos), n});
+                pos += n;
+            }
+        }
+
+        return result;
+    }
+
     void release_decoded_chunks()
     {
         this->output_available_ = 0;
         this->output_consumed_ = 0;
-        this->decoded_chunks_.clear();
-        this->decoder_checkpoint_ = this->decoder_latest_;
-        this->consume_from_src(this->decoded_src_size_);
+        this->segments_.clear();
+        this->consume_from_src(this->scan_pos_);
     }
 
-    void consume_from_src(usize count)
+    // Consumes source data up to stream offset `pos`.
+    //
+    void consume_from_src(usize pos)
     {
-        this->decoded_src_size_ -= count;
+        BATT_CHECK_LE(pos, this->scan_pos_);
+
+        const usize count = pos - this->src_pos_;
+        if (count == 0) {
+            return;
+        }
+        this->src_pos_ = pos;
+        consume_buffers(this->fetched_, count);
         this->src_.consume(count);
     }
 
     //+++++++++++-+-+--+----- --- -- -  -  -   -
 
     Src src_;
-    pico_http::ChunkedDecoder decoder_checkpoint_;
-    pico_http::ChunkedDecoder decoder_latest_;
-    bool done_ = false;
-    usize decoded_src_size_ = 0;
+    const bool consume_trailer_;
+
+    // Decoder state.
+    //
+    State state_ = State::kChunkSize;
+    usize bytes_left_in_chunk_ = 0;
+    u8 hex_count_ = 0;
+
+    // The stream offsets of the first unconsumed byte in `src_`, and of the first byte not yet decoded.
+    //
+    usize src_pos_ = 0;
+    usize scan_pos_ = 0;
+
+    // The buffers most recently returned by `src_.fetch_at_least`, minus any data consumed since; these start
+    // at `src_pos_`.
+    //
+    SmallVec<ConstBuffer, 2> fetched_;
+
+    // The decoded payload data not yet consumed, in stream order.
+    //
+    SmallVec<Segment, 4> segments_;
     usize output_available_ = 0;
     usize output_consumed_ = 0;
-    SmallVec<ConstBuffer, 4> decoded_chunks_;
 };
 
 static_assert(has_buffer_source_requirements<HttpChunkDecoder<StreamBuffer&>>(), "");
@@ -0,0 +1,181 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/http/http_chunk_decoder.hpp>
+//
+#include <batteries/http/http_chunk_decoder.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace batt::int_types;
+
+std::string buffers_to_string(const batt::SmallVec<batt::ConstBuffer, 2>& buffers)
+{
+    std::string s;
+    for (const batt::ConstBuffer& b : buffers) {
+        s.append(static_cast<const char*>(b.data()), b.size());
+    }
+    return s;
+}
+
+std::string encode_chunked(const std::vector<std::string>& chunks, const std::string& trailer)
+{
+    std::string encoded;
+    for (const std::string& chunk : chunks) {
+        std::ostringstream oss;
+        oss << std::hex << chunk.size();
+        encoded += oss.str();
+        if (chunk.size() % 3 == 0) {
+            encoded += ";ext=value";
+        }
+        encoded += "\r\n" + chunk + "\r\n";
+    }
+    encoded += "0\r\n" + trailer;
+    return encoded;
+}
+
+// Decodes `encoded` while it is written in pieces of `step` bytes, reading `read_size` bytes at a time.
+//
+std::string decode_trickled(const std::string& encoded, usize step, usize read_size,
+                            batt::IncludeHttpTrailer include_trailer, batt::StreamBuffer& stream,
+                            batt::Status* final_status)
+{
+    batt::HttpChunkDecoder<batt::StreamBuffer&> decoder{stream, include_trailer};
+
+    std::string decoded;
+    usize offset = 0;
+    for (;;) {
+        // Top up the stream, leaving it open until all data has been written.
+        //
+        while (offset < encoded.size() && stream.space() > 0) {
+            const usize n = std::min({step, encoded.size() - offset, stream.space()});
+            BATT_CHECK_OK(stream.write_all(batt::ConstBuffer{encoded.data() + offset, n}));
+            offset += n;
+        }
+        if (offset == encoded.size()) {
+            stream.close_for_write();
+        }
+
+        const usize n_to_fetch = std::min<usize>(read_size, std::max<usize>(decoder.size(), 1));
+        batt::StatusOr<batt::SmallVec<batt::ConstBuffer, 2>> fetched = decoder.fetch_at_least(n_to_fetch);
+        if (!fetched.ok()) {
+            *final_status = fetched.status();
+            return decoded;
+        }
+        const std::string data = buffers_to_string(*fetched);
+        const usize n_to_consume = std::min(data.size(), read_size);
+        decoded += data.substr(0, n_to_consume);
+        decoder.consume(n_to_consume);
+    }
+}
+
+TEST(HttpChunkDecoderTest, RandomizedSplits)
+{
+    std::default_random_engine rng{1};
+
+    for (usize trial = 0; trial < 200; ++trial) {
+        std::vector<std::string> chunks;
+        std::string expected;
+        const usize n_chunks = std::uniform_int_distribution<usize>{0, 8}(rng);
+        for (usize i = 0; i < n_chunks; ++i) {
+            std::string chunk(std::uniform_int_distribution<usize>{1, 300}(rng), 'a' + (i % 26));
+            chunk[0] = '\r';
+            chunk.back() = '\n';
+            expected += chunk;
+            chunks.emplace_back(std::move(chunk));
+        }
+
+        for (bool include_trailer : {false, true}) {
+            const std::string encoded =
+                encode_chunked(chunks, include_trailer ? "X-Checksum: abc\r\nX-Other: 1\r\n\r\n" : "");
+
+            const usize step = std::uniform_int_distribution<usize>{1, 64}(rng);
+            const usize read_size = std::uniform_int_distribution<usize>{1, 100}(rng);
+
+            batt::StreamBuffer stream{std::uniform_int_distribution<usize>{64, 256}(rng)};
+            batt::Status final_status;
+
+            const std::string decoded = decode_trickled(encoded, step, read_size,
+                                                        batt::IncludeHttpTrailer{include_trailer}, stream,
+                                                        &final_status);
+
+            EXPECT_EQ(final_status, batt::StatusCode::kEndOfStream);
+            EXPECT_EQ(decoded, expected)
+                << BATT_INSPECT(trial) << BATT_INSPECT(step) << BATT_INSPECT(read_size);
+
+            // All of the encoded data (including the trailer, if requested) has been consumed.
+            //
+            EXPECT_EQ(stream.size(), 0u);
+        }
+    }
+}
+
+TEST(HttpChunkDecoderTest, PayloadIsNotCopied)
+{
+    batt::StreamBuffer stream{1024};
+    ASSERT_TRUE(stream.write_all(batt::as_const_buffer("5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n")).ok());
+    stream.close_for_write();
+
+    batt::StatusOr<batt::SmallVec<batt::ConstBuffer, 2>> raw = stream.fetch_at_least(1);
+    ASSERT_TRUE(raw.ok());
+    const char* const raw_data = static_cast<const char*>(raw->front().data());
+
+    batt::HttpChunkDecoder<batt::StreamBuffer&> decoder{stream};
+
+    batt::StatusOr<batt::SmallVec<batt::ConstBuffer, 2>> fetched = decoder.fetch_at_least(11);
+    ASSERT_TRUE(fetched.ok());
+    ASSERT_EQ(fetched->size(), 2u);
+    EXPECT_EQ(fetched->at(0).data(), raw_data + 3);
+    EXPECT_EQ(fetched->at(1).data(), raw_data + 13);
+    EXPECT_THAT(buffers_to_string(*fetched), ::testing::StrEq("hello world"));
+
+    // Consuming part of the payload releases the framing (and payload) bytes before it.
+    //
+    decoder.consume(7);
+    EXPECT_EQ(stream.size(), 26u - (3 + 5 + 2 + 3 + 2));
+
+    fetched = decoder.fetch_at_least(1);
+    ASSERT_TRUE(fetched.ok());
+    EXPECT_THAT(buffers_to_string(*fetched), ::testing::StrEq("orld"));
+    decoder.consume(4);
+
+    EXPECT_EQ(decoder.fetch_at_least(1).status(), batt::StatusCode::kEndOfStream);
+    EXPECT_TRUE(decoder.done());
+}
+
+TEST(HttpChunkDecoderTest, Errors)
+{
+    for (const char* input : {"zz\r\n", "5\r\nhelloXX\r\n", "11111111111111111\r\n"}) {
+        batt::StreamBuffer stream{1024};
+        ASSERT_TRUE(stream.write_all(batt::ConstBuffer{input, std::strlen(input)}).ok());
+        stream.close_for_write();
+
+        batt::HttpChunkDecoder<batt::StreamBuffer&> decoder{stream};
+        EXPECT_EQ(decoder.fetch_at_least(6).status(), batt::StatusCode::kInvalidArgument) << input;
+    }
+    {
+        batt::StreamBuffer stream{1024};
+        ASSERT_TRUE(stream.write_all(batt::as_const_buffer("5\r\nhel")).ok());
+        stream.close_for_write();
+
+        batt::HttpChunkDecoder<batt::StreamBuffer&> decoder{stream};
+
+        batt::StatusOr<batt::SmallVec<batt::ConstBuffer, 2>> fetched = decoder.fetch_at_least(1);
+        ASSERT_TRUE(fetched.ok());
+        EXPECT_THAT(buffers_to_string(*fetched), ::testing::StrEq("hel"));
+
+        EXPECT_EQ(decoder.fetch_at_least(4).status(), batt::StatusCode::kClosedBeforeEndOfStream);
+    }
+}
+
+}  // namespace
@@ -8,11 +8,14 @@
 #include <batteries/config.hpp>
 //
 #include <batteries/http/host_address.hpp>
+#include <batteries/http/host_resolver_cache.hpp>
 #include <batteries/http/http_client_connection_decl.hpp>
 #include <batteries/http/http_client_host_context_decl.hpp>
 #include <batteries/http/http_data.hpp>
 #include <batteries/http/http_header.hpp>
+#include <batteries/http/http_object_pool.hpp>
 #include <batteries/http/http_request.hpp>
+#include <batteries/http/http_request_hedge.hpp>
 #include <batteries/http/http_response.hpp>
 #include <batteries/http/http_version.hpp>
 
@@ -26,6 +29,7 @@
 #include <batteries/case_of.hpp>
 #include <batteries/optional.hpp>
 #include <batteries/small_fn.hpp>
+#include <batteries/small_vec.hpp>
 #include <batteries/status.hpp>
 #include <batteries/url_parse.hpp>
 
@@ -33,34 +37,154 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/functional/hash.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace batt {
 
+// Controls whether (and when) HttpClient sends a second copy of a slow request; see
+// HttpClient::set_hedging_policy.
+//
+struct HttpHedgingPolicy {
+    // Hedging is off unless this is set.
+    //
+    bool enabled = false;
+
+    // A request is hedged once it has gone without a response for this percentile (as a fraction, 0.0 -
+    // 1.0) of the recently observed latencies for its host.
+    //
+    double latency_percentile = 0.95;
+
+    // Requests to a host are not hedged until at least this many of its latencies have been observed.
+    //
+    usize min_samples = 20;
+
+    // Requests are never hedged sooner than this.
+    //
+    std::chrono::nanoseconds min_delay = std::chrono::milliseconds{1};
+};
+
 class HttpClient
 {
    public:
     static constexpr usize kDefaultMaxConnectionsPerHost = HttpClientHostContext::kDefaultMaxConnections;
 
+    // The number of independently locked partitions of the host context map.  Requests for different hosts
+    // only contend on the same lock when their HostAddress hashes to the same shard.
+    //
+    static constexpr usize kHostContextShardCount = 16;
+
     //+++++++++++-+-+--+----- --- -- -  -  -   -
 
-    explicit HttpClient(boost::asio::io_context& io) noexcept : io_{io}
+    // Creates a client that runs all host contexts and connections on `io`.
+    //
+    explicit HttpClient(boost::asio::io_context& io) noexcept
+        : io_{&io}
+        , resolver_cache_{*this->io_.front()}
+    {
+    }
+
+    // Creates a client that spreads its host contexts across the passed io_contexts (which must be
+    // non-empty).
+    // Each host context, along with all of its connections, stays on the io_context it was assigned when it
+    // was created; new hosts are assigned round-robin.
+    //
+    explicit HttpClient(const std::vector<boost::asio::io_context*>& io) noexcept
+        : io_{io.begin(), io.end()}
+        , resolver_cache_{*[&] {
+            BATT_CHECK(!this->io_.empty());
+            return this->io_.front();
+        }()}
     {
     }
 
+    // Calls `this->halt()` and `this->join()`.
+    //
+    ~HttpClient() noexcept;
+
+    // Returns the first (and, for a client created with a single io_context, only) io_context.
+    //
     boost::asio::io_context& get_io_context() const noexcept
     {
-        return this->io_;
+        return *this->io_.front();
+    }
+
+    usize io_context_count() const noexcept
+    {
+        return this->io_.size();
+    }
+
+    // The DNS cache shared by all connections opened by this client.
+    //
+    HostResolverCache& resolver_cache() noexcept
+    {
+        return this->resolver_cache_;
     }
 
     Status submit_request(const HostAddress& host_address, Pin<HttpRequest>&& request,
                           Pin<HttpResponse>&& response);
 
+    // Sends `hedge` to `host_address`; if it hasn't been answered after `delay`, sends a second copy, which
+    // will be picked up by the least loaded connection to the host.  The response to whichever copy arrives
+    // first is delivered; the other copy is dropped if it hasn't been sent yet, else its response is
+    // discarded.
+    //
+    Status submit_hedged_request(const HostAddress& host_address, const SharedPtr<HttpRequestHedge>& hedge,
+                                 std::chrono::nanoseconds delay);
+
+    // Sets the policy for hedging requests without a body (see http_request).  Should be called before any
+    // requests are submitted.
+    //
+    void set_hedging_policy(const HttpHedgingPolicy& policy)
+    {
+        this->hedging_policy_ = policy;
+    }
+
+    const HttpHedgingPolicy& hedging_policy() const
+    {
+        return this->hedging_policy_;
+    }
+
+    // Returns how long to wait for a response from `host_address` before hedging a request, or None if
+    // requests to this host shouldn't be hedged (yet).
+    //
+    Optional<std::chrono::nanoseconds> hedge_delay(const HostAddress& host_address);
+
+    // Returns the context for `host_address`, creating it (and assigning it an io_context) if necessary.
+    //
+    SharedPtr<HttpClientHostContext> get_host_context(const HostAddress& host_address);
+
+    // Halts all host contexts (see HttpClientHostContext::halt) and the resolver cache's background refresh.
+    //
+    void halt();
+
+    // Waits for all host contexts (and their connections) to finish.
+    //
+    void join();
+
    private:
-    boost::asio::io_context& io_;
+    using HostContextMap =
+        std::unordered_map<HostAddress, SharedPtr<HttpClientHostContext>, boost::hash<HostAddress>>;
+
+    boost::asio::io_context& next_io_context();
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+    SmallVec<boost::asio::io_context*, 1> io_;
 
-    Mutex<std::unordered_map<HostAddress, SharedPtr<HttpClientHostContext>, boost::hash<HostAddress>>>
-        host_contexts_;
+    std::atomic<usize> next_io_index_{0};
+
+    HostResolverCache resolver_cache_;
+
+    HttpHedgingPolicy hedging_policy_;
+
+    std::array<Mutex<HostContextMap>, kHostContextShardCount> host_contexts_;
 };
 
 class DefaultHttpClient
@@ -72,20 +196,46 @@ class DefaultHttpClient
         //
         // This object is intentionally leaked!
 
-        return default_client_->client_;
+        return *default_client_->client_;
     }
 
    private:
-    boost::asio::io_context io_;
+    using WorkGuard = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+    // One io_context (driven by one thread) per CPU.
+    //
+    static usize default_thread_count()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    DefaultHttpClient()
+    {
+        const usize thread_count = DefaultHttpClient::default_thread_count();
+        std::vector<boost::asio::io_context*> io_ptrs;
+
+        for (usize i = 0; i < thread_count; ++i) {
+            this->io_.emplace_back(std::make_unique<boost::asio::io_context>());
+            this->work_guards_.emplace_back(this->io_.back()->get_executor());
+            io_ptrs.emplace_back(this->io_.back().get());
+        }
+
+        this->client_.emplace(io_ptrs);
 
-    Optional<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> work_guard_{
-        this->io_.get_executor()};
+        for (usize i = 0; i < thread_count; ++i) {
+            this->io_threads_.emplace_back([io = this->io_[i].get()] {
+                io->run();
+            });
+        }
+    }
+
+    std::vector<std::unique_ptr<boost::asio::io_context>> io_;
 
-    HttpClient client_{this->io_};
+    std::vector<WorkGuard> work_guards_;
 
-    std::thread io_thread_{[this] {
-        this->io_.run();
-    }};
+    Optional<HttpClient> client_;
+
+    std::vector<std::thread> io_threads_;
 };
 
 namespace detail {
@@ -95,10 +245,33 @@ class HttpClientRequestContext
    public:
     explicit HttpClientRequestContext()
     {
-        this->set_version(HttpVersion{1, 1}).IgnoreError();
+        this->prepare_request();
+    }
 
-        this->request_.async_set_message(this->message_);
-        this->request_.async_set_data(this->data_);
+    // Returns the context to its initial state so it can be used for another request, keeping the storage
+    // allocated for the path, host address, and headers (see HttpObjectPool).  Returns false if the request
+    // object can't be reused.
+    //
+    bool reset()
+    {
+        if (!this->request_.reset()) {
+            return false;
+        }
+
+        this->client_ = &DefaultHttpClient::get();
+        this->path_.clear();
+        this->content_length_.clear();
+        this->host_address_.scheme.clear();
+        this->host_address_.hostname.clear();
+        this->host_address_.port = None;
+        this->message_.clear();
+        this->data_ = HttpData{};
+        this->has_data_ = false;
+        this->response_ = nullptr;
+
+        this->prepare_request();
+
+        return true;
     }
 
     //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -174,7 +347,20 @@ class HttpClientRequestContext
         this->host_address_.hostname = url.host;
         this->host_address_.port = url.port;
 
-        usize needed = url.path.size();
+        std::string_view path = url.path;
+        if (is_unix_socket(this->host_address_)) {
+            if (url.host.empty()) {
+                this->host_address_.hostname = url.path;
+                path = "/";
+            } else {
+                this->host_address_.hostname = url_decode(url.host);
+                if (path.empty()) {
+                    path = "/";
+                }
+            }
+        }
+
+        usize needed = path.size();
         if (!url.query.empty()) {
             needed += 1 + url.query.size();
         }
@@ -183,7 +369,7 @@ class HttpClientRequestContext
         }
         this->path_.reserve(needed);
 
-        this->path_ = url.path;
+        this->path_ = path;
         if (!url.query.empty()) {
             this->path_ += "?";
             this->path_ += url.query;
@@ -206,6 +392,7 @@ class HttpClientRequestContext
     void set_data(HttpData&& data)
     {
         this->data_ = std::move(data);
+        this->has_data_ = true;
     }
 
     //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -239,6 +426,21 @@ class HttpClientRequestContext
 
         // TODO [tastolfi 2022-03-29] Check headers and adjust `this->data_` accordingly.
 
+        // Requests without a body can be hedged, if the client's policy allows it.
+        //
+        if (!this->has_data_) {
+            Optional<std::chrono::nanoseconds> hedge_delay = this->client_->hedge_delay(this->host_address_);
+            if (hedge_delay) {
+                // The hedged request is serialized up front, so this context is done with right away.
+                //
+                this->request_.state().set_value(HttpRequest::kConsumed);
+
+                return this->client_->submit_hedged_request(
+                    this->host_address_, batt::make_shared<HttpRequestHedge>(this->message_, this->response_),
+                    *hedge_delay);
+            }
+        }
+
         this->request_.state().set_value(HttpRequest::kInitialized);
         return this->client_->submit_request(this->host_address_, make_pin(&this->request_),
                                              make_pin(this->response_));
@@ -246,17 +448,40 @@ class HttpClientRequestContext
 
     //+++++++++++-+-+--+----- --- -- -  -  -   -
    private:
+    void prepare_request()
+    {
+        this->set_version(HttpVersion{1, 1}).IgnoreError();
+
+        this->request_.async_set_message(this->message_);
+        this->request_.async_set_data(this->data_);
+    }
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+
     HttpClient* client_ = &DefaultHttpClient::get();
     std::string path_;
     std::string content_length_;
     HostAddress host_address_;
     pico_http::Request message_;
     HttpData data_;
+    bool has_data_ = false;
     HttpRequest request_;
     HttpResponse* response_ = nullptr;
 
 };  // class HttpClientRequestContext
 
+// Request contexts are recycled between calls to http_request, so that steady-state requests reuse the
+// same path, host address and header storage.
+//
+inline HttpObjectPool<HttpClientRequestContext>& http_client_request_context_pool()
+{
+    static auto* pool_ = new HttpObjectPool<HttpClientRequestContext>;
+    //
+    // This object is intentionally leaked!
+
+    return *pool_;
+}
+
 }  // namespace detail
 
 template <typename... Params>
@@ -266,9 +491,12 @@ StatusOr<std::unique_ptr<HttpResponse>> http_request(std::string_view method, st
     StatusOr<UrlParse> url_parse = parse_url(url);
     BATT_REQUIRE_OK(url_parse);
 
-    // Create a request context object to hold all the things we may need to submit the request.
+    // Get a request context object to hold all the things we may need to submit the request.
     //
-    detail::HttpClientRequestContext context;
+    HttpObjectPool<detail::HttpClientRequestContext>::Ptr context_ptr =
+        detail::http_client_request_context_pool().acquire();
+
+    detail::HttpClientRequestContext& context = *context_ptr;
 
     // Initialize the request from args.
     //
@@ -282,7 +510,7 @@ StatusOr<std::unique_ptr<HttpResponse>> http_request(std::string_view method, st
     BATT_REQUIRE_OK(params_status);
 
     // If the caller did not pass an HttpResponse object to receive the response, then create one to
-    // use/return.
+    // use/return.  (To avoid this allocation, pass an object from an HttpResponsePool.)
     //
     std::unique_ptr<HttpResponse> new_response;
     if (context.get_response_object() == nullptr) {
@@ -316,7 +544,12 @@ StatusOr<std::unique_ptr<HttpResponse>> http_request(std::string_view method, st
     //
     // TODO [tastolfi 2022-05-06] Should we provide an option to skip this step?
     //
-    Status response_received = response->state().await_equal(HttpResponse::kInitialized);
+    // (If the response has an inline handler, it goes straight to kConsumed once the handler has been
+    // called.)
+    //
+    StatusOr<i32> response_received = response->state().await_true([](i32 state) {
+        return state != HttpResponse::kCreated;
+    });
     if (!response_received.ok()) {
         BATT_REQUIRE_OK(response->get_status());
     }
@@ -10,8 +10,22 @@
 
 #include <batteries/env.hpp>
 
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/write.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
 namespace {
 
+using namespace batt::int_types;
+
 const bool kInteractiveTesting = batt::getenv_as<int>("BATT_INTERACTIVE").value_or(0);
 
 TEST(HttpClientTest, Test)
@@ -41,4 +55,541 @@ TEST(HttpClientTest, Test)
     }
 }
 
+// A minimal blocking HTTP/1.1 server on 127.0.0.1 that answers every request with the request path as the
+// body; each connection is served by its own thread.  A request for a path starting with "/reset" is not
+// answered; instead, the connection is reset after a short delay (so the client can pipeline more requests
+// behind it).  See also `reset_next_request` and `delay_next_slow_request`.
+//
+class EchoPathServer
+{
+   public:
+    EchoPathServer()
+    {
+        this->acceptor_.open(boost::asio::ip::tcp::v4());
+        this->acceptor_.set_option(boost::asio::socket_base::reuse_address(true));
+        this->acceptor_.bind(
+            boost::asio::ip::tcp::endpoint{boost::asio::ip::make_address_v4("127.0.0.1"), /*port=*/0});
+        this->acceptor_.listen();
+
+        this->accept_thread_ = std::thread{[this] {
+            for (;;) {
+                auto socket = std::make_shared<boost::asio::ip::tcp::socket>(this->io_);
+                boost::system::error_code ec;
+                this->acceptor_.accept(*socket, ec);
+                if (ec || this->stop_requested_) {
+                    return;
+                }
+                this->connection_threads_.emplace_back([this, socket] {
+                    this->serve(*socket);
+                });
+            }
+        }};
+    }
+
+    ~EchoPathServer()
+    {
+        // Wake up the accept thread with a dummy connection.
+        //
+        this->stop_requested_ = true;
+        {
+            boost::asio::ip::tcp::socket wake{this->io_};
+            boost::system::error_code ec;
+            wake.connect(this->acceptor_.local_endpoint(), ec);
+        }
+        this->accept_thread_.join();
+        for (std::thread& t : this->connection_threads_) {
+            t.join();
+        }
+    }
+
+    u16 port() const
+    {
+        return this->acceptor_.local_endpoint().port();
+    }
+
+    // Delays the response to the next request for a path starting with "/slow" by `delay`.
+    //
+    void delay_next_slow_request(std::chrono::milliseconds delay)
+    {
+        this->slow_delay_ms_.store(delay.count());
+    }
+
+    // Resets the connection of the next request (for any path), after `delay`, instead of answering it.
+    //
+    void reset_next_request(std::chrono::milliseconds delay)
+    {
+        this->reset_delay_ms_.store(delay.count());
+    }
+
+   private:
+    void serve(boost::asio::ip::tcp::socket& socket)
+    {
+        std::string input;
+        for (;;) {
+            boost::system::error_code ec;
+            const usize header_end = boost::asio::read_until(socket, boost::asio::dynamic_buffer(input),
+                                                             "\r\n\r\n", ec);
+            if (ec) {
+                return;
+            }
+            const usize path_begin = input.find(' ') + 1;
+            const std::string path = input.substr(path_begin, input.find(' ', path_begin) - path_begin);
+            input.erase(0, header_end);
+
+            i64 reset_delay_ms = this->reset_delay_ms_.exchange(0);
+            if (path.rfind("/reset", 0) == 0) {
+                reset_delay_ms = 200;
+            }
+            if (reset_delay_ms != 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{reset_delay_ms});
+                socket.set_option(boost::asio::socket_base::linger{true, 0}, ec);
+                socket.close(ec);
+                return;
+            }
+
+            if (path.rfind("/slow", 0) == 0) {
+                const i64 delay_ms = this->slow_delay_ms_.exchange(0);
+                if (delay_ms != 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds{delay_ms});
+                }
+            }
+
+            const std::string response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(path.size()) +
+                                         "\r\n\r\n" + path;
+            boost::asio::write(socket, boost::asio::buffer(response), ec);
+            if (ec) {
+                return;
+            }
+        }
+    }
+
+    boost::asio::io_context io_;
+    boost::asio::ip::tcp::acceptor acceptor_{this->io_};
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<i64> slow_delay_ms_{0};
+    std::atomic<i64> reset_delay_ms_{0};
+    std::thread accept_thread_;
+    std::vector<std::thread> connection_threads_;
+};
+
+// Runs `n` io_contexts, one thread each.
+//
+class IoThreads
+{
+   public:
+    explicit IoThreads(usize n)
+    {
+        for (usize i = 0; i < n; ++i) {
+            this->io_.emplace_back(std::make_unique<boost::asio::io_context>());
+            this->work_guards_.emplace_back(this->io_.back()->get_executor());
+            this->threads_.emplace_back([io = this->io_.back().get()] {
+                io->run();
+            });
+        }
+    }
+
+    ~IoThreads()
+    {
+        this->work_guards_.clear();
+        for (std::thread& t : this->threads_) {
+            t.join();
+        }
+    }
+
+    std::vector<boost::asio::io_context*> get() const
+    {
+        std::vector<boost::asio::io_context*> ptrs;
+        for (const auto& io : this->io_) {
+            ptrs.emplace_back(io.get());
+        }
+        return ptrs;
+    }
+
+   private:
+    std::vector<std::unique_ptr<boost::asio::io_context>> io_;
+    std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> work_guards_;
+    std::vector<std::thread> threads_;
+};
+
+TEST(HttpClientTest, HostContextsSpreadAcrossIoContexts)
+{
+    IoThreads io_threads{4};
+    const std::vector<boost::asio::io_context*> io = io_threads.get();
+
+    batt::HttpClient client{io};
+
+    EXPECT_EQ(client.io_context_count(), 4u);
+    EXPECT_EQ(&client.get_io_context(), io.front());
+
+    std::vector<batt::SharedPtr<batt::HttpClientHostContext>> host_contexts;
+    for (usize i = 0; i < io.size(); ++i) {
+        const std::string hostname = "host" + std::to_string(i) + ".test";
+        host_contexts.emplace_back(client.get_host_context(batt::HostAddress{"http", hostname, batt::None}));
+    }
+
+    // Each host is pinned to its own io_context, and stays there.
+    //
+    for (usize i = 0; i < io.size(); ++i) {
+        EXPECT_EQ(&host_contexts[i]->get_io_context(), io[i]);
+        for (usize j = 0; j < i; ++j) {
+            EXPECT_NE(&host_contexts[i]->get_io_context(), &host_contexts[j]->get_io_context());
+        }
+        EXPECT_EQ(client.get_host_context(host_contexts[i]->host_address()), host_contexts[i]);
+    }
+
+    client.halt();
+    client.join();
+}
+
+TEST(HttpClientTest, ConcurrentRequestsMultipleHosts)
+{
+    EchoPathServer server;
+    IoThreads io_threads{3};
+
+    batt::HttpClient client{io_threads.get()};
+
+    constexpr usize kThreadCount = 6;
+    constexpr usize kRequestsPerThread = 20;
+
+    // "localhost" and "127.0.0.1" are distinct HostAddress values, so they get distinct host contexts.
+    //
+    const std::array<std::string, 2> hosts = {"localhost", "127.0.0.1"};
+
+    std::atomic<usize> ok_count{0};
+    std::vector<std::thread> threads;
+    for (usize t = 0; t < kThreadCount; ++t) {
+        threads.emplace_back([&, t] {
+            for (usize i = 0; i < kRequestsPerThread; ++i) {
+                const std::string path = "/t" + std::to_string(t) + "/r" + std::to_string(i);
+                const std::string url =
+                    "http://" + hosts[(t + i) % hosts.size()] + ":" + std::to_string(server.port()) + path;
+
+                batt::StatusOr<std::unique_ptr<batt::HttpResponse>> result =
+                    batt::http_get(url, client);
+                ASSERT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+
+                batt::StatusOr<batt::HttpData&> data = result->get()->await_data();
+                ASSERT_TRUE(data.ok());
+
+                std::ostringstream oss;
+                ASSERT_TRUE((*data | batt::seq::print_out(oss)).ok());
+                EXPECT_EQ(oss.str(), path);
+
+                ok_count.fetch_add(1);
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(ok_count.load(), kThreadCount * kRequestsPerThread);
+
+    client.halt();
+    client.join();
+}
+
+TEST(HttpClientTest, PooledResponsesAreReused)
+{
+    EchoPathServer server;
+    IoThreads io_threads{1};
+
+    batt::HttpClient client{io_threads.get()};
+    batt::HttpResponsePool pool;
+
+    batt::HttpResponse* first = nullptr;
+
+    for (usize i = 0; i < 10; ++i) {
+        const std::string path = "/r" + std::to_string(i);
+        const std::string url = "http://127.0.0.1:" + std::to_string(server.port()) + path;
+
+        batt::HttpResponsePool::Ptr response = pool.acquire();
+        if (first == nullptr) {
+            first = response.get();
+        }
+        EXPECT_EQ(response.get(), first);
+
+        batt::StatusOr<std::unique_ptr<batt::HttpResponse>> result =
+            batt::http_get(url, client, response.get());
+        ASSERT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+
+        // The caller supplied the response object, so none is returned.
+        //
+        EXPECT_EQ(*result, nullptr);
+        EXPECT_EQ(response->code(), 200);
+
+        batt::StatusOr<batt::HttpData&> data = response->await_data();
+        ASSERT_TRUE(data.ok());
+
+        std::ostringstream oss;
+        ASSERT_TRUE((*data | batt::seq::print_out(oss)).ok());
+        EXPECT_EQ(oss.str(), path);
+    }
+
+    EXPECT_EQ(pool.free_count(), 1u);
+
+    client.halt();
+    client.join();
+}
+
+TEST(HttpClientTest, InlineResponseHandler)
+{
+    EchoPathServer server;
+    IoThreads io_threads{1};
+
+    batt::HttpClient client{io_threads.get()};
+    batt::HttpResponsePool pool;
+
+    for (usize i = 0; i < 10; ++i) {
+        const std::string path = "/inline" + std::to_string(i);
+        const std::string url = "http://127.0.0.1:" + std::to_string(server.port()) + path;
+
+        // Every other response is too large to be delivered inline; it must be reported as an error and
+        // skipped without breaking the connection for the next request.
+        //
+        const usize max_body_size = (i % 2 == 0) ? path.size() : path.size() - 1;
+
+        usize call_count = 0;
+        batt::Status status;
+        i32 code = 0;
+        std::string body;
+
+        batt::HttpResponsePool::Ptr response = pool.acquire();
+        response->set_inline_handler(
+            [&](batt::StatusOr<pico_http::Response&> message, const batt::ConstBuffer& data) {
+                call_count += 1;
+                status = message.status();
+                if (message.ok()) {
+                    code = message->status;
+                    body.assign(static_cast<const char*>(data.data()), data.size());
+                }
+            },
+            max_body_size);
+
+        batt::StatusOr<std::unique_ptr<batt::HttpResponse>> result =
+            batt::http_get(url, client, response.get());
+        ASSERT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+
+        // The handler has been called by the time http_get returns.
+        //
+        EXPECT_EQ(response->state().get_value(), batt::HttpResponse::kConsumed);
+        EXPECT_EQ(call_count, 1u);
+
+        if (i % 2 == 0) {
+            EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+            EXPECT_EQ(code, 200);
+            EXPECT_EQ(body, path);
+        } else {
+            EXPECT_EQ(status, batt::StatusCode::kOutOfRange);
+        }
+    }
+
+    client.halt();
+    client.join();
+}
+
+TEST(HttpClientTest, InlineResponsesFailWhenConnectionResets)
+{
+    EchoPathServer server;
+    IoThreads io_threads{1};
+
+    batt::HttpClient client{io_threads.get()};
+
+    // The client opens at most two connections to the host, so with four concurrent requests, two are
+    // pipelined behind the first request on each connection.  None of them are answered.
+    //
+    constexpr usize kRequestCount = 4;
+
+    struct InlineResult {
+        std::atomic<usize> call_count{0};
+        batt::Status status;
+    };
+
+    std::array<InlineResult, kRequestCount> results;
+    std::array<batt::Status, kRequestCount> get_status;
+    std::vector<std::thread> threads;
+
+    for (usize i = 0; i < kRequestCount; ++i) {
+        threads.emplace_back([&, i] {
+            const std::string url =
+                "http://127.0.0.1:" + std::to_string(server.port()) + "/reset" + std::to_string(i);
+
+            InlineResult& result = results[i];
+
+            batt::HttpResponse response;
+            response.set_inline_handler(
+                [&result](batt::StatusOr<pico_http::Response&> message, const batt::ConstBuffer& /*body*/) {
+                    result.status = message.status();
+                    result.call_count.fetch_add(1);
+                });
+
+            get_status[i] = batt::http_get(url, client, &response).status();
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    for (usize i = 0; i < kRequestCount; ++i) {
+        EXPECT_FALSE(get_status[i].ok()) << BATT_INSPECT(i);
+        EXPECT_EQ(results[i].call_count.load(), 1u) << BATT_INSPECT(i);
+        EXPECT_FALSE(results[i].status.ok()) << BATT_INSPECT(i);
+    }
+
+    client.halt();
+    client.join();
+}
+
+TEST(HttpClientTest, ResponseFailsWhenConnectionResets)
+{
+    EchoPathServer server;
+    IoThreads io_threads{1};
+
+    batt::HttpClient client{io_threads.get()};
+
+    const std::string url = "http://127.0.0.1:" + std::to_string(server.port()) + "/reset";
+
+    batt::StatusOr<std::unique_ptr<batt::HttpResponse>> result = batt::http_get(url, client);
+    if (result.ok()) {
+        EXPECT_FALSE((*result)->await_data().ok());
+    }
+
+    client.halt();
+    client.join();
+}
+
+// GETs `url` and returns the response body.
+//
+std::string get_response_body(const std::string& url, batt::HttpClient& client)
+{
+    batt::StatusOr<std::unique_ptr<batt::HttpResponse>> result = batt::http_get(url, client);
+    BATT_CHECK_OK(result);
+
+    batt::StatusOr<batt::HttpData&> data = (*result)->await_data();
+    BATT_CHECK_OK(data);
+
+    std::ostringstream oss;
+    BATT_CHECK_OK(*data | batt::seq::print_out(oss));
+
+    return oss.str();
+}
+
+TEST(HttpClientTest, HedgedRequests)
+{
+    EchoPathServer server;
+    IoThreads io_threads{1};
+
+    batt::HttpClient client{io_threads.get()};
+
+    const std::string base_url = "http://127.0.0.1:" + std::to_string(server.port());
+    const batt::HostAddress host_address{"http", "127.0.0.1", server.port()};
+
+    batt::HttpHedgingPolicy policy;
+    policy.enabled = true;
+    policy.latency_percentile = 0.5;
+    policy.min_samples = 5;
+    policy.min_delay = std::chrono::milliseconds{5};
+
+    client.set_hedging_policy(policy);
+
+    const auto get_body = [&](const std::string& path) {
+        return get_response_body(base_url + path, client);
+    };
+
+    // There's no latency history for the host yet, so nothing is hedged.
+    //
+    EXPECT_EQ(client.hedge_delay(host_address), batt::None);
+
+    for (usize i = 0; i < policy.min_samples; ++i) {
+        EXPECT_EQ(get_body("/warm-up"), "/warm-up");
+    }
+
+    batt::Optional<std::chrono::nanoseconds> delay = client.hedge_delay(host_address);
+    ASSERT_TRUE(delay);
+    EXPECT_GE(*delay, policy.min_delay);
+
+    // The first copy of this request is stuck behind a slow server; the second copy, sent on another
+    // connection, should answer it long before that.
+    //
+    server.delay_next_slow_request(std::chrono::milliseconds{1000});
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(get_body("/slow"), "/slow");
+
+    EXPECT_LT(std::chrono::steady_clock::now() - start_time, std::chrono::milliseconds{500});
+
+    // Both connections (including the one whose response is discarded) remain usable.
+    //
+    for (usize i = 0; i < 4; ++i) {
+        EXPECT_EQ(get_body("/after" + std::to_string(i)), "/after" + std::to_string(i));
+    }
+
+    client.halt();
+    client.join();
+}
+
+TEST(HttpClientTest, HedgedRequestSurvivesConnectionReset)
+{
+    EchoPathServer server;
+    IoThreads io_threads{1};
+
+    batt::HttpClient client{io_threads.get()};
+
+    const std::string base_url = "http://127.0.0.1:" + std::to_string(server.port());
+
+    batt::HttpHedgingPolicy policy;
+    policy.enabled = true;
+    policy.latency_percentile = 0.5;
+    policy.min_samples = 5;
+    policy.min_delay = std::chrono::milliseconds{5};
+
+    client.set_hedging_policy(policy);
+
+    const auto get_body = [&](const std::string& path) {
+        return get_response_body(base_url + path, client);
+    };
+
+    for (usize i = 0; i < policy.min_samples; ++i) {
+        EXPECT_EQ(get_body("/warm-up"), "/warm-up");
+    }
+
+    // The connection carrying the first copy of this request is reset while the second copy (on the other
+    // connection) is still waiting for its response; the second copy should still answer the request.
+    //
+    server.reset_next_request(std::chrono::milliseconds{100});
+    server.delay_next_slow_request(std::chrono::milliseconds{300});
+
+    EXPECT_EQ(get_body("/slow"), "/slow");
+
+    // The surviving connection remains usable.
+    //
+    for (usize i = 0; i < 4; ++i) {
+        EXPECT_EQ(get_body("/after" + std::to_string(i)), "/after" + std::to_string(i));
+    }
+
+    client.halt();
+    client.join();
+}
+
+TEST(HttpClientTest, HedgingDisabledByDefault)
+{
+    EchoPathServer server;
+    IoThreads io_threads{1};
+
+    batt::HttpClient client{io_threads.get()};
+
+    EXPECT_FALSE(client.hedging_policy().enabled);
+
+    const std::string url = "http://127.0.0.1:" + std::to_string(server.port()) + "/x";
+    for (usize i = 0; i < 30; ++i) {
+        EXPECT_EQ(get_response_body(url, client), "/x");
+    }
+
+    EXPECT_EQ(client.hedge_delay(batt::HostAddress{"http", "127.0.0.1", server.port()}), batt::None);
+
+    client.halt();
+    client.join();
+}
+
 }  // namespace
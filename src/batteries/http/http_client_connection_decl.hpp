@@ -9,6 +9,7 @@
 //
 #include <batteries/http/http_data.hpp>
 #include <batteries/http/http_request.hpp>
+#include <batteries/http/http_request_hedge.hpp>
 #include <batteries/http/http_response.hpp>
 
 #include <batteries/async/buffer_source.hpp>
@@ -17,7 +18,10 @@
 
 #include <batteries/status.hpp>
 
-#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/generic/stream_protocol.hpp>
+
+#include <atomic>
+#include <chrono>
 
 namespace batt {
 
@@ -41,6 +45,37 @@ class HttpClientConnection
         bool chunked_encoding;
     };
 
+    // A request that has been sent, waiting for its response.
+    //
+    struct PendingResponse {
+        // Returns the response object to deliver to, or nullptr if this is a copy of a hedged request that
+        // was already answered on another connection.
+        //
+        Pin<HttpResponse> claim()
+        {
+            if (this->hedge) {
+                return this->hedge->claim();
+            }
+            return std::move(this->response);
+        }
+
+        // Reports that this request failed with `status`.  For a copy of a hedged request, the error is only
+        // reported if no other copy is still outstanding (see HttpRequestHedge::fail_copy).
+        //
+        void fail(const Status& status)
+        {
+            Pin<HttpResponse> const response =
+                this->hedge ? this->hedge->fail_copy() : std::move(this->response);
+            if (response) {
+                response->fail(status);
+            }
+        }
+
+        Pin<HttpResponse> response;
+        SharedPtr<HttpRequestHedge> hedge;
+        std::chrono::steady_clock::time_point sent_time;
+    };
+
     explicit HttpClientConnection(HttpClientHostContext& context) noexcept;
 
     void start();
@@ -61,15 +96,42 @@ class HttpClientConnection
 
     StatusOr<i32> read_next_response(pico_http::Response& response);
 
+    // Passes a parsed response and its body to the inline handler of `response` (see
+    // HttpResponse::set_inline_handler), then consumes both from the input buffer.
+    //
+    Status deliver_inline(HttpResponse& response, pico_http::Response& response_message, i32 message_length,
+                          ResponseInfo& response_info);
+
     boost::asio::io_context& get_io_context();
 
+    // Returns false once this connection has stopped taking new requests.
+    //
+    bool is_open() const
+    {
+        return this->open_.load();
+    }
+
+    // The number of requests that have been sent on this connection whose responses haven't been fully
+    // processed.
+    //
+    i64 pipeline_depth() const
+    {
+        return this->pipeline_depth_.load();
+    }
+
     //+++++++++++-+-+--+----- --- -- -  -  -   -
 
     HttpClientHostContext& context_;
 
-    boost::asio::ip::tcp::socket socket_;
+    // Either a TCP or a Unix domain socket, depending on the host address (see kUnixSocketScheme).
+    //
+    boost::asio::generic::stream_protocol::socket socket_;
+
+    Queue<PendingResponse> response_queue_;
+
+    std::atomic<bool> open_{true};
 
-    Queue<Pin<HttpResponse>> response_queue_;
+    std::atomic<i64> pipeline_depth_{0};
 
     StreamBuffer input_buffer_{16 * 1024};
 
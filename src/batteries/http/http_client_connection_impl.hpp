@@ -7,9 +7,11 @@
 
 #include <batteries/config.hpp>
 //
+#include <batteries/http/host_resolver_cache.hpp>
 #include <batteries/http/http_chunk_decoder.hpp>
 #include <batteries/http/http_client_connection.hpp>
 #include <batteries/http/http_client_host_context.hpp>
+#include <batteries/http/http_message_reader.hpp>
 
 namespace batt {
 
@@ -53,17 +55,33 @@ BATT_INLINE_IMPL void HttpClientConnection::start()
 //
 BATT_INLINE_IMPL Status HttpClientConnection::open_connection()
 {
+    if (is_unix_socket(this->context_.host_address())) {
+        ErrorCode ec =
+            Task::await_connect(this->socket_, unix_socket_endpoint(this->context_.host_address()));
+        if (ec) {
+            return StatusCode::kUnavailable;
+        }
+        return OkStatus();
+    }
+
+    HostResolverCache& resolver_cache = this->context_.client().resolver_cache();
+
     StatusOr<SmallVec<boost::asio::ip::tcp::endpoint>> hosts =
-        await_resolve(this->get_io_context(), this->context_.host_address());
+        resolver_cache.await_resolve(this->context_.host_address());
     BATT_REQUIRE_OK(hosts);
 
     for (const boost::asio::ip::tcp::endpoint& endpoint : *hosts) {
-        ErrorCode ec = Task::await_connect(this->socket_, endpoint);
+        ErrorCode ec =
+            Task::await_connect(this->socket_, boost::asio::generic::stream_protocol::endpoint{endpoint});
         if (!ec) {
             return OkStatus();
         }
     }
 
+    // None of the cached endpoints are reachable; the host may have moved, so resolve it again next time.
+    //
+    resolver_cache.invalidate(this->context_.host_address());
+
     return StatusCode::kUnavailable;
 }
 
@@ -74,6 +92,9 @@ BATT_INLINE_IMPL Status HttpClientConnection::process_requests()
     Optional<Task> fill_input_buffer_task;
 
     auto on_exit = finally([this, &fill_input_buffer_task] {
+        this->open_.store(false);
+        this->context_.notify_load_changed();
+
         boost::system::error_code ec;
         this->socket_.shutdown(boost::asio::socket_base::shutdown_send, ec);
         this->response_queue_.close();
@@ -86,20 +107,42 @@ BATT_INLINE_IMPL Status HttpClientConnection::process_requests()
     bool connected = false;
 
     for (;;) {
+        // Leave new requests to a less busy connection, if there is one.
+        //
+        Status least_loaded = this->context_.await_least_loaded(*this);
+        BATT_REQUIRE_OK(least_loaded);
+
         Pin<HttpRequest> request;
         Pin<HttpResponse> response;
+        SharedPtr<HttpRequestHedge> hedge;
 
-        BATT_ASSIGN_OK_RESULT(std::tie(request, response), this->context_.await_next_request());
+        BATT_ASSIGN_OK_RESULT(std::tie(request, response, hedge), this->context_.await_next_request());
 
-        BATT_CHECK_NOT_NULLPTR(request);
-        BATT_CHECK_NOT_NULLPTR(response);
-        BATT_CHECK_EQ(request->state().get_value(), HttpRequest::kInitialized);
+        if (hedge) {
+            // Don't bother sending this copy of a hedged request if another copy has already been answered.
+            //
+            if (hedge->is_claimed()) {
+                continue;
+            }
+        } else {
+            BATT_CHECK_NOT_NULLPTR(request);
+            BATT_CHECK_NOT_NULLPTR(response);
+            BATT_CHECK_EQ(request->state().get_value(), HttpRequest::kInitialized);
+        }
 
         if (!connected) {
             Status status = this->open_connection();
             if (!status.ok()) {
-                request->update_status(status);
-                request->state().close();
+                if (hedge) {
+                    response = hedge->fail_copy();
+                }
+                if (response) {
+                    response->fail(status);
+                }
+                if (request) {
+                    request->update_status(status);
+                    request->state().close();
+                }
             }
             BATT_REQUIRE_OK(status);
             connected = true;
@@ -109,12 +152,46 @@ BATT_INLINE_IMPL Status HttpClientConnection::process_requests()
             });
         }
 
-        this->response_queue_.push(response);
+        this->pipeline_depth_.fetch_add(1);
+
+        // (`push` leaves `pending` untouched if the queue is closed.)
+        //
+        PendingResponse pending{std::move(response), hedge, /*sent_time=*/std::chrono::steady_clock::now()};
+        if (!this->response_queue_.push(std::move(pending))) {
+            //
+            // The connection was lost before the request could be sent; hand the request back to the host
+            // context, so that another connection can send it.
+            //
+            this->pipeline_depth_.fetch_sub(1);
+
+            const Status requeued =
+                hedge ? this->context_.submit_request(hedge)
+                      : this->context_.submit_request(std::move(request), std::move(pending.response));
+
+            if (!requeued.ok()) {
+                pending.fail(StatusCode::kClosed);
+                if (!hedge) {
+                    request->update_status(StatusCode::kClosed);
+                    request->state().close();
+                }
+            }
+            return StatusCode::kClosed;
+        }
+        this->context_.notify_load_changed();
 
-        Status status = request->serialize(this->socket_);
-        BATT_REQUIRE_OK(status);
+        if (hedge) {
+            IOResult<usize> bytes_written = Task::await_write(this->socket_, hedge->serialized_request());
+            BATT_REQUIRE_OK(bytes_written);
+        } else {
+            Status status = request->serialize(this->socket_);
+            if (!status.ok()) {
+                request->update_status(status);
+                request->state().close();
+            }
+            BATT_REQUIRE_OK(status);
 
-        request->state().set_value(HttpRequest::kConsumed);
+            request->state().set_value(HttpRequest::kConsumed);
+        }
     }
 }
 
@@ -151,23 +228,81 @@ BATT_INLINE_IMPL Status HttpClientConnection::process_responses()
 {
     auto on_exit = finally([this] {
         this->input_buffer_.close_for_read();
+
+        // Stop taking requests, and fail those that were sent but will never be answered, so that their
+        // submitters don't wait forever.
+        //
+        this->open_.store(false);
+        this->response_queue_.close();
+        while (Optional<PendingResponse> pending = this->response_queue_.try_pop_next()) {
+            pending->fail(StatusCode::kClosed);
+            this->pipeline_depth_.fetch_sub(1);
+        }
+        this->context_.notify_load_changed();
     });
 
     for (;;) {
-        BATT_ASSIGN_OK_RESULT(Pin<HttpResponse> const response, this->response_queue_.await_next());
-        BATT_CHECK_NOT_NULLPTR(response);
+        BATT_ASSIGN_OK_RESULT(PendingResponse pending, this->response_queue_.await_next());
+
+        auto on_response_done = finally([this] {
+            this->pipeline_depth_.fetch_sub(1);
+            this->context_.notify_load_changed();
+        });
 
         pico_http::Response response_message;
         StatusOr<i32> message_length = this->read_next_response(response_message);
+        if (!message_length.ok()) {
+            pending.fail(message_length.status());
+        }
         BATT_REQUIRE_OK(message_length);
 
+        this->context_.latency().record(std::chrono::steady_clock::now() - pending.sent_time);
+
         ResponseInfo response_info(response_message);
+
+        Pin<HttpResponse> const response = pending.claim();
+        if (!response) {
+            // Another copy of this (hedged) request was answered first; discard this response.
+            //
+            this->input_buffer_.consume(*message_length);
+
+            if (!response_info.is_valid()) {
+                return StatusCode::kInvalidArgument;
+            }
+            if (response_info.keep_alive) {
+                Status data_consumed = response_info.get_data(this->input_buffer_) | seq::consume();
+                BATT_REQUIRE_OK(data_consumed);
+                continue;
+            }
+            boost::system::error_code ec;
+            this->socket_.close(ec);
+            return OkStatus();
+        }
         if (!response_info.is_valid()) {
             response->update_status(StatusCode::kInvalidArgument);
+            if (response->has_inline_handler()) {
+                response->invoke_inline_handler(Status{StatusCode::kInvalidArgument}, ConstBuffer{});
+            }
             response->state().close();
             return StatusCode::kInvalidArgument;
         }
 
+        // Inline delivery mode: hand the response straight to the consumer's handler, without waiting for
+        // the consumer task to pick it up.
+        //
+        if (response->has_inline_handler()) {
+            Status delivered =
+                this->deliver_inline(*response, response_message, *message_length, response_info);
+            BATT_REQUIRE_OK(delivered);
+
+            if (!response_info.keep_alive) {
+                boost::system::error_code ec;
+                this->socket_.close(ec);
+                return OkStatus();
+            }
+            continue;
+        }
+
         response->state().set_value(HttpResponse::kInitialized);
 
         // Pass control over to the consumer and wait for it to signal it is done reading the message headers.
@@ -202,30 +337,82 @@ BATT_INLINE_IMPL Status HttpClientConnection::process_responses()
 //
 BATT_INLINE_IMPL StatusOr<i32> HttpClientConnection::read_next_response(pico_http::Response& response)
 {
-    i32 result = 0;
-    usize min_to_fetch = 1;
-    for (;;) {
-        StatusOr<SmallVec<ConstBuffer, 2>> fetched = this->input_buffer_.fetch_at_least(min_to_fetch);
-        BATT_REQUIRE_OK(fetched);
-
-        auto& buffers = *fetched;
-        const usize n_bytes_fetched = boost::asio::buffer_size(buffers);
+    return read_http_message_header(this->input_buffer_, response);
+}
 
-        BATT_CHECK(!buffers.empty());
-        result = response.parse(buffers.front());
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Status HttpClientConnection::deliver_inline(HttpResponse& response,
+                                                             pico_http::Response& response_message,
+                                                             i32 message_length, ResponseInfo& response_info)
+{
+    const usize header_size = BATT_CHECKED_CAST(usize, message_length);
 
-        if (result == pico_http::kParseIncomplete) {
-            min_to_fetch = std::max(min_to_fetch + 1, n_bytes_fetched);
-            continue;
+    // The body can only be buffered if its length is known up front.
+    //
+    const Optional<usize> body_size = [&]() -> Optional<usize> {
+        if (response_info.chunked_encoding) {
+            return None;
         }
+        if (response_info.content_length) {
+            return response_info.content_length;
+        }
+        if (response_info.keep_alive) {
+            return 0;
+        }
+        return None;
+    }();
 
-        if (result == pico_http::kParseFailed) {
-            return {StatusCode::kInternal};
+    if (body_size == None || *body_size > response.inline_body_limit() ||
+        header_size + *body_size > this->input_buffer_.capacity()) {
+        //
+        // Report the response as too large and skip over it, so the connection can be reused.
+        //
+        this->input_buffer_.consume(message_length);
+
+        response.update_status(StatusCode::kOutOfRange);
+        response.invoke_inline_handler(Status{StatusCode::kOutOfRange}, ConstBuffer{});
+        response.state().set_value(HttpResponse::kConsumed);
+
+        if (!response_info.keep_alive) {
+            return OkStatus();
         }
+        return response_info.get_data(this->input_buffer_) | seq::consume();
+    }
 
-        BATT_CHECK_GT(result, 0);
-        return result;
+    // This doesn't block, since the message header was just parsed; it tells us where the parsed header
+    // lives.
+    //
+    StatusOr<SmallVec<ConstBuffer, 2>> header = this->input_buffer_.fetch_at_least(message_length);
+    BATT_REQUIRE_OK(header);
+
+    const void* const header_data = header->front().data();
+
+    // Wait for the entire body to arrive.  The first buffer returned is always contiguous.
+    //
+    StatusOr<SmallVec<ConstBuffer, 2>> fetched =
+        this->input_buffer_.fetch_at_least(BATT_CHECKED_CAST(i64, header_size + *body_size));
+    BATT_REQUIRE_OK(fetched);
+
+    const ConstBuffer& message_buffer = fetched->front();
+
+    // If the header and body wrap around the end of the input buffer, they are copied to a temporary
+    // buffer, which may invalidate the strings in `response_message`; parse the header again from the copy.
+    //
+    if (message_buffer.data() != header_data) {
+        BATT_CHECK_EQ(response_message.parse(static_cast<const char*>(message_buffer.data()), header_size),
+                      message_length);
     }
+
+    const ConstBuffer body{static_cast<const char*>(message_buffer.data()) + header_size, *body_size};
+
+    response.invoke_inline_handler(response_message, body);
+
+    this->input_buffer_.consume(BATT_CHECKED_CAST(i64, header_size + *body_size));
+
+    response.state().set_value(HttpResponse::kConsumed);
+
+    return OkStatus();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -240,16 +427,16 @@ BATT_INLINE_IMPL void HttpClientConnection::join()
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-HttpClientConnection::ResponseInfo::ResponseInfo(const pico_http::Response& response)
-    : content_length{find_header(response.headers, "Content-Length").flat_map([](std::string_view s) {
+BATT_INLINE_IMPL HttpClientConnection::ResponseInfo::ResponseInfo(const pico_http::Response& response)
+    : content_length{find_header(response, KnownHeader::kContentLength).flat_map([](std::string_view s) {
         return Optional{from_string<usize>(std::string(s))};
     })}
-    , keep_alive{find_header(response.headers, "Connection")
+    , keep_alive{find_header(response, KnownHeader::kConnection)
                      .map([](std::string_view s) {
                          return s == "keep-alive";
                      })
                      .value_or(response.major_version == 1 && response.minor_version >= 1)}
-    , chunked_encoding{find_header(response.headers, "Transfer-Encoding")
+    , chunked_encoding{find_header(response, KnownHeader::kTransferEncoding)
                            .map([](std::string_view s) {
                                return s == "chunked";
                            })
@@ -260,7 +447,7 @@ HttpClientConnection::ResponseInfo::ResponseInfo(const pico_http::Response& resp
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-HttpData HttpClientConnection::ResponseInfo::get_data(StreamBuffer& input_buffer)
+BATT_INLINE_IMPL HttpData HttpClientConnection::ResponseInfo::get_data(StreamBuffer& input_buffer)
 {
     return HttpData{[&]() -> BufferSource {
         if (this->content_length == None) {
@@ -8,6 +8,8 @@
 #include <batteries/config.hpp>
 
 #include <batteries/http/http_client_connection_decl.hpp>
+#include <batteries/http/http_latency_window.hpp>
+#include <batteries/http/http_request_hedge.hpp>
 
 #include <batteries/async/queue.hpp>
 #include <batteries/async/task.hpp>
@@ -18,6 +20,8 @@
 #include <batteries/shared_ptr.hpp>
 #include <batteries/small_vec.hpp>
 
+#include <algorithm>
+#include <memory>
 #include <tuple>
 
 namespace batt {
@@ -31,10 +35,20 @@ class HttpClientHostContext : public RefCounted<HttpClientHostContext>
    public:
     static constexpr usize kDefaultMaxConnections = 2;
 
+    // A request waiting to be picked up by a connection.  For a copy of a hedged request, `request` and
+    // `response` are null and `hedge` is set instead.
+    //
+    using PendingRequest = std::tuple<Pin<HttpRequest>, Pin<HttpResponse>, SharedPtr<HttpRequestHedge>>;
+
     //+++++++++++-+-+--+----- --- -- -  -  -   -
 
     explicit HttpClientHostContext(HttpClient& client, const HostAddress& host_address);
 
+    // Creates a host context whose task, and the tasks of all its connections, run on `io`.
+    //
+    explicit HttpClientHostContext(HttpClient& client, const HostAddress& host_address,
+                                   boost::asio::io_context& io);
+
     //+++++++++++-+-+--+----- --- -- -  -  -   -
 
     boost::asio::io_context& get_io_context();
@@ -46,18 +60,46 @@ class HttpClientHostContext : public RefCounted<HttpClientHostContext>
 
     Status submit_request(Pin<HttpRequest>&& request, Pin<HttpResponse>&& response)
     {
-        this->request_queue_.push(std::make_tuple(std::move(request), std::move(response)));
+        if (!this->request_queue_.push(std::move(request), std::move(response),
+                                       /*hedge=*/SharedPtr<HttpRequestHedge>{})) {
+            return {StatusCode::kClosed};
+        }
         return OkStatus();
     }
 
+    // Queues one copy of a hedged request; may be called more than once per `hedge`.
+    //
+    Status submit_request(const SharedPtr<HttpRequestHedge>& hedge)
+    {
+        if (!this->request_queue_.push(Pin<HttpRequest>{}, Pin<HttpResponse>{}, hedge)) {
+            return {StatusCode::kClosed};
+        }
+        return OkStatus();
+    }
+
+    // Stops accepting new requests.  Requests already being processed by a connection are completed; those
+    // still waiting in the queue fail with StatusCode::kClosed.
+    //
+    void halt()
+    {
+        this->request_queue_.close();
+        this->load_changed_.close();
+    }
+
     void join()
     {
         this->task_.join();
     }
 
+    // Closed connections don't count against the limit, so that they are replaced when needed.
+    //
     bool can_grow() const
     {
-        return this->connection_tasks_.size() < this->max_connections_.get_value();
+        const auto n_open = std::count_if(this->connection_tasks_.begin(), this->connection_tasks_.end(),
+                                          [](const std::unique_ptr<HttpClientConnection>& connection) {
+                                              return connection->is_open();
+                                          });
+        return BATT_CHECKED_CAST(usize, n_open) < this->max_connections_.get_value();
     }
 
     const HostAddress& host_address() const
@@ -65,11 +107,34 @@ class HttpClientHostContext : public RefCounted<HttpClientHostContext>
         return this->host_address_;
     }
 
-    StatusOr<std::tuple<Pin<HttpRequest>, Pin<HttpResponse>>> await_next_request()
+    StatusOr<PendingRequest> await_next_request()
     {
         return this->request_queue_.await_next();
     }
 
+    // The latency (from sending a request to receiving the response header) of recent requests to this
+    // host.
+    //
+    HttpLatencyWindow& latency()
+    {
+        return this->latency_;
+    }
+
+    // Blocks until no other open connection to this host has fewer outstanding requests than `connection`
+    // (and, if `connection` has any, until no more connections can be created), so that new requests go to
+    // the least loaded connection.  Returns kClosed if `connection` is closed while waiting, so that a dead
+    // connection doesn't take any more requests.
+    //
+    Status await_least_loaded(const HttpClientConnection& connection);
+
+    // Wakes up connections blocked in `await_least_loaded`; must be called whenever a connection's
+    // `pipeline_depth()` changes, or a connection is opened or closed.
+    //
+    void notify_load_changed()
+    {
+        this->load_changed_.fetch_add(1);
+    }
+
    private:
     void host_task_main();
 
@@ -79,12 +144,20 @@ class HttpClientHostContext : public RefCounted<HttpClientHostContext>
 
     HttpClient& client_;
 
+    boost::asio::io_context& io_;
+
     HostAddress host_address_;
 
-    Queue<std::tuple<Pin<HttpRequest>, Pin<HttpResponse>>> request_queue_;
+    Queue<PendingRequest> request_queue_;
 
     Watch<usize> max_connections_{HttpClientHostContext::kDefaultMaxConnections};
 
+    // Incremented by `notify_load_changed`.
+    //
+    Watch<u64> load_changed_{0};
+
+    HttpLatencyWindow latency_;
+
     Task task_;
 
     SmallVec<std::unique_ptr<HttpClientConnection>, HttpClientHostContext::kDefaultMaxConnections>
@@ -10,15 +10,27 @@
 #include <batteries/http/http_client.hpp>
 #include <batteries/http/http_client_host_context.hpp>
 
+#include <algorithm>
+
 namespace batt {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 BATT_INLINE_IMPL /*explicit*/ HttpClientHostContext::HttpClientHostContext(HttpClient& client,
                                                                            const HostAddress& host_addr)
+    : HttpClientHostContext{client, host_addr, client.get_io_context()}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL /*explicit*/ HttpClientHostContext::HttpClientHostContext(HttpClient& client,
+                                                                           const HostAddress& host_addr,
+                                                                           boost::asio::io_context& io)
     : client_{client}
+    , io_{io}
     , host_address_{host_addr}
-    , task_{this->client_.get_io_context().get_executor(), [this] {
+    , task_{this->io_.get_executor(), [this] {
                 this->host_task_main();
             }}
 {
@@ -28,7 +40,7 @@ BATT_INLINE_IMPL /*explicit*/ HttpClientHostContext::HttpClientHostContext(HttpC
 //
 BATT_INLINE_IMPL boost::asio::io_context& HttpClientHostContext::get_io_context()
 {
-    return this->client_.get_io_context();
+    return this->io_;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -40,6 +52,22 @@ BATT_INLINE_IMPL void HttpClientHostContext::host_task_main()
             for (auto& connection : this->connection_tasks_) {
                 connection->join();
             }
+            // Fail any requests that were still queued when the context was halted, so their submitters
+            // don't wait forever.
+            //
+            while (Optional<PendingRequest> next = this->request_queue_.try_pop_next()) {
+                auto& [request, response, hedge] = *next;
+                if (hedge) {
+                    response = hedge->fail_copy();
+                    if (response) {
+                        response->fail(StatusCode::kClosed);
+                    }
+                    continue;
+                }
+                response->fail(StatusCode::kClosed);
+                request->update_status(StatusCode::kClosed);
+                request->state().close();
+            }
         });
         for (;;) {
             const usize queue_depth = this->request_queue_.size();
@@ -56,6 +84,36 @@ BATT_INLINE_IMPL void HttpClientHostContext::host_task_main()
     status.IgnoreError();  // TODO [tastolfi 2022-03-17] do something better!
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Status HttpClientHostContext::await_least_loaded(const HttpClientConnection& connection)
+{
+    for (;;) {
+        const u64 last_seen = this->load_changed_.get_value();
+
+        if (!connection.is_open()) {
+            return StatusCode::kClosed;
+        }
+
+        // A busy connection also holds off while there's room for a new (idle) connection.
+        //
+        const i64 load = connection.pipeline_depth();
+        const bool is_least_loaded =
+            (load == 0 || !this->can_grow()) &&
+            std::none_of(this->connection_tasks_.begin(), this->connection_tasks_.end(),
+                         [&](const std::unique_ptr<HttpClientConnection>& other) {
+                             return other->is_open() && other->pipeline_depth() < load;
+                         });
+
+        if (is_least_loaded) {
+            return OkStatus();
+        }
+
+        StatusOr<u64> changed = this->load_changed_.await_not_equal(last_seen);
+        BATT_REQUIRE_OK(changed);
+    }
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 BATT_INLINE_IMPL void HttpClientHostContext::create_connection()
@@ -65,6 +123,7 @@ BATT_INLINE_IMPL void HttpClientHostContext::create_connection()
     connection->start();
 
     this->connection_tasks_.emplace_back(std::move(connection));
+    this->notify_load_changed();
 }
 
 }  // namespace batt
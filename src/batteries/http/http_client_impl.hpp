@@ -9,6 +9,14 @@
 //
 namespace batt {
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL HttpClient::~HttpClient() noexcept
+{
+    this->halt();
+    this->join();
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 BATT_INLINE_IMPL Status HttpClient::submit_request(const HostAddress& host_address,
@@ -17,21 +25,121 @@ BATT_INLINE_IMPL Status HttpClient::submit_request(const HostAddress& host_addre
     BATT_CHECK_NOT_NULLPTR(request);
     BATT_CHECK_NOT_NULLPTR(response);
 
-    SharedPtr<HttpClientHostContext> host_context = [&] {
-        auto locked_contexts = this->host_contexts_.lock();
+    SharedPtr<HttpClientHostContext> host_context = this->get_host_context(host_address);
+
+    return host_context->submit_request(std::move(request), std::move(response));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Status HttpClient::submit_hedged_request(const HostAddress& host_address,
+                                                          const SharedPtr<HttpRequestHedge>& hedge,
+                                                          std::chrono::nanoseconds delay)
+{
+    BATT_CHECK_NOT_NULLPTR(hedge);
+
+    SharedPtr<HttpClientHostContext> host_context = this->get_host_context(host_address);
 
-        auto iter = locked_contexts->find(host_address);
-        if (iter == locked_contexts->end()) {
-            iter = locked_contexts
-                       ->emplace(host_address,
-                                 make_shared<HttpClientHostContext>(/*client=*/*this, host_address))
-                       .first;
+    // Each copy counts as outstanding from the time it is queued or scheduled, so that the request only
+    // fails once no copy is left that might still succeed.
+    //
+    hedge->add_copy();
+    Status status = host_context->submit_request(hedge);
+    BATT_REQUIRE_OK(status);
+
+    hedge->add_copy();
+    hedge->schedule(host_context->get_io_context(), delay, [host_context, hedge](const ErrorCode& ec) {
+        if (!ec && !hedge->is_claimed() && host_context->submit_request(hedge).ok()) {
+            return;
         }
 
-        return iter->second;
-    }();
+        // The second copy won't be sent after all.
+        //
+        Pin<HttpResponse> const response = hedge->fail_copy();
+        if (response) {
+            response->fail(StatusCode::kClosed);
+        }
+    });
 
-    return host_context->submit_request(std::move(request), std::move(response));
+    return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Optional<std::chrono::nanoseconds> HttpClient::hedge_delay(const HostAddress& host_address)
+{
+    const HttpHedgingPolicy& policy = this->hedging_policy_;
+    if (!policy.enabled) {
+        return None;
+    }
+
+    Optional<std::chrono::nanoseconds> latency =
+        this->get_host_context(host_address)
+            ->latency()
+            .percentile(policy.latency_percentile, std::max<usize>(policy.min_samples, 1));
+
+    return latency.map([&](std::chrono::nanoseconds latency) {
+        return std::max(latency, policy.min_delay);
+    });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL SharedPtr<HttpClientHostContext> HttpClient::get_host_context(
+    const HostAddress& host_address)
+{
+    const usize shard_i = boost::hash<HostAddress>{}(host_address) % kHostContextShardCount;
+
+    auto locked_contexts = this->host_contexts_[shard_i].lock();
+
+    auto iter = locked_contexts->find(host_address);
+    if (iter == locked_contexts->end()) {
+        iter = locked_contexts
+                   ->emplace(host_address, batt::make_shared<HttpClientHostContext>(
+                                               /*client=*/*this, host_address, this->next_io_context()))
+                   .first;
+    }
+
+    return iter->second;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL boost::asio::io_context& HttpClient::next_io_context()
+{
+    const usize i = this->next_io_index_.fetch_add(1);
+
+    return *this->io_[i % this->io_.size()];
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void HttpClient::halt()
+{
+    for (auto& shard : this->host_contexts_) {
+        auto locked_contexts = shard.lock();
+        for (auto& [host_address, host_context] : *locked_contexts) {
+            host_context->halt();
+        }
+    }
+    this->resolver_cache_.halt();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void HttpClient::join()
+{
+    for (auto& shard : this->host_contexts_) {
+        HostContextMap joined;
+        {
+            auto locked_contexts = shard.lock();
+            std::swap(joined, *locked_contexts);
+        }
+        for (auto& [host_address, host_context] : joined) {
+            host_context->join();
+        }
+    }
+    this->resolver_cache_.join();
 }
 
 }  // namespace batt
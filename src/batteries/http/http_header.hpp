@@ -9,15 +9,25 @@
 //
 #include <batteries/pico_http/parser.hpp>
 
+#include <batteries/optional.hpp>
+#include <batteries/small_vec.hpp>
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
 namespace batt {
 
 using HttpHeader = ::pico_http::MessageHeader;
+using ::pico_http::KnownHeader;
 
+// Returns the value of the first header in `headers` called `name` (compared case-insensitively), or None.
+//
 inline Optional<std::string_view> find_header(const SmallVecBase<HttpHeader>& headers,
                                               const std::string_view& name)
 {
     const auto iter = std::find_if(headers.begin(), headers.end(), [&](const HttpHeader& hdr) {
-        return hdr.name == name;
+        return ::pico_http::header_name_equals(hdr.name, name);
     });
     if (iter == headers.end()) {
         return None;
@@ -25,6 +35,33 @@ inline Optional<std::string_view> find_header(const SmallVecBase<HttpHeader>& he
     return iter->value;
 }
 
+// Returns the value of the first `header` in a parsed pico_http::Request or pico_http::Response, or None.
+// Uses the message's header index, so this is O(1) unless headers were added to the message after parsing.
+//
+template <typename Message, typename = decltype(std::declval<const Message&>().header_index)>
+inline Optional<std::string_view> find_header(const Message& message, KnownHeader header)
+{
+    if (message.header_index.indexed_count() != message.headers.size()) {
+        return find_header(message.headers, ::pico_http::known_header_name(header));
+    }
+    const Optional<usize> pos = message.header_index.find(header);
+    if (!pos) {
+        return None;
+    }
+    return message.headers[*pos].value;
+}
+
+// Like `find_header(message.headers, name)`, but O(1) if `name` is a KnownHeader.
+//
+template <typename Message, typename = decltype(std::declval<const Message&>().header_index)>
+inline Optional<std::string_view> find_header(const Message& message, const std::string_view& name)
+{
+    if (Optional<KnownHeader> header = ::pico_http::classify_header_name(name)) {
+        return find_header(message, *header);
+    }
+    return find_header(message.headers, name);
+}
+
 }  // namespace batt
 
 #endif  // BATTERIES_HTTP_HEADER_HPP
@@ -0,0 +1,61 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/http/http_header.hpp>
+//
+#include <batteries/http/http_header.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string_view>
+
+namespace {
+
+using namespace batt::int_types;
+
+const std::string_view kRequestText =
+    "GET / HTTP/1.1\r\n"
+    "host: example.test\r\n"
+    "X-Request-Id: 1234\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n";
+
+TEST(HttpHeaderTest, FindHeaderIsCaseInsensitive)
+{
+    pico_http::Request request;
+    ASSERT_EQ(request.parse(kRequestText.data(), kRequestText.size()), (int)kRequestText.size());
+
+    for (const char* name : {"Host", "host", "HOST"}) {
+        EXPECT_EQ(batt::find_header(request.headers, name), std::string_view{"example.test"}) << name;
+        EXPECT_EQ(batt::find_header(request, name), std::string_view{"example.test"}) << name;
+    }
+    for (const char* name : {"X-Request-Id", "x-request-id"}) {
+        EXPECT_EQ(batt::find_header(request.headers, name), std::string_view{"1234"}) << name;
+        EXPECT_EQ(batt::find_header(request, name), std::string_view{"1234"}) << name;
+    }
+
+    EXPECT_EQ(batt::find_header(request, batt::KnownHeader::kTransferEncoding), std::string_view{"chunked"});
+    EXPECT_EQ(batt::find_header(request, batt::KnownHeader::kContentLength), batt::None);
+    EXPECT_EQ(batt::find_header(request, "X-Missing"), batt::None);
+}
+
+TEST(HttpHeaderTest, HeadersAddedAfterParsingAreFound)
+{
+    pico_http::Request request;
+    ASSERT_EQ(request.parse(kRequestText.data(), kRequestText.size()), (int)kRequestText.size());
+
+    request.headers.push_back(batt::HttpHeader{"Content-Length", "0"});
+
+    EXPECT_EQ(batt::find_header(request, batt::KnownHeader::kContentLength), std::string_view{"0"});
+    EXPECT_EQ(batt::find_header(request, batt::KnownHeader::kHost), std::string_view{"example.test"});
+
+    // A message built by hand (never parsed) falls back to scanning.
+    //
+    pico_http::Response response;
+    response.headers.push_back(batt::HttpHeader{"Connection", "close"});
+
+    EXPECT_EQ(batt::find_header(response, batt::KnownHeader::kConnection), std::string_view{"close"});
+}
+
+}  // namespace
@@ -0,0 +1,94 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_HTTP_HTTP_LATENCY_WINDOW_HPP
+#define BATTERIES_HTTP_HTTP_LATENCY_WINDOW_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/async/mutex.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/int_types.hpp>
+#include <batteries/optional.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+
+namespace batt {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// The most recent `kCapacity` latency samples observed for a host, used to pick the delay after which a
+// request is hedged (see HttpHedgingPolicy).
+//
+class HttpLatencyWindow
+{
+   public:
+    using Duration = std::chrono::nanoseconds;
+
+    static constexpr usize kCapacity = 256;
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+    // Adds a sample, replacing the oldest one once the window is full.
+    //
+    void record(Duration latency)
+    {
+        auto locked = this->state_.lock();
+
+        locked->samples[locked->next % kCapacity] = latency.count();
+        locked->next += 1;
+    }
+
+    // The number of samples currently in the window.
+    //
+    usize size()
+    {
+        return std::min(this->state_.lock()->next, kCapacity);
+    }
+
+    // Returns the sample at fraction `p` (0.0 - 1.0) of the sorted window, e.g. 0.99 for the 99th
+    // percentile; returns None if there are fewer than `min_samples` (and at least one) samples.
+    //
+    Optional<Duration> percentile(double p, usize min_samples = 1)
+    {
+        BATT_CHECK_GE(p, 0.0);
+        BATT_CHECK_LE(p, 1.0);
+
+        std::array<i64, kCapacity> sorted;
+        usize count = 0;
+        {
+            auto locked = this->state_.lock();
+
+            count = std::min(locked->next, kCapacity);
+            std::copy(locked->samples.begin(), locked->samples.begin() + count, sorted.begin());
+        }
+        if (count == 0 || count < min_samples) {
+            return None;
+        }
+
+        // Nearest-rank method: the smallest sample that is >= `p` of all samples.
+        //
+        const usize nearest_rank = static_cast<usize>(std::ceil(p * count));
+        const usize rank = (nearest_rank == 0) ? 0 : std::min(nearest_rank, count) - 1;
+
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + count);
+
+        return Duration{sorted[rank]};
+    }
+
+   private:
+    struct State {
+        std::array<i64, kCapacity> samples;
+        usize next = 0;
+    };
+
+    Mutex<State> state_;
+};
+
+}  // namespace batt
+
+#endif  // BATTERIES_HTTP_HTTP_LATENCY_WINDOW_HPP
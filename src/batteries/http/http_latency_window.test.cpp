@@ -0,0 +1,57 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/http/http_latency_window.hpp>
+//
+#include <batteries/http/http_latency_window.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+using namespace batt::int_types;
+
+using Duration = batt::HttpLatencyWindow::Duration;
+
+TEST(HttpLatencyWindowTest, Percentile)
+{
+    batt::HttpLatencyWindow window;
+
+    EXPECT_EQ(window.size(), 0u);
+    EXPECT_EQ(window.percentile(0.5), batt::None);
+
+    // Record 1..100 in a scrambled order.
+    //
+    for (i64 i = 0; i < 100; ++i) {
+        window.record(Duration{(i * 37) % 100 + 1});
+    }
+
+    EXPECT_EQ(window.size(), 100u);
+    EXPECT_EQ(window.percentile(0.0), Duration{1});
+    EXPECT_EQ(window.percentile(0.5), Duration{50});
+    EXPECT_EQ(window.percentile(0.95), Duration{95});
+    EXPECT_EQ(window.percentile(0.99), Duration{99});
+    EXPECT_EQ(window.percentile(1.0), Duration{100});
+
+    EXPECT_EQ(window.percentile(0.5, /*min_samples=*/100), Duration{50});
+    EXPECT_EQ(window.percentile(0.5, /*min_samples=*/101), batt::None);
+}
+
+TEST(HttpLatencyWindowTest, OldestSamplesAreReplaced)
+{
+    batt::HttpLatencyWindow window;
+
+    for (usize i = 0; i < batt::HttpLatencyWindow::kCapacity; ++i) {
+        window.record(Duration{1000});
+    }
+    EXPECT_EQ(window.percentile(0.0), Duration{1000});
+
+    for (usize i = 0; i < batt::HttpLatencyWindow::kCapacity; ++i) {
+        window.record(Duration{10});
+    }
+    EXPECT_EQ(window.size(), batt::HttpLatencyWindow::kCapacity);
+    EXPECT_EQ(window.percentile(1.0), Duration{10});
+}
+
+}  // namespace
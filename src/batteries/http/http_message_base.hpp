@@ -11,6 +11,7 @@
 #include <batteries/http/http_header.hpp>
 
 #include <batteries/async/channel.hpp>
+#include <batteries/async/handler.hpp>
 #include <batteries/async/pin.hpp>
 #include <batteries/async/task.hpp>
 #include <batteries/async/watch.hpp>
@@ -67,9 +68,10 @@ class HttpMessageBase : public Pinnable
 
     void async_set_message(Message& message)
     {
-        this->message_.async_write(message, [](Status status) {
-            status.IgnoreError();
-        });
+        this->message_.async_write(message,
+                                   make_custom_alloc_handler(this->set_message_memory_, [](Status status) {
+                                       status.IgnoreError();
+                                   }));
     }
 
     Status await_set_message(Message& message)
@@ -98,9 +100,9 @@ class HttpMessageBase : public Pinnable
 
     void async_set_data(HttpData& data)
     {
-        this->data_.async_write(data, [](Status status) {
-            status.IgnoreError();
-        });
+        this->data_.async_write(data, make_custom_alloc_handler(this->set_data_memory_, [](Status status) {
+                                    status.IgnoreError();
+                                }));
     }
 
     Status await_set_data(HttpData& data)
@@ -121,21 +123,71 @@ class HttpMessageBase : public Pinnable
         }
     }
 
+    // Fails all current and future calls to set/await the message or data of this object, and closes the
+    // state.  Used to unblock the other side of the exchange when one side gives up on it.
+    //
+    void close()
+    {
+        this->message_.close_for_read();
+        this->message_.close_for_write();
+        this->data_.close_for_read();
+        this->data_.close_for_write();
+        this->state_.close();
+    }
+
     //+++++++++++-+-+--+----- --- -- -  -  -   -
 
-    const SmallVecBase<HttpHeader>& headers() const
+    // Returns this object to the kCreated state so it can be used for another message (see
+    // HttpObjectPool).  Releases any message/data that is still active and waits for all other pins to be
+    // released first.
+    //
+    // Returns false if the object can't be reused because it was closed due to an error; it must be
+    // destroyed instead.
+    //
+    bool reset()
+    {
+        this->release_message();
+        this->release_data();
+
+        while (this->is_pinned()) {
+            Task::yield();
+        }
+
+        if (this->state_.is_closed()) {
+            return false;
+        }
+        this->status_ = OkStatus();
+        this->state_.set_value(kCreated);
+
+        return true;
+    }
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+    const SmallVecBase<HttpHeader>& headers()
     {
         return this->await_message_or_panic().headers;
     }
 
-    Optional<std::string_view> find_header(const std::string_view& name) const
+    Optional<std::string_view> find_header(const std::string_view& name)
     {
-        return ::batt::find_header(this->headers(), name);
+        return ::batt::find_header(this->await_message_or_panic(), name);
+    }
+
+    Optional<std::string_view> find_header(KnownHeader header)
+    {
+        return ::batt::find_header(this->await_message_or_panic(), header);
     }
 
     //+++++++++++-+-+--+----- --- -- -  -  -   -
 
    protected:
+    // Storage for the completion handlers of async_set_message/async_set_data, so that handing off the
+    // message and data doesn't allocate.  (There is at most one outstanding write per Channel.)
+    //
+    HandlerMemory<128> set_message_memory_;
+    HandlerMemory<128> set_data_memory_;
+
     Status status_{OkStatus()};
 
     Watch<i32> state_{kCreated};
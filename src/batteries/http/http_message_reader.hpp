@@ -0,0 +1,76 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_HTTP_HTTP_MESSAGE_READER_HPP
+#define BATTERIES_HTTP_HTTP_MESSAGE_READER_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/async/stream_buffer.hpp>
+#include <batteries/pico_http/parser.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/buffer.hpp>
+#include <batteries/int_types.hpp>
+#include <batteries/status.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+#include <algorithm>
+
+namespace batt {
+
+/*! \brief Parses the start line and headers of an HTTP message (`pico_http::Request` or
+ * `pico_http::Response`) from the front of `input`, waiting for more data as necessary.  Does not consume the
+ * parsed data; the returned length (in bytes) of the message header should be passed to `input.consume`
+ * once the caller is done with the parsed message.
+ *
+ * The parse is resumable: whenever the header block is incomplete, this function waits until strictly more
+ * data has arrived, then passes the number of bytes already seen to the parser as the `last_len` hint, so
+ * that only the new bytes are scanned for the end of the header block.  The full parse is only done once
+ * the header block is known to be complete, so total parse work is linear in the size of the message
+ * header no matter how slowly it arrives.
+ *
+ * Returns StatusCode::kInternal if the message is malformed.
+ */
+template <typename Message>
+inline StatusOr<i32> read_http_message_header(StreamBuffer& input, Message& message)
+{
+    usize min_to_fetch = 1;
+    usize last_len = 0;
+
+    for (;;) {
+        StatusOr<SmallVec<ConstBuffer, 2>> fetched = input.fetch_at_least(min_to_fetch);
+        BATT_REQUIRE_OK(fetched);
+
+        BATT_CHECK(!fetched->empty());
+
+        // fetch_at_least guarantees the first buffer is at least `min_to_fetch` bytes; the message header
+        // must be contiguous to be parsed, so only look at the first buffer.
+        //
+        const ConstBuffer& buffer = fetched->front();
+        const i32 result = message.parse(static_cast<const char*>(buffer.data()), buffer.size(), last_len);
+
+        if (result == pico_http::kParseIncomplete) {
+            // If the buffered data wraps around the end of the StreamBuffer, `buffer` is a copy of just the
+            // first `min_to_fetch` bytes; ask for everything that is already buffered next time, so we only
+            // block (and copy) again once new data arrives.
+            //
+            last_len = buffer.size();
+            min_to_fetch = std::max(last_len + 1, boost::asio::buffer_size(*fetched));
+            continue;
+        }
+
+        if (result == pico_http::kParseFailed) {
+            return {StatusCode::kInternal};
+        }
+
+        BATT_CHECK_GT(result, 0);
+        return result;
+    }
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_HTTP_HTTP_MESSAGE_READER_HPP
@@ -0,0 +1,170 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/http/http_message_reader.hpp>
+//
+#include <batteries/http/http_message_reader.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <batteries/async/task.hpp>
+#include <batteries/finally.hpp>
+
+#include <boost/asio/io_context.hpp>
+
+#include <string>
+
+namespace {
+
+using namespace batt::int_types;
+
+std::string make_header_block(const std::string& start_line, usize n_headers)
+{
+    std::string s = start_line + "\r\n";
+    for (usize i = 0; i < n_headers; ++i) {
+        s += "X-Header-" + std::to_string(i) + ": value-" + std::to_string(i * 7) + "\r\n";
+    }
+    s += "\r\n";
+    return s;
+}
+
+// Writes `data` to `buffer` a few bytes at a time, yielding in between so the reader sees each partial
+// message, then runs `read_fn` on the other end.
+//
+template <typename ReadFn>
+void trickle_and_read(batt::StreamBuffer& buffer, const std::string& data, usize step, ReadFn&& read_fn)
+{
+    boost::asio::io_context io;
+
+    batt::Task writer{io.get_executor(), [&] {
+                          for (usize offset = 0; offset < data.size(); offset += step) {
+                              const usize n = std::min(step, data.size() - offset);
+                              ASSERT_TRUE(buffer.write_all(batt::ConstBuffer{data.data() + offset, n}).ok());
+                              batt::Task::yield();
+                          }
+                      }};
+
+    batt::Task reader{io.get_executor(), BATT_FORWARD(read_fn)};
+
+    io.run();
+    writer.join();
+    reader.join();
+}
+
+TEST(HttpMessageReaderTest, ResponseTrickledIn)
+{
+    const std::string header = make_header_block("HTTP/1.1 200 OK", 50);
+    const std::string body = "body!";
+
+    for (usize step : {1, 3, 17, 4096}) {
+        batt::StreamBuffer buffer{8192};
+        pico_http::Response response;
+        batt::StatusOr<i32> result;
+
+        trickle_and_read(buffer, header + body, step, [&] {
+            result = batt::read_http_message_header(buffer, response);
+        });
+
+        ASSERT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+        EXPECT_EQ(*result, (i32)header.size());
+        EXPECT_EQ(response.status, 200);
+        EXPECT_THAT(response.message, ::testing::StrEq("OK"));
+        ASSERT_EQ(response.headers.size(), 50u);
+        EXPECT_THAT(response.headers[49].name, ::testing::StrEq("X-Header-49"));
+        EXPECT_THAT(response.headers[49].value, ::testing::StrEq("value-343"));
+
+        // The header is not consumed.
+        //
+        EXPECT_EQ(buffer.size(), header.size() + body.size());
+    }
+}
+
+TEST(HttpMessageReaderTest, RequestTrickledIn)
+{
+    const std::string header = make_header_block("POST /some/path HTTP/1.1", 20);
+
+    for (usize step : {1, 5, 4096}) {
+        batt::StreamBuffer buffer{4096};
+        pico_http::Request request;
+        batt::StatusOr<i32> result;
+
+        trickle_and_read(buffer, header, step, [&] {
+            result = batt::read_http_message_header(buffer, request);
+        });
+
+        ASSERT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+        EXPECT_EQ(*result, (i32)header.size());
+        EXPECT_THAT(request.method, ::testing::StrEq("POST"));
+        EXPECT_THAT(request.path, ::testing::StrEq("/some/path"));
+        EXPECT_EQ(request.headers.size(), 20u);
+    }
+}
+
+// Wraps a pico_http::Response to count the number of times the header is (re-)parsed; each parse follows
+// one call to StreamBuffer::fetch_at_least.
+//
+struct CountParseCalls {
+    int parse(const char* buf, usize len, usize last_len)
+    {
+        this->count += 1;
+        return this->response.parse(buf, len, last_len);
+    }
+
+    pico_http::Response response;
+    usize count = 0;
+};
+
+TEST(HttpMessageReaderTest, HeaderWrapsRingBuffer)
+{
+    const std::string header = make_header_block("HTTP/1.1 200 OK", 20);
+
+    for (usize split : {usize{1}, usize{16}, header.size() / 2, header.size() - 1}) {
+        batt::StreamBuffer buffer{header.size() + 64};
+
+        // Advance the ring so that only the first `split` bytes of the header fit before the wrap point.
+        //
+        const usize filler_size = buffer.capacity() - split;
+        const std::string filler(filler_size, 'x');
+        ASSERT_TRUE(buffer.write_all(batt::as_const_buffer(filler)).ok());
+        ASSERT_TRUE(buffer.fetch_at_least(filler_size).ok());
+        buffer.consume(filler_size);
+
+        ASSERT_TRUE(buffer.write_all(batt::as_const_buffer(header)).ok());
+
+        CountParseCalls message;
+        batt::StatusOr<i32> result = batt::read_http_message_header(buffer, message);
+
+        ASSERT_TRUE(result.ok()) << BATT_INSPECT(result.status()) << BATT_INSPECT(split);
+        EXPECT_EQ(*result, (i32)header.size());
+        EXPECT_EQ(message.response.status, 200);
+        EXPECT_EQ(message.response.headers.size(), 20u);
+
+        // Once for the part before the wrap point, once for the whole (copied) header.
+        //
+        EXPECT_LE(message.count, 2u) << BATT_INSPECT(split);
+    }
+}
+
+TEST(HttpMessageReaderTest, ErrorCases)
+{
+    {
+        batt::StreamBuffer buffer{1024};
+        pico_http::Request request;
+
+        ASSERT_TRUE(buffer.write_all(batt::as_const_buffer("NOT AN HTTP REQUEST\r\n\r\n")).ok());
+
+        EXPECT_EQ(batt::read_http_message_header(buffer, request).status(), batt::StatusCode::kInternal);
+    }
+    {
+        batt::StreamBuffer buffer{1024};
+        pico_http::Response response;
+
+        ASSERT_TRUE(buffer.write_all(batt::as_const_buffer("HTTP/1.1 200 OK\r\nContent-")).ok());
+        buffer.close_for_write();
+
+        EXPECT_EQ(batt::read_http_message_header(buffer, response).status(), batt::StatusCode::kEndOfStream);
+    }
+}
+
+}  // namespace
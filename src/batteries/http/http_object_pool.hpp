@@ -0,0 +1,147 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_HTTP_HTTP_OBJECT_POOL_HPP
+#define BATTERIES_HTTP_HTTP_OBJECT_POOL_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/http/http_request.hpp>
+#include <batteries/http/http_response.hpp>
+
+#include <batteries/async/mutex.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/int_types.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace batt {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// A free list of reusable objects (HttpRequest, HttpResponse, ...), so that a steady-state
+// request/response cycle doesn't need to allocate them, or the header storage and buffers they own.
+//
+// `T` must be default-constructible and have a member function `bool reset()`, which returns the object to
+// its initial state, keeping any storage it owns, or returns false if the object can't be reused.
+//
+// Objects are handed out as `HttpObjectPool<T>::Ptr`, which returns the object to the pool when it goes out
+// of scope; the pool must outlive all of the objects it hands out.
+//
+// Once warmed up, acquiring, filling and recycling a pooled object does no heap allocation (see
+// http_object_pool.test.cpp).  A full http_request call still allocates in a few places that the pools don't
+// cover:
+//
+//  - the HttpResponse that http_request returns when the caller doesn't pass one (pass one acquired from an
+//    HttpResponsePool instead)
+//  - the HttpRequestHedge of a hedged request
+//  - the Queue entries that hand a request to its host context and connection (the queues' storage grows in
+//    blocks, so this is amortized, not per-request)
+//  - asio's per-operation state for socket reads and writes, which asio usually recycles itself
+//
+// The Tasks (and stacks) that serve a connection are allocated once per connection, not per request.
+//
+template <typename T>
+class HttpObjectPool
+{
+   public:
+    static constexpr usize kDefaultMaxSize = 64;
+
+    class Recycler
+    {
+       public:
+        explicit Recycler(HttpObjectPool* pool = nullptr) noexcept : pool_{pool}
+        {
+        }
+
+        void operator()(T* obj) const
+        {
+            BATT_CHECK_NOT_NULLPTR(this->pool_);
+            this->pool_->recycle(obj);
+        }
+
+       private:
+        HttpObjectPool* pool_;
+    };
+
+    using Ptr = std::unique_ptr<T, Recycler>;
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+    // Creates an empty pool that will keep at most `max_size` free objects.
+    //
+    explicit HttpObjectPool(usize max_size = kDefaultMaxSize) noexcept : max_size_{max_size}
+    {
+        this->free_list_.lock()->reserve(max_size);
+    }
+
+    HttpObjectPool(const HttpObjectPool&) = delete;
+    HttpObjectPool& operator=(const HttpObjectPool&) = delete;
+
+    ~HttpObjectPool() noexcept
+    {
+        auto locked = this->free_list_.lock();
+        for (T* obj : *locked) {
+            delete obj;
+        }
+    }
+
+    // Returns a free object from the pool, or a newly allocated one if the pool is empty.
+    //
+    Ptr acquire()
+    {
+        T* obj = nullptr;
+        {
+            auto locked = this->free_list_.lock();
+            if (!locked->empty()) {
+                obj = locked->back();
+                locked->pop_back();
+            }
+        }
+        if (obj == nullptr) {
+            obj = new T{};
+        }
+        return Ptr{obj, Recycler{this}};
+    }
+
+    // Resets `obj` and returns it to the free list; if it can't be reset, or the pool is full, it is deleted
+    // instead.  This is called automatically when a Ptr is destroyed.
+    //
+    void recycle(T* obj)
+    {
+        if (obj == nullptr) {
+            return;
+        }
+        if (obj->reset()) {
+            auto locked = this->free_list_.lock();
+            if (locked->size() < this->max_size_) {
+                locked->push_back(obj);
+                return;
+            }
+        }
+        delete obj;
+    }
+
+    // The number of free objects currently in the pool.
+    //
+    usize free_count()
+    {
+        return this->free_list_.lock()->size();
+    }
+
+   private:
+    const usize max_size_;
+
+    // Capacity is reserved up front, so pushing and popping never allocates.
+    //
+    Mutex<std::vector<T*>> free_list_;
+};
+
+using HttpRequestPool = HttpObjectPool<HttpRequest>;
+using HttpResponsePool = HttpObjectPool<HttpResponse>;
+
+}  // namespace batt
+
+#endif  // BATTERIES_HTTP_HTTP_OBJECT_POOL_HPP
@@ -0,0 +1,219 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/http/http_object_pool.hpp>
+//
+#include <batteries/http/http_object_pool.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <batteries/async/task.hpp>
+#include <batteries/http/http_client.hpp>
+
+#include <boost/asio/io_context.hpp>
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace {
+
+using namespace batt::int_types;
+
+// Set to count the heap allocations made by the current thread.
+//
+thread_local bool count_allocations = false;
+thread_local usize allocation_count = 0;
+
+}  // namespace
+
+void* operator new(std::size_t size)
+{
+    if (count_allocations) {
+        allocation_count += 1;
+    }
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc{};
+    }
+    return ptr;
+}
+
+// GCC doesn't know that these are paired with the malloc in operator new above.
+//
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+// Returns the number of heap allocations made (by this thread) while running `fn`.
+//
+template <typename Fn>
+usize count_allocations_in(Fn&& fn)
+{
+    allocation_count = 0;
+    count_allocations = true;
+    fn();
+    count_allocations = false;
+    return allocation_count;
+}
+
+TEST(HttpObjectPoolTest, RecycledObjectIsReused)
+{
+    batt::HttpResponsePool pool;
+
+    EXPECT_EQ(pool.free_count(), 0u);
+
+    batt::HttpResponse* first = nullptr;
+    {
+        batt::HttpResponsePool::Ptr response = pool.acquire();
+        first = response.get();
+    }
+    EXPECT_EQ(pool.free_count(), 1u);
+
+    batt::HttpResponsePool::Ptr response = pool.acquire();
+
+    EXPECT_EQ(response.get(), first);
+    EXPECT_EQ(pool.free_count(), 0u);
+}
+
+TEST(HttpObjectPoolTest, ResetResponseCanBeUsedAgain)
+{
+    batt::HttpResponsePool pool;
+
+    for (i32 code : {200, 404, 500}) {
+        batt::HttpResponsePool::Ptr response = pool.acquire();
+
+        EXPECT_EQ(response->state().get_value(), batt::HttpResponse::kCreated);
+        EXPECT_TRUE(response->get_status().ok());
+
+        pico_http::Response message;
+        message.major_version = 1;
+        message.minor_version = 1;
+        message.status = code;
+
+        batt::HttpData data;
+
+        response->async_set_message(message);
+        response->async_set_data(data);
+        response->state().set_value(batt::HttpResponse::kInitialized);
+        response->update_status(batt::StatusCode::kUnknown);
+
+        EXPECT_EQ(response->code(), code);
+
+        // The data is left unread; recycling the object must release it.
+    }
+
+    EXPECT_EQ(pool.free_count(), 1u);
+}
+
+TEST(HttpObjectPoolTest, ClosedObjectIsNotReused)
+{
+    batt::HttpRequestPool pool;
+    {
+        batt::HttpRequestPool::Ptr request = pool.acquire();
+        request->state().close();
+    }
+    EXPECT_EQ(pool.free_count(), 0u);
+}
+
+TEST(HttpObjectPoolTest, MaxSize)
+{
+    batt::HttpRequestPool pool{/*max_size=*/2};
+    {
+        std::vector<batt::HttpRequestPool::Ptr> requests;
+        for (usize i = 0; i < 5; ++i) {
+            requests.emplace_back(pool.acquire());
+        }
+    }
+    EXPECT_EQ(pool.free_count(), 2u);
+}
+
+TEST(HttpObjectPoolTest, SteadyStateDoesNotAllocate)
+{
+    batt::HttpResponsePool response_pool;
+    batt::HttpObjectPool<batt::detail::HttpClientRequestContext> context_pool;
+
+    batt::StatusOr<batt::UrlParse> url = batt::parse_url("http://example.com:8080/some/path?q=1#frag");
+    ASSERT_TRUE(url.ok());
+
+    const auto request_response_cycle = [&](i32 code) {
+        // Fill a request context the way http_request does, and consume its message and data the way
+        // HttpClientConnection does.
+        //
+        batt::HttpObjectPool<batt::detail::HttpClientRequestContext>::Ptr context = context_pool.acquire();
+
+        ASSERT_TRUE(context->set_method("GET").ok());
+        ASSERT_TRUE(context->set_url(*url).ok());
+        ASSERT_TRUE(context->set_params(batt::HttpHeader{"Accept", "*/*"},
+                                        batt::HttpHeader{"X-Request-Id", "abcdef0123456789"})
+                        .ok());
+
+        batt::HttpRequest& request = *context->get_request_object();
+        ASSERT_TRUE(request.await_message().ok());
+        ASSERT_TRUE(request.await_data().ok());
+        request.release_data();
+
+        // Deliver a response.
+        //
+        batt::HttpResponsePool::Ptr response = response_pool.acquire();
+
+        pico_http::Response message;
+        message.major_version = 1;
+        message.minor_version = 1;
+        message.status = code;
+
+        batt::HttpData data;
+
+        response->async_set_message(message);
+        response->async_set_data(data);
+        response->state().set_value(batt::HttpResponse::kInitialized);
+
+        EXPECT_EQ(response->code(), code);
+    };
+
+    usize n_allocs = 0;
+
+    // Run the cycle on a Task, as the client does, so that waiting on a message doesn't fall back to
+    // blocking the thread.
+    //
+    boost::asio::io_context io;
+    batt::Task task{io.get_executor(), [&] {
+                        // Warm up the pools (and any lazily-initialized statics).
+                        //
+                        for (usize i = 0; i < 3; ++i) {
+                            request_response_cycle(200);
+                        }
+
+                        n_allocs = count_allocations_in([&] {
+                            for (usize i = 0; i < 100; ++i) {
+                                request_response_cycle(200 + i % 300);
+                            }
+                        });
+                    }};
+    io.run();
+    task.join();
+
+    EXPECT_EQ(n_allocs, 0u);
+    EXPECT_EQ(response_pool.free_count(), 1u);
+    EXPECT_EQ(context_pool.free_count(), 1u);
+}
+
+}  // namespace
@@ -17,6 +17,7 @@
 #include <batteries/status.hpp>
 #include <batteries/stream_util.hpp>
 
+#include <string>
 #include <string_view>
 
 namespace batt {
@@ -32,7 +33,11 @@ class HttpRequest : public HttpMessageBase<pico_http::Request>
         StatusOr<pico_http::Request&> message = this->await_message();
         BATT_REQUIRE_OK(message);
 
-        const std::string message_str = to_string(*message);
+        // Reuse the same buffer for every request serialized by this object, so that a recycled request
+        // (see HttpObjectPool) doesn't allocate.
+        //
+        this->header_buffer_.clear();
+        pico_http::append_to(this->header_buffer_, *message);
         this->release_message();
 
         StatusOr<HttpData&> data = this->await_data();
@@ -44,15 +49,20 @@ class HttpRequest : public HttpMessageBase<pico_http::Request>
         });
         //----- --- -- -  -  -
 
-        StatusOr<usize> bytes_written =               //
-            *data                                     //
-            | seq::prepend(make_buffer(message_str))  //
+        StatusOr<usize> bytes_written =                        //
+            *data                                              //
+            | seq::prepend(make_buffer(this->header_buffer_))  //
             | seq::write_to(stream);
 
         BATT_REQUIRE_OK(bytes_written);
 
         return OkStatus();
     }
+
+   private:
+    // The serialized request line and headers.
+    //
+    std::string header_buffer_;
 };
 
 }  // namespace batt
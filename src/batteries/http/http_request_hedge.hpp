@@ -0,0 +1,130 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_HTTP_HTTP_REQUEST_HEDGE_HPP
+#define BATTERIES_HTTP_HTTP_REQUEST_HEDGE_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/http/http_response.hpp>
+
+#include <batteries/pico_http/parser.hpp>
+
+#include <batteries/async/io_result.hpp>
+#include <batteries/async/pin.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/buffer.hpp>
+#include <batteries/int_types.hpp>
+#include <batteries/optional.hpp>
+#include <batteries/shared_ptr.hpp>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace batt {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// A request that may be sent more than once (on different connections), of which only the first response
+// is delivered to `response`; the others are discarded (see HttpHedgingPolicy).
+//
+// The request is serialized up front, so each copy is independent of the objects used to build it.  Only
+// requests without a body can be hedged.
+//
+class HttpRequestHedge : public RefCounted<HttpRequestHedge>
+{
+   public:
+    explicit HttpRequestHedge(const pico_http::Request& request, HttpResponse* response) noexcept
+        : response_{response}
+    {
+        BATT_CHECK_NOT_NULLPTR(response);
+
+        pico_http::append_to(this->serialized_request_, request);
+    }
+
+    // The bytes to send for each copy of the request.
+    //
+    ConstBuffer serialized_request() const
+    {
+        return make_buffer(this->serialized_request_);
+    }
+
+    // Returns true iff some copy of the request has claimed the response.
+    //
+    bool is_claimed() const
+    {
+        return this->claimed_.load();
+    }
+
+    // Called by a connection when it has a response for a copy of this request.  The first call returns the
+    // response object to deliver to; all later calls return nullptr, and the caller should discard what it
+    // has.
+    //
+    Pin<HttpResponse> claim()
+    {
+        if (this->claimed_.exchange(true)) {
+            return {};
+        }
+        return make_pin(this->response_);
+    }
+
+    // Must be called for each copy of the request before it is queued (or scheduled to be queued).
+    //
+    void add_copy()
+    {
+        this->outstanding_copies_.fetch_add(1);
+    }
+
+    // Called when a copy of the request fails, or is dropped without being sent.  If that was the last
+    // outstanding copy and no copy has claimed the response, claims the response and returns it, so the
+    // caller can report the error; otherwise returns nullptr, since another copy may still succeed.
+    //
+    Pin<HttpResponse> fail_copy()
+    {
+        const i64 prior_count = this->outstanding_copies_.fetch_sub(1);
+        BATT_CHECK_GT(prior_count, 0);
+
+        if (prior_count != 1) {
+            return {};
+        }
+        return this->claim();
+    }
+
+    // Invokes `fn(ec)` on the io_context's thread after `delay` (or when the timer is cancelled), while
+    // holding a reference to this object.
+    //
+    template <typename Fn>
+    void schedule(boost::asio::io_context& io, std::chrono::nanoseconds delay, Fn&& fn)
+    {
+        BATT_CHECK_EQ(this->timer_, None);
+
+        this->timer_.emplace(io);
+        this->timer_->expires_after(delay);
+        this->timer_->async_wait([self = SharedPtr<HttpRequestHedge>{this}, fn = BATT_FORWARD(fn)](
+                                     const ErrorCode& ec) mutable {
+            fn(ec);
+        });
+    }
+
+   private:
+    HttpResponse* const response_;
+
+    std::string serialized_request_;
+
+    std::atomic<bool> claimed_{false};
+
+    // The number of copies that have been queued or scheduled, and haven't failed.
+    //
+    std::atomic<i64> outstanding_copies_{0};
+
+    Optional<boost::asio::steady_timer> timer_;
+};
+
+}  // namespace batt
+
+#endif  // BATTERIES_HTTP_HTTP_REQUEST_HEDGE_HPP
@@ -11,15 +11,118 @@
 
 #include <batteries/pico_http/parser.hpp>
 
+#include <batteries/async/buffer_source.hpp>
+
+#include <batteries/buffer.hpp>
+#include <batteries/finally.hpp>
 #include <batteries/int_types.hpp>
+#include <batteries/small_fn.hpp>
+#include <batteries/status.hpp>
+
+#include <string>
 
 namespace batt {
 
 class HttpResponse : public HttpMessageBase<pico_http::Response>
 {
    public:
+    // The default limit on the size of a response body that is delivered to an inline handler.
+    //
+    static constexpr usize kDefaultInlineBodyLimit = 4 * 1024;
+
+    // Receives a response on the connection task that read it (see set_inline_handler).  `message` and
+    // `body` (the entire response body) are only valid for the duration of the call.
+    //
+    using InlineHandlerFn = SmallFn<void(StatusOr<pico_http::Response&> message, const ConstBuffer& body)>;
+
     using HttpMessageBase<pico_http::Response>::HttpMessageBase;
 
+    // Puts this object in inline delivery mode: instead of handing the message and data to the consumer
+    // task through `await_message()`/`await_data()`, the connection parses the response, buffers its body,
+    // and calls `handler` directly from the connection task, then sets the state to kConsumed.
+    //
+    // Only responses with no body, or with a Content-Length of at most `max_body_size` that fits in the
+    // connection's input buffer along with the message header, can be delivered inline; for any other
+    // response (or if the connection fails), `handler` is passed an error status instead.  `handler` is
+    // called exactly once per submitted request, so it must not block.
+    //
+    void set_inline_handler(InlineHandlerFn&& handler, usize max_body_size = kDefaultInlineBodyLimit)
+    {
+        this->inline_handler_ = std::move(handler);
+        this->inline_body_limit_ = max_body_size;
+    }
+
+    bool has_inline_handler() const
+    {
+        return static_cast<bool>(this->inline_handler_);
+    }
+
+    usize inline_body_limit() const
+    {
+        return this->inline_body_limit_;
+    }
+
+    // Delivers the response (or error) to the inline handler; the handler must have been set.
+    //
+    void invoke_inline_handler(StatusOr<pico_http::Response&> message, const ConstBuffer& body)
+    {
+        BATT_CHECK(this->has_inline_handler());
+        this->inline_handler_(message, body);
+    }
+
+    // Reports that no response will be delivered to this object: sets the status, passes it to the inline
+    // handler (if any), and closes this object (see HttpMessageBase::close) so that nothing waits on it.
+    //
+    void fail(const Status& status)
+    {
+        this->update_status(status);
+        if (this->has_inline_handler()) {
+            this->invoke_inline_handler(status, ConstBuffer{});
+        }
+        this->close();
+    }
+
+    // Clears the inline handler, if any, then resets the message state (see HttpMessageBase::reset).
+    //
+    bool reset()
+    {
+        this->inline_handler_ = InlineHandlerFn{};
+        this->inline_body_limit_ = kDefaultInlineBodyLimit;
+
+        return HttpMessageBase<pico_http::Response>::reset();
+    }
+
+    // Writes the response message and data to `stream` (see HttpServer).
+    //
+    template <typename AsyncWriteStream>
+    Status serialize(AsyncWriteStream& stream)
+    {
+        StatusOr<pico_http::Response&> message = this->await_message();
+        BATT_REQUIRE_OK(message);
+
+        this->header_buffer_.clear();
+        pico_http::append_to(this->header_buffer_, *message);
+        this->release_message();
+
+        StatusOr<HttpData&> data = this->await_data();
+        BATT_REQUIRE_OK(data);
+
+        //----- --- -- -  -  -   -
+        auto on_scope_exit = finally([&] {
+            this->release_data();
+        });
+        //----- --- -- -  -  -
+
+        StatusOr<usize> bytes_written =                        //
+            *data                                              //
+            | seq::prepend(make_buffer(this->header_buffer_))  //
+            | seq::write_to(stream);
+
+        BATT_REQUIRE_OK(bytes_written);
+
+        return OkStatus();
+    }
+
     i32 major_version()
     {
         return this->await_message_or_panic().major_version;
@@ -39,6 +142,15 @@ class HttpResponse : public HttpMessageBase<pico_http::Response>
     {
         return this->await_message_or_panic().message;
     }
+
+   private:
+    InlineHandlerFn inline_handler_;
+
+    // The serialized status line and headers.
+    //
+    std::string header_buffer_;
+
+    usize inline_body_limit_ = kDefaultInlineBodyLimit;
 };
 
 }  // namespace batt
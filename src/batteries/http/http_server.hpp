@@ -7,27 +7,46 @@
 
 #include <batteries/config.hpp>
 
+#include <batteries/http/host_address.hpp>
 #include <batteries/http/http_request.hpp>
 #include <batteries/http/http_response.hpp>
+#include <batteries/http/http_server_connection.hpp>
 
 #include <batteries/async/task.hpp>
 #include <batteries/async/watch.hpp>
 
+#include <batteries/optional.hpp>
 #include <batteries/small_fn.hpp>
 #include <batteries/status.hpp>
 
+#include <boost/asio/basic_socket_acceptor.hpp>
+#include <boost/asio/generic/stream_protocol.hpp>
 #include <boost/asio/io_context.hpp>
 
-#include <memory>
-
 namespace batt {
 
+// Accepts HTTP connections on a TCP address ("http" scheme) or a Unix domain socket ("unix" scheme; see
+// kUnixSocketScheme), passing each request to a dispatcher.
+//
 class HttpServer
 {
    public:
-    using RequestDispatcherFn = SmallFn<StatusOr<std::unique_ptr<HttpResponse>>(const HttpRequest& request)>;
+    // Handles a single request.  Before returning, the dispatcher must set the message and data of
+    // `response` using `response.await_set_message` and `response.await_set_data`; these block while the
+    // response is written to the client, so the message and data may live on the dispatcher's stack.
+    // Returning an error closes the connection.
+    //
+    using RequestDispatcherFn = HttpServerConnection::RequestDispatcherFn;
+
+    // Called once per accepted connection to create the dispatcher for that connection.
+    //
     using RequestDispatcherFactoryFn = SmallFn<StatusOr<RequestDispatcherFn>()>;
 
+    // Binds `host_address` and starts accepting connections; if this fails, the server is halted and
+    // get_final_status() returns the error.  For a Unix domain socket, a socket file left at the path (by an
+    // earlier server) is removed first; if the path names anything else, binding fails.  The socket file is
+    // removed when the server halts.
+    //
     explicit HttpServer(boost::asio::io_context& io, HostAddress&& host_address,
                         RequestDispatcherFactoryFn&& dispatcher_factory) noexcept;
 
@@ -38,6 +57,8 @@ class HttpServer
         return this->io_;
     }
 
+    // Stops accepting connections and closes all open connections.
+    //
     void halt();
 
     void join();
@@ -46,6 +67,8 @@ class HttpServer
 
     //+++++++++++-+-+--+----- --- -- -  -  -   -
    private:
+    Status open_acceptor();
+
     void acceptor_task_main();
 
     //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -60,7 +83,9 @@ class HttpServer
 
     Status final_status_;
 
-    Task acceptor_task_;
+    boost::asio::basic_socket_acceptor<boost::asio::generic::stream_protocol> acceptor_;
+
+    Optional<Task> acceptor_task_;
 };
 
 }  // namespace batt
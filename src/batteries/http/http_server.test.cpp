@@ -0,0 +1,288 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/http/http_server.hpp>
+//
+#include <batteries/http/http_server.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <batteries/http/http_client.hpp>
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+namespace {
+
+using namespace batt::int_types;
+
+// Answers every request with "<method> <path>" as the body.
+//
+batt::Status echo_request_line(batt::HttpRequest& request, batt::HttpResponse& response)
+{
+    batt::StatusOr<pico_http::Request&> request_message = request.await_message();
+    BATT_REQUIRE_OK(request_message);
+
+    const std::string body = std::string{request_message->method} + " " + std::string{request_message->path};
+    const std::string content_length = std::to_string(body.size());
+
+    pico_http::Response response_message;
+    response_message.major_version = 1;
+    response_message.minor_version = 1;
+    response_message.status = 200;
+    response_message.message = "OK";
+    response_message.headers.push_back(pico_http::MessageHeader{"Content-Length", content_length});
+
+    batt::Status message_sent = response.await_set_message(response_message);
+    BATT_REQUIRE_OK(message_sent);
+
+    batt::HttpData response_data{
+        batt::SharedBufferSource{batt::SharedConstBuffer::copy_of(batt::as_const_buffer(body))}};
+
+    return response.await_set_data(response_data);
+}
+
+// Like echo_request_line, but fails (without responding) for paths starting with "/fail".
+//
+batt::Status echo_or_fail(batt::HttpRequest& request, batt::HttpResponse& response)
+{
+    batt::StatusOr<pico_http::Request&> request_message = request.await_message();
+    BATT_REQUIRE_OK(request_message);
+
+    if (request_message->path.rfind("/fail", 0) == 0) {
+        return batt::StatusCode::kUnavailable;
+    }
+    return echo_request_line(request, response);
+}
+
+// Returns the URL of `path` on the server listening on `socket_path` (the percent-encoded host).
+//
+std::string unix_socket_url(const std::string& socket_path, const std::string& path)
+{
+    std::string url = "unix://";
+    for (char ch : socket_path) {
+        if (ch == '/') {
+            url += "%2F";
+        } else {
+            url += ch;
+        }
+    }
+    return url + path;
+}
+
+// GETs `url` and returns the response body.
+//
+std::string get_response_body(const std::string& url, batt::HttpClient& client)
+{
+    batt::StatusOr<std::unique_ptr<batt::HttpResponse>> result = batt::http_get(url, client);
+    BATT_CHECK_OK(result);
+
+    batt::StatusOr<batt::HttpData&> data = (*result)->await_data();
+    BATT_CHECK_OK(data);
+
+    std::ostringstream oss;
+    BATT_CHECK_OK(*data | batt::seq::print_out(oss));
+
+    return oss.str();
+}
+
+TEST(HttpServerTest, UnixSocketRoundTrip)
+{
+    const std::string socket_path = "/tmp/batt_http_server_test_" + std::to_string(::getpid()) + ".sock";
+
+    boost::asio::io_context io;
+    auto work_guard = boost::asio::make_work_guard(io);
+    std::thread io_thread{[&io] {
+        io.run();
+    }};
+
+    batt::HttpServer server{io, batt::HostAddress{"unix", socket_path, batt::None}, [] {
+                                return batt::HttpServer::RequestDispatcherFn{&echo_request_line};
+                            }};
+
+    ASSERT_TRUE(server.get_final_status().ok()) << BATT_INSPECT(server.get_final_status());
+
+    batt::HttpClient client{io};
+
+    // The socket path is the percent-encoded host.
+    //
+    std::string encoded_path;
+    for (char ch : socket_path) {
+        if (ch == '/') {
+            encoded_path += "%2F";
+        } else {
+            encoded_path += ch;
+        }
+    }
+
+    // Several requests on the same (keep-alive) connection.
+    //
+    for (usize i = 0; i < 5; ++i) {
+        const std::string path = "/v1/status/" + std::to_string(i);
+
+        EXPECT_EQ(get_response_body("unix://" + encoded_path + path, client), "GET " + path);
+    }
+
+    // If there is no host, the path of the URL is the socket path.
+    //
+    EXPECT_EQ(get_response_body("unix://" + socket_path, client), "GET /");
+
+    // The server closes the connection after the response when asked to.
+    //
+    {
+        batt::StatusOr<std::unique_ptr<batt::HttpResponse>> result = batt::http_get(
+            "unix://" + encoded_path + "/bye", client, batt::HttpHeader{"Connection", "close"});
+        ASSERT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+
+        batt::StatusOr<batt::HttpData&> data = (*result)->await_data();
+        ASSERT_TRUE(data.ok());
+
+        std::ostringstream oss;
+        EXPECT_TRUE((*data | batt::seq::print_out(oss)).ok());
+        EXPECT_EQ(oss.str(), "GET /bye");
+    }
+
+    client.halt();
+    client.join();
+
+    server.halt();
+    server.join();
+
+    EXPECT_TRUE(server.get_final_status().ok()) << BATT_INSPECT(server.get_final_status());
+
+    work_guard.reset();
+    io_thread.join();
+
+    // The socket file is removed when the server halts.
+    //
+    EXPECT_NE(::access(socket_path.c_str(), F_OK), 0);
+}
+
+TEST(HttpServerTest, DispatcherErrorResponse)
+{
+    const std::string socket_path = "/tmp/batt_http_server_test_" + std::to_string(::getpid()) + ".err";
+
+    boost::asio::io_context io;
+    auto work_guard = boost::asio::make_work_guard(io);
+    std::thread io_thread{[&io] {
+        io.run();
+    }};
+
+    batt::HttpServer server{io, batt::HostAddress{"unix", socket_path, batt::None}, [] {
+                                return batt::HttpServer::RequestDispatcherFn{&echo_or_fail};
+                            }};
+
+    ASSERT_TRUE(server.get_final_status().ok()) << BATT_INSPECT(server.get_final_status());
+
+    batt::HttpClient client{io};
+
+    EXPECT_EQ(get_response_body(unix_socket_url(socket_path, "/before"), client), "GET /before");
+
+    // The client gets a 500 response carrying the dispatcher's error, rather than a dropped connection.
+    //
+    {
+        batt::StatusOr<std::unique_ptr<batt::HttpResponse>> result =
+            batt::http_get(unix_socket_url(socket_path, "/fail"), client);
+        ASSERT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+
+        batt::StatusOr<pico_http::Response&> message = (*result)->await_message();
+        ASSERT_TRUE(message.ok()) << BATT_INSPECT(message.status());
+        EXPECT_EQ(message->status, 500);
+        EXPECT_EQ(batt::find_header(*message, "Connection"), batt::Optional<std::string_view>{"close"});
+
+        batt::StatusOr<batt::HttpData&> data = (*result)->await_data();
+        ASSERT_TRUE(data.ok());
+
+        std::ostringstream oss;
+        EXPECT_TRUE((*data | batt::seq::print_out(oss)).ok());
+        EXPECT_THAT(oss.str(), ::testing::HasSubstr("Unavailable"));
+    }
+
+    // The client can still make requests (on a new connection).
+    //
+    EXPECT_EQ(get_response_body(unix_socket_url(socket_path, "/after"), client), "GET /after");
+
+    client.halt();
+    client.join();
+
+    server.halt();
+    server.join();
+
+    work_guard.reset();
+    io_thread.join();
+}
+
+TEST(HttpServerTest, BindFailure)
+{
+    boost::asio::io_context io;
+
+    batt::HttpServer server{io, batt::HostAddress{"unix", "/nonexistent-dir/server.sock", batt::None}, [] {
+                                return batt::HttpServer::RequestDispatcherFn{&echo_request_line};
+                            }};
+
+    EXPECT_FALSE(server.get_final_status().ok());
+
+    server.halt();
+    server.join();
+}
+
+TEST(HttpServerTest, ExistingFileAtSocketPath)
+{
+    const std::string socket_path = "/tmp/batt_http_server_test_" + std::to_string(::getpid()) + ".existing";
+
+    boost::asio::io_context io;
+
+    const auto start_server = [&] {
+        return std::make_unique<batt::HttpServer>(io, batt::HostAddress{"unix", socket_path, batt::None}, [] {
+            return batt::HttpServer::RequestDispatcherFn{&echo_request_line};
+        });
+    };
+
+    // A regular file at the socket path is left alone, and the server fails to bind.
+    {
+        std::ofstream{socket_path} << "not a socket";
+
+        std::unique_ptr<batt::HttpServer> server = start_server();
+        EXPECT_FALSE(server->get_final_status().ok());
+
+        server->halt();
+        server->join();
+        server = nullptr;
+
+        std::ifstream in{socket_path};
+        std::string contents;
+        std::getline(in, contents);
+        EXPECT_EQ(contents, "not a socket");
+
+        ::unlink(socket_path.c_str());
+    }
+
+    // A socket file left over from an earlier (crashed) server is replaced.
+    {
+        {
+            boost::asio::local::stream_protocol::acceptor stale{io, socket_path};
+        }
+        ASSERT_EQ(::access(socket_path.c_str(), F_OK), 0);
+
+        std::unique_ptr<batt::HttpServer> server = start_server();
+        EXPECT_TRUE(server->get_final_status().ok()) << BATT_INSPECT(server->get_final_status());
+
+        server->halt();
+        io.run();
+        server = nullptr;
+
+        EXPECT_NE(::access(socket_path.c_str(), F_OK), 0);
+    }
+}
+
+}  // namespace
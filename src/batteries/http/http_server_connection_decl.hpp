@@ -0,0 +1,98 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_HTTP_HTTP_SERVER_CONNECTION_DECL_HPP
+#define BATTERIES_HTTP_HTTP_SERVER_CONNECTION_DECL_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/http/http_data.hpp>
+#include <batteries/http/http_request.hpp>
+#include <batteries/http/http_response.hpp>
+
+#include <batteries/async/queue.hpp>
+#include <batteries/async/stream_buffer.hpp>
+#include <batteries/async/task.hpp>
+
+#include <batteries/optional.hpp>
+#include <batteries/small_fn.hpp>
+#include <batteries/status.hpp>
+
+#include <boost/asio/generic/stream_protocol.hpp>
+
+namespace batt {
+
+// One accepted connection of an HttpServer.  Requests are read and passed to the dispatcher one at a time,
+// in the order they arrive; responses are written in the same order.
+//
+class HttpServerConnection
+{
+   public:
+    using RequestDispatcherFn = SmallFn<Status(HttpRequest& request, HttpResponse& response)>;
+
+    struct RequestInfo {
+        explicit RequestInfo(const pico_http::Request& request);
+
+        // Returns the body of the request whose start line and headers (`message_length` bytes) are at the
+        // front of `input_buffer`.  The message header is consumed when the body is first fetched.
+        //
+        HttpData get_data(StreamBuffer& input_buffer, i32 message_length);
+
+        Optional<usize> content_length;
+        bool keep_alive;
+        bool chunked_encoding;
+    };
+
+    // A request that has been dispatched, waiting for its response to be written.
+    //
+    struct PendingResponse {
+        Pin<HttpResponse> response;
+        bool keep_alive;
+    };
+
+    explicit HttpServerConnection(boost::asio::generic::stream_protocol::socket&& socket,
+                                  RequestDispatcherFn&& dispatcher) noexcept;
+
+    ~HttpServerConnection() noexcept;
+
+    void start();
+
+    // Closes the socket, unblocking all tasks of this connection.
+    //
+    void halt();
+
+    void join();
+
+    // Returns true once the connection has been closed and all of its tasks have finished.
+    //
+    bool is_done() const;
+
+    Status fill_input_buffer();
+
+    Status process_requests();
+
+    Status process_responses();
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+   private:
+    // Writes a "500 Internal Server Error" response (with `Connection: close`) whose body is `status`.
+    //
+    Status write_error_response(const Status& status);
+
+    boost::asio::generic::stream_protocol::socket socket_;
+
+    RequestDispatcherFn dispatcher_;
+
+    Queue<PendingResponse> response_queue_;
+
+    StreamBuffer input_buffer_{16 * 1024};
+
+    // Must be last!
+    //
+    Optional<Task> task_;
+};
+
+}  // namespace batt
+
+#endif  // BATTERIES_HTTP_HTTP_SERVER_CONNECTION_DECL_HPP
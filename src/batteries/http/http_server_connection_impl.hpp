@@ -0,0 +1,269 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_HTTP_HTTP_SERVER_CONNECTION_IMPL_HPP
+#define BATTERIES_HTTP_HTTP_SERVER_CONNECTION_IMPL_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/http/http_chunk_decoder.hpp>
+#include <batteries/http/http_message_reader.hpp>
+#include <batteries/http/http_server_connection.hpp>
+
+#include <batteries/finally.hpp>
+#include <batteries/stream_util.hpp>
+
+#include <string>
+
+namespace batt {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL /*explicit*/ HttpServerConnection::HttpServerConnection(
+    boost::asio::generic::stream_protocol::socket&& socket, RequestDispatcherFn&& dispatcher) noexcept
+    : socket_{std::move(socket)}
+    , dispatcher_{std::move(dispatcher)}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL HttpServerConnection::~HttpServerConnection() noexcept
+{
+    this->join();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void HttpServerConnection::start()
+{
+    this->task_.emplace(
+        this->socket_.get_executor(),
+        [this] {
+            auto executor = Task::current().get_executor();
+
+            Task fill_input_buffer_task{executor, [this] {
+                                            this->fill_input_buffer().IgnoreError();
+                                        }};
+
+            Task process_responses_task{executor, [this] {
+                                            this->process_responses().IgnoreError();
+                                        }};
+
+            this->process_requests().IgnoreError();
+
+            process_responses_task.join();
+            fill_input_buffer_task.join();
+        },
+        "HttpServerConnection::task");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void HttpServerConnection::halt()
+{
+    boost::system::error_code ec;
+    this->socket_.shutdown(boost::asio::socket_base::shutdown_both, ec);
+    this->socket_.close(ec);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void HttpServerConnection::join()
+{
+    if (this->task_) {
+        this->task_->join();
+        this->task_ = None;
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL bool HttpServerConnection::is_done() const
+{
+    return !this->task_ || this->task_->is_done();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Status HttpServerConnection::fill_input_buffer()
+{
+    auto on_exit = finally([this] {
+        this->input_buffer_.close_for_write();
+    });
+
+    for (;;) {
+        StatusOr<SmallVec<MutableBuffer, 2>> buffer = this->input_buffer_.prepare_at_least(1);
+        BATT_REQUIRE_OK(buffer);
+
+        auto n_read = Task::await<IOResult<usize>>([&](auto&& handler) {
+            this->socket_.async_read_some(*buffer, BATT_FORWARD(handler));
+        });
+        BATT_REQUIRE_OK(n_read);
+
+        this->input_buffer_.commit(*n_read);
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Status HttpServerConnection::process_requests()
+{
+    auto on_exit = finally([this] {
+        this->input_buffer_.close_for_read();
+        this->response_queue_.close();
+    });
+
+    for (;;) {
+        pico_http::Request request_message;
+        StatusOr<i32> message_length = read_http_message_header(this->input_buffer_, request_message);
+        BATT_REQUIRE_OK(message_length);
+
+        RequestInfo request_info{request_message};
+
+        HttpData request_data = request_info.get_data(this->input_buffer_, *message_length);
+
+        HttpRequest request;
+        HttpResponse response;
+
+        if (!this->response_queue_.push(PendingResponse{make_pin(&response), request_info.keep_alive})) {
+            return StatusCode::kClosed;
+        }
+
+        request.state().set_value(HttpRequest::kInitialized);
+        request.async_set_message(request_message);
+        request.async_set_data(request_data);
+
+        Status dispatched = this->dispatcher_(request, response);
+        if (!dispatched.ok()) {
+            response.update_status(dispatched);
+            response.close();
+        }
+
+        // Skip over whatever the dispatcher didn't read of the request, so we can read the next one.
+        //
+        request.release_message();
+        request.release_data();
+        request.state().set_value(HttpRequest::kConsumed);
+
+        BATT_REQUIRE_OK(dispatched);
+
+        Status data_consumed = std::move(request_data) | seq::consume();
+        BATT_REQUIRE_OK(data_consumed);
+
+        if (!request_info.keep_alive) {
+            return OkStatus();
+        }
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Status HttpServerConnection::process_responses()
+{
+    auto on_exit = finally([this] {
+        // Fail any responses we won't get to, so their dispatchers don't wait forever.
+        //
+        this->response_queue_.close();
+        while (Optional<PendingResponse> pending = this->response_queue_.try_pop_next()) {
+            pending->response->close();
+        }
+        this->halt();
+    });
+
+    for (;;) {
+        BATT_ASSIGN_OK_RESULT(PendingResponse pending, this->response_queue_.await_next());
+
+        HttpResponse& response = *pending.response;
+
+        StatusOr<pico_http::Response&> response_message = response.await_message();
+        if (!response_message.ok()) {
+            // If the dispatcher failed before producing a response, nothing has been written for this request
+            // yet; tell the client why before closing the connection.
+            //
+            if (!response.get_status().ok()) {
+                this->write_error_response(response.get_status()).IgnoreError();
+            }
+            response.close();
+        }
+        BATT_REQUIRE_OK(response_message);
+
+        // The connection can only be reused if the client can tell where the response body ends.
+        //
+        const bool keep_alive =
+            pending.keep_alive &&
+            find_header(*response_message, KnownHeader::kConnection).value_or("keep-alive") != "close" &&
+            (find_header(*response_message, KnownHeader::kContentLength) ||
+             find_header(*response_message, KnownHeader::kTransferEncoding).value_or("") == "chunked");
+
+        Status written = response.serialize(this->socket_);
+        if (!written.ok()) {
+            response.close();
+        }
+        BATT_REQUIRE_OK(written);
+
+        if (!keep_alive) {
+            return OkStatus();
+        }
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Status HttpServerConnection::write_error_response(const Status& status)
+{
+    const std::string body = to_string(status, "\n");
+    const std::string message = to_string("HTTP/1.1 500 Internal Server Error\r\n",  //
+                                          "Connection: close\r\n",                    //
+                                          "Content-Type: text/plain\r\n",             //
+                                          "Content-Length: ", body.size(), "\r\n",    //
+                                          "\r\n", body);
+
+    IOResult<usize> bytes_written =
+        Task::await_write(this->socket_, ConstBuffer{message.data(), message.size()});
+    BATT_REQUIRE_OK(bytes_written);
+
+    return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL HttpServerConnection::RequestInfo::RequestInfo(const pico_http::Request& request)
+    : content_length{find_header(request, KnownHeader::kContentLength).flat_map([](std::string_view s) {
+        return Optional{from_string<usize>(std::string(s))};
+    })}
+    , keep_alive{find_header(request, KnownHeader::kConnection)
+                     .map([](std::string_view s) {
+                         return s == "keep-alive";
+                     })
+                     .value_or(request.major_version == 1 && request.minor_version >= 1)}
+    , chunked_encoding{find_header(request, KnownHeader::kTransferEncoding)
+                           .map([](std::string_view s) {
+                               return s == "chunked";
+                           })
+                           .value_or(false)}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL HttpData HttpServerConnection::RequestInfo::get_data(StreamBuffer& input_buffer,
+                                                                     i32 message_length)
+{
+    const usize header_size = BATT_CHECKED_CAST(usize, message_length);
+
+    return HttpData{[&]() -> BufferSource {
+        if (this->chunked_encoding) {
+            return HttpChunkDecoder<SkipNSource<StreamBuffer&>>{input_buffer | skip_n(header_size)};
+        }
+        // A request with neither Content-Length nor chunked encoding has no body (RFC 7230 section 3.3.3).
+        //
+        return input_buffer | seq::take_n(header_size + this->content_length.value_or(0))  //
+               | skip_n(header_size);
+    }()};
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_HTTP_HTTP_SERVER_CONNECTION_IMPL_HPP
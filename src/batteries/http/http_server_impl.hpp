@@ -7,6 +7,19 @@
 #include <batteries/http/http_server.hpp>
 
 #include <batteries/assert.hpp>
+#include <batteries/finally.hpp>
+#include <batteries/status.hpp>
+
+#include <boost/asio/ip/tcp.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace batt {
 
@@ -17,12 +30,20 @@ BATT_INLINE_IMPL /*explicit*/ HttpServer::HttpServer(boost::asio::io_context& io
     : io_{io}
     , host_address_{std::move(host_address)}
     , dispatcher_factory_{std::move(dispatcher_factory)}
-    , acceptor_task_{io.get_executor(),
-                     [this] {
-                         this->acceptor_task_main();
-                     },
-                     "HttpServer::acceptor_task"}
+    , acceptor_{io}
 {
+    this->final_status_ = this->open_acceptor();
+    if (!this->final_status_.ok()) {
+        this->halt_requested_.set_value(true);
+        return;
+    }
+
+    this->acceptor_task_.emplace(
+        io.get_executor(),
+        [this] {
+            this->acceptor_task_main();
+        },
+        "HttpServer::acceptor_task");
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -44,15 +65,136 @@ BATT_INLINE_IMPL void HttpServer::halt()
 //
 BATT_INLINE_IMPL void HttpServer::join()
 {
-    this->acceptor_task_.join();
+    if (this->acceptor_task_) {
+        this->acceptor_task_->join();
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Status HttpServer::get_final_status() const
+{
+    return this->final_status_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Status HttpServer::open_acceptor()
+{
+    boost::asio::generic::stream_protocol::endpoint endpoint;
+
+    if (is_unix_socket(this->host_address_)) {
+        // Binding fails if the socket file is left over from an earlier server, so remove it; but never
+        // remove anything that isn't a socket.
+        //
+        const char* const socket_path = this->host_address_.hostname.c_str();
+
+        struct stat socket_stat;
+        if (::lstat(socket_path, &socket_stat) == 0) {
+            if (!S_ISSOCK(socket_stat.st_mode)) {
+                return status_from_errno(EADDRINUSE);
+            }
+            if (::unlink(socket_path) != 0) {
+                return status_from_errno(errno);
+            }
+        } else if (errno != ENOENT) {
+            return status_from_errno(errno);
+        }
+
+        endpoint = unix_socket_endpoint(this->host_address_);
+    } else {
+        BATT_CHECK_EQ(this->host_address_.scheme, "http") << "TODO [tastolfi 2022-05-06] implement https!";
+
+        boost::system::error_code ec;
+        boost::asio::ip::tcp::resolver resolver{this->io_};
+        boost::asio::ip::tcp::resolver::results_type results = resolver.resolve(
+            this->host_address_.hostname,
+            this->host_address_.port ? std::to_string(*this->host_address_.port) : this->host_address_.scheme,
+            ec);
+
+        BATT_REQUIRE_OK(ec);
+        if (results.empty()) {
+            return StatusCode::kUnavailable;
+        }
+        endpoint = results.begin()->endpoint();
+    }
+
+    boost::system::error_code ec;
+
+    this->acceptor_.open(endpoint.protocol(), ec);
+    BATT_REQUIRE_OK(ec);
+
+    if (!is_unix_socket(this->host_address_)) {
+        this->acceptor_.set_option(boost::asio::socket_base::reuse_address{true}, ec);
+        BATT_REQUIRE_OK(ec);
+    }
+
+    this->acceptor_.bind(endpoint, ec);
+    BATT_REQUIRE_OK(ec);
+
+    this->acceptor_.listen(boost::asio::socket_base::max_listen_connections, ec);
+    BATT_REQUIRE_OK(ec);
+
+    return OkStatus();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 BATT_INLINE_IMPL void HttpServer::acceptor_task_main()
 {
+    std::vector<std::unique_ptr<HttpServerConnection>> connections;
+
+    // Closing the acceptor unblocks the accept loop below.
+    //
+    Task halt_task{Task::current().get_executor(), [this] {
+                       this->halt_requested_.await_equal(true).IgnoreError();
+
+                       boost::system::error_code ec;
+                       this->acceptor_.close(ec);
+                   }};
+
+    auto on_exit = finally([&] {
+        this->halt_requested_.set_value(true);
+        halt_task.join();
+
+        for (std::unique_ptr<HttpServerConnection>& connection : connections) {
+            connection->halt();
+        }
+        connections.clear();
+
+        if (is_unix_socket(this->host_address_)) {
+            ::unlink(this->host_address_.hostname.c_str());
+        }
+    });
+
     this->final_status_ = [&]() -> Status {
-        BATT_CHECK_EQ(this->host_address_.scheme, "http") << "TODO [tastolfi 2022-05-06] implement https!";
+        while (!this->halt_requested_.get_value()) {
+            IOResult<boost::asio::generic::stream_protocol::socket> socket =
+                Task::await_accept(this->acceptor_);
+
+            if (this->halt_requested_.get_value()) {
+                break;
+            }
+            BATT_REQUIRE_OK(socket);
+
+            // Clean up connections that have been closed by the client.
+            //
+            connections.erase(std::remove_if(connections.begin(), connections.end(),
+                                             [](const std::unique_ptr<HttpServerConnection>& connection) {
+                                                 return connection->is_done();
+                                             }),
+                              connections.end());
+
+            StatusOr<RequestDispatcherFn> dispatcher = this->dispatcher_factory_();
+            if (!dispatcher.ok()) {
+                continue;
+            }
+
+            connections.emplace_back(
+                std::make_unique<HttpServerConnection>(std::move(*socket), std::move(*dispatcher)));
+            connections.back()->start();
+        }
+        return OkStatus();
     }();
 }
 
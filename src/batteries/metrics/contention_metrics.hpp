@@ -0,0 +1,212 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2021-2023 Anthony Paul Astolfi, Eitan Steiner
+//
+#pragma once
+#ifndef BATTERIES_METRICS_CONTENTION_METRICS_HPP
+#define BATTERIES_METRICS_CONTENTION_METRICS_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/metrics/metric_collectors.hpp>
+#include <batteries/metrics/metric_family.hpp>
+#include <batteries/metrics/metric_registry.hpp>
+
+#include <batteries/async/mutex.hpp>
+#include <batteries/async/watch.hpp>
+
+#include <batteries/int_types.hpp>
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+namespace batt {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Process-wide lock contention metrics, one series per call site (label "site", value "<file>:<line>").
+//
+class ContentionMetrics
+{
+   public:
+    // Limits the number of call sites that get their own series.
+    //
+    static constexpr usize kMaxCallSites = 4096;
+
+    // The histogram bucket bounds used for wait and hold times, in microseconds.
+    //
+    static std::vector<double> time_buckets_usec();
+
+    // The process-wide instance; this is never destroyed, so metrics can be recorded at any time.
+    //
+    static ContentionMetrics& instance();
+
+    // Time spent waiting to acquire the lock.
+    //
+    HistogramFamily wait_usec;
+
+    // Time the lock was held.
+    //
+    HistogramFamily hold_usec;
+
+    CounterFamily<u64> acquire_count;
+
+    // Acquisitions that found the mutex already locked.
+    //
+    CounterFamily<u64> contended_count;
+
+   private:
+    ContentionMetrics() noexcept;
+};
+
+// Exports ContentionMetrics::instance() and the process-wide WatchSpinStats to `registry`:
+//
+//  - batt_mutex_wait_usec, batt_mutex_hold_usec (histograms, by site)
+//  - batt_mutex_acquires, batt_mutex_contended_acquires (counters, by site)
+//  - batt_watch_lock_observers_contended, batt_watch_lock_observers_spins (counters)
+//
+// This must be called at most once per process.
+//
+void add_contention_metrics(MetricRegistry& registry = global_metric_registry());
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// The metric cells of a single lock call site; see BATT_MUTEX_CALL_SITE.
+//
+class MutexCallSite
+{
+   public:
+    explicit MutexCallSite(const char* file, int line) noexcept;
+
+    MutexCallSite(const MutexCallSite&) = delete;
+    MutexCallSite& operator=(const MutexCallSite&) = delete;
+
+    HistogramMetric& wait_usec;
+    HistogramMetric& hold_usec;
+    ShardedCountMetric<u64>& acquire_count;
+    ShardedCountMetric<u64>& contended_count;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// A Mutex<T>::Lock (or ConstLock) that records how long it took to acquire and how long it was held.
+//
+template <typename MutexT>
+class InstrumentedMutexLock
+{
+   public:
+    using Lock = decltype(std::declval<MutexT&>().lock());
+
+    using Clock = std::chrono::steady_clock;
+
+    explicit InstrumentedMutexLock(MutexT& m, MutexCallSite& site) noexcept
+        : site_{site}
+        , contended_{m.is_locked()}
+        , wait_start_{Clock::now()}
+        , lock_{m}
+        , hold_start_{Clock::now()}
+    {
+        this->site_.acquire_count.add(1);
+        if (this->contended_) {
+            this->site_.contended_count.add(1);
+        }
+        this->site_.wait_usec.update(usec_between(this->wait_start_, this->hold_start_));
+    }
+
+    InstrumentedMutexLock(const InstrumentedMutexLock&) = delete;
+    InstrumentedMutexLock& operator=(const InstrumentedMutexLock&) = delete;
+
+    ~InstrumentedMutexLock() noexcept
+    {
+        this->release();
+    }
+
+    bool is_held() const noexcept
+    {
+        return this->lock_.is_held();
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return this->is_held();
+    }
+
+    // Whether the mutex was already locked when this lock was requested.
+    //
+    bool was_contended() const noexcept
+    {
+        return this->contended_;
+    }
+
+    decltype(auto) operator*() noexcept
+    {
+        return *this->lock_;
+    }
+
+    auto get() noexcept
+    {
+        return this->lock_.get();
+    }
+
+    decltype(auto) value() noexcept
+    {
+        return this->lock_.value();
+    }
+
+    auto operator->() noexcept
+    {
+        return this->lock_.get();
+    }
+
+    bool release() noexcept
+    {
+        if (this->lock_.release()) {
+            this->site_.hold_usec.update(usec_between(this->hold_start_, Clock::now()));
+            return true;
+        }
+        return false;
+    }
+
+   private:
+    static double usec_between(Clock::time_point start, Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::micro>(end - start).count();
+    }
+
+    MutexCallSite& site_;
+    const bool contended_;
+    const Clock::time_point wait_start_;
+    Lock lock_;
+    const Clock::time_point hold_start_;
+};
+
+// Locks `m`, recording metrics for `site`.
+//
+template <typename MutexT>
+inline InstrumentedMutexLock<MutexT> lock_instrumented(MutexT& m, MutexCallSite& site)
+{
+    return InstrumentedMutexLock<MutexT>{m, site};
+}
+
+}  // namespace batt
+
+// Evaluates to a MutexCallSite& for the current source location, created the first time it is evaluated.
+//
+#define BATT_MUTEX_CALL_SITE()                                                                               \
+    ([]() -> ::batt::MutexCallSite& {                                                                        \
+        static ::batt::MutexCallSite site_{__FILE__, __LINE__};                                              \
+        return site_;                                                                                        \
+    }())
+
+// Locks a batt::Mutex; `auto lock = BATT_LOCK_MUTEX(m);` is equivalent to `auto lock = m.lock();`, except
+// that if BATT_MUTEX_CONTENTION_METRICS is 1, the lock records contention metrics for this call site (see
+// ContentionMetrics).
+//
+#if BATT_MUTEX_CONTENTION_METRICS
+#define BATT_LOCK_MUTEX(m) ::batt::lock_instrumented((m), BATT_MUTEX_CALL_SITE())
+#else
+#define BATT_LOCK_MUTEX(m) (m).lock()
+#endif
+
+#endif  // BATTERIES_METRICS_CONTENTION_METRICS_HPP
+
+#if BATT_HEADER_ONLY
+#include <batteries/metrics/contention_metrics_impl.hpp>
+#endif  // BATT_HEADER_ONLY
@@ -0,0 +1,85 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2021-2023 Anthony Paul Astolfi, Eitan Steiner
+//
+#pragma once
+#ifndef BATTERIES_METRICS_CONTENTION_METRICS_IMPL_HPP
+#define BATTERIES_METRICS_CONTENTION_METRICS_IMPL_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/metrics/contention_metrics.hpp>
+
+#include <batteries/stream_util.hpp>
+
+#include <string>
+
+namespace batt {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL std::vector<double> ContentionMetrics::time_buckets_usec()
+{
+    return {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 100000, 1000000};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL ContentionMetrics& ContentionMetrics::instance()
+{
+    // Intentionally leaked: call sites and registries may refer to it during static destruction.
+    //
+    static ContentionMetrics* instance_ = new ContentionMetrics{};
+    return *instance_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL ContentionMetrics::ContentionMetrics() noexcept
+    : wait_usec{{Token{"site"}}, time_buckets_usec(), kMaxCallSites}
+    , hold_usec{{Token{"site"}}, time_buckets_usec(), kMaxCallSites}
+    , acquire_count{{Token{"site"}}, kMaxCallSites}
+    , contended_count{{Token{"site"}}, kMaxCallSites}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void add_contention_metrics(MetricRegistry& registry)
+{
+    ContentionMetrics& metrics = ContentionMetrics::instance();
+
+    registry.add("batt_mutex_wait_usec", metrics.wait_usec);
+    registry.add("batt_mutex_hold_usec", metrics.hold_usec);
+    registry.add("batt_mutex_acquires", metrics.acquire_count);
+    registry.add("batt_mutex_contended_acquires", metrics.contended_count);
+
+    WatchSpinStats& watch_stats = watch_spin_stats();
+
+    registry.add_exporter(&watch_stats,
+                          make_function_metric_exporter("batt_watch_lock_observers_contended", "counter",
+                                                        [&watch_stats] {
+                                                            return watch_stats.contended_locks.load();
+                                                        }),
+                          MetricLabelSet{});
+
+    registry.add_exporter(&watch_stats,
+                          make_function_metric_exporter("batt_watch_lock_observers_spins", "counter",
+                                                        [&watch_stats] {
+                                                            return watch_stats.spins.load();
+                                                        }),
+                          MetricLabelSet{});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL /*explicit*/ MutexCallSite::MutexCallSite(const char* file, int line) noexcept
+    : wait_usec{ContentionMetrics::instance().wait_usec.with_labels(to_string(file, ":", line))}
+    , hold_usec{ContentionMetrics::instance().hold_usec.with_labels(to_string(file, ":", line))}
+    , acquire_count{ContentionMetrics::instance().acquire_count.with_labels(to_string(file, ":", line))}
+    , contended_count{ContentionMetrics::instance().contended_count.with_labels(to_string(file, ":", line))}
+{
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_METRICS_CONTENTION_METRICS_IMPL_HPP
@@ -0,0 +1,160 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2021-2023 Anthony Paul Astolfi, Eitan Steiner
+//
+#pragma once
+#ifndef BATTERIES_METRICS_METRIC_BINARY_FORMATTER_HPP
+#define BATTERIES_METRICS_METRIC_BINARY_FORMATTER_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/metrics/metric_formatter.hpp>
+#include <batteries/metrics/metric_registry.hpp>
+
+#include <batteries/int_types.hpp>
+#include <batteries/status.hpp>
+
+#include <chrono>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace batt {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Binary metric dump format, written by MetricBinaryFormatter and read by MetricBinaryReader.  All integers
+// are little-endian.
+//
+//  Header:
+//   - magic: 8 bytes, kMetricBinaryMagic
+//   - version: u32, kMetricBinaryVersion
+//   - start time: i64, microseconds since the (system clock) epoch
+//   - string table: u32 count, then for each string a u32 length and the bytes
+//   - columns: u32 count, then for each column a u32 name (string index), a u32 label count, and for each
+//     label a u32 key and a u32 value (string indices)
+//
+//  Rows (until the end of the stream); each row is (1 + column count) * 8 bytes:
+//   - u64 microseconds since the previous row (or the start time, for the first row)
+//   - for each column, the u64 bits of its double value XOR-ed with those of the previous row (or zero);
+//     values that didn't change are stored as zero
+//
+constexpr std::string_view kMetricBinaryMagic = "BATTMETB";
+constexpr u32 kMetricBinaryVersion = 1;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Writes metrics in the binary dump format described above; much cheaper than MetricCsvFormatter to write
+// at a high row rate.  There is one column per metric registered at the time `initialize` is called.
+//
+class MetricBinaryFormatter : public MetricFormatter
+{
+   public:
+    MetricBinaryFormatter() = default;
+
+    void initialize(MetricRegistry& src, std::ostream& dst) override;
+
+    void format_values(MetricRegistry& src, std::ostream& dst) override;
+
+    void finished(MetricRegistry& src, std::ostream& dst) override;
+
+   private:
+    static constexpr usize kNoColumn = ~usize{0};
+
+    std::chrono::steady_clock::time_point last_row_time_;
+
+    // The column position of each metric, by MetricId.
+    //
+    std::vector<usize> column_of_id_;
+
+    // The value bits of the previous row.
+    //
+    std::vector<u64> prev_bits_;
+
+    // So we don't have to keep reallocating.
+    //
+    MetricSnapshot snapshot_;
+    std::vector<u64> bits_;
+    std::string row_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Reads the output of MetricBinaryFormatter.
+//
+class MetricBinaryReader
+{
+   public:
+    struct Column {
+        std::string name;
+        MetricLabelSet labels;
+    };
+
+    explicit MetricBinaryReader(std::istream& src) noexcept : src_{src}
+    {
+    }
+
+    // Reads the header; must be called once before reading rows.
+    //
+    Status read_header();
+
+    // The start time from the header (microseconds since the system clock epoch).
+    //
+    i64 start_time_usec() const
+    {
+        return this->start_time_usec_;
+    }
+
+    const std::vector<Column>& columns() const
+    {
+        return this->columns_;
+    }
+
+    // Reads the next row; returns false if there are no more rows.
+    //
+    StatusOr<bool> read_row();
+
+    // The number of rows read so far.
+    //
+    usize row_count() const
+    {
+        return this->row_count_;
+    }
+
+    // The time of the last row read, in microseconds since the start time.
+    //
+    i64 row_time_usec() const
+    {
+        return this->row_time_usec_;
+    }
+
+    // The values of the last row read, one per column.
+    //
+    const std::vector<double>& row_values() const
+    {
+        return this->row_values_;
+    }
+
+   private:
+    StatusOr<u32> read_u32();
+
+    std::istream& src_;
+    i64 start_time_usec_ = 0;
+    std::vector<Column> columns_;
+    usize row_count_ = 0;
+    i64 row_time_usec_ = 0;
+    std::vector<u64> row_bits_;
+    std::vector<double> row_values_;
+    std::string row_;
+};
+
+// Converts the binary metric dump in `src` to CSV, in the same layout as MetricCsvFormatter (except that
+// each metric has its own column, named `name[key=value]...` if it has labels).
+//
+Status convert_metric_binary_to_csv(std::istream& src, std::ostream& dst);
+
+}  // namespace batt
+
+#endif  // BATTERIES_METRICS_METRIC_BINARY_FORMATTER_HPP
+
+#if BATT_HEADER_ONLY
+#include <batteries/metrics/metric_binary_formatter_impl.hpp>
+#endif  // BATT_HEADER_ONLY
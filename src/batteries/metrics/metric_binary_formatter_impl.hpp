@@ -0,0 +1,300 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2021-2023 Anthony Paul Astolfi, Eitan Steiner
+//
+#pragma once
+#ifndef BATTERIES_METRICS_METRIC_BINARY_FORMATTER_IMPL_HPP
+#define BATTERIES_METRICS_METRIC_BINARY_FORMATTER_IMPL_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/metrics/metric_binary_formatter.hpp>
+
+#include <batteries/suppress.hpp>
+
+BATT_SUPPRESS("-Wswitch-enum")
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+BATT_UNSUPPRESS()
+
+#include <cstring>
+#include <iomanip>
+#include <unordered_map>
+#include <utility>
+
+namespace batt {
+
+namespace detail {
+
+inline void append_little_endian(std::string& dst, u64 value, usize n_bytes)
+{
+    for (usize i = 0; i < n_bytes; ++i) {
+        dst.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+    }
+}
+
+inline u64 load_little_endian(const char* src, usize n_bytes)
+{
+    u64 value = 0;
+    for (usize i = 0; i < n_bytes; ++i) {
+        value |= u64{static_cast<u8>(src[i])} << (i * 8);
+    }
+    return value;
+}
+
+}  // namespace detail
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricBinaryFormatter::initialize(MetricRegistry& src, std::ostream& dst)
+{
+    // Intern all names, label keys and label values.
+    //
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, u32> string_index;
+
+    const auto intern = [&](const std::string& s) -> u32 {
+        auto [iter, inserted] = string_index.emplace(s, static_cast<u32>(strings.size()));
+        if (inserted) {
+            strings.emplace_back(s);
+        }
+        return iter->second;
+    };
+
+    std::string columns;
+    u32 n_columns = 0;
+
+    this->column_of_id_.clear();
+
+    src.for_each_descriptor([&](const MetricDescriptor& metric) {
+        detail::append_little_endian(columns, intern(metric.name), 4);
+        detail::append_little_endian(columns, metric.labels.size(), 4);
+        for (const MetricLabel& label : metric.labels) {
+            detail::append_little_endian(columns, intern(label.key), 4);
+            detail::append_little_endian(columns, intern(label.value), 4);
+        }
+        if (metric.id >= this->column_of_id_.size()) {
+            this->column_of_id_.resize(metric.id + 1, kNoColumn);
+        }
+        this->column_of_id_[metric.id] = n_columns;
+        n_columns += 1;
+    });
+
+    const i64 start_time_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::system_clock::now().time_since_epoch())
+                                    .count();
+    this->last_row_time_ = std::chrono::steady_clock::now();
+
+    this->row_.clear();
+    this->row_.append(kMetricBinaryMagic.data(), kMetricBinaryMagic.size());
+    detail::append_little_endian(this->row_, kMetricBinaryVersion, 4);
+    detail::append_little_endian(this->row_, static_cast<u64>(start_time_usec), 8);
+    detail::append_little_endian(this->row_, strings.size(), 4);
+    for (const std::string& s : strings) {
+        detail::append_little_endian(this->row_, s.size(), 4);
+        this->row_.append(s.data(), s.size());
+    }
+    detail::append_little_endian(this->row_, n_columns, 4);
+    this->row_ += columns;
+
+    dst.write(this->row_.data(), this->row_.size());
+
+    this->bits_.assign(n_columns, 0);
+    this->prev_bits_.assign(n_columns, 0);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricBinaryFormatter::format_values(MetricRegistry& src, std::ostream& dst)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const i64 delta_usec = std::chrono::duration_cast<std::chrono::microseconds>(now - this->last_row_time_)
+                               .count();
+
+    // Advance by exactly the amount recorded, so rounding errors don't accumulate.
+    //
+    this->last_row_time_ += std::chrono::microseconds(delta_usec);
+
+    src.read_snapshot(this->snapshot_);
+    for (const MetricSnapshot::Sample& sample : this->snapshot_.samples()) {
+        if (sample.id < this->column_of_id_.size() && this->column_of_id_[sample.id] != kNoColumn) {
+            std::memcpy(&this->bits_[this->column_of_id_[sample.id]], &sample.value, sizeof(u64));
+        }
+    }
+
+    this->row_.clear();
+    detail::append_little_endian(this->row_, static_cast<u64>(delta_usec), 8);
+    for (usize i = 0; i < this->bits_.size(); ++i) {
+        detail::append_little_endian(this->row_, this->bits_[i] ^ this->prev_bits_[i], 8);
+        this->prev_bits_[i] = this->bits_[i];
+    }
+
+    dst.write(this->row_.data(), this->row_.size());  // NOTE: don't flush (let the caller decide when to)
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricBinaryFormatter::finished(MetricRegistry& /*src*/, std::ostream& /*dst*/)
+{
+    // Rows continue until the end of the stream, so there is no trailer.
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL StatusOr<u32> MetricBinaryReader::read_u32()
+{
+    char buffer[4];
+    if (!this->src_.read(buffer, sizeof(buffer))) {
+        return {StatusCode::kDataLoss};
+    }
+    return static_cast<u32>(detail::load_little_endian(buffer, sizeof(buffer)));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Status MetricBinaryReader::read_header()
+{
+    char magic[kMetricBinaryMagic.size()];
+    if (!this->src_.read(magic, sizeof(magic))) {
+        return StatusCode::kDataLoss;
+    }
+    if (std::string_view{magic, sizeof(magic)} != kMetricBinaryMagic) {
+        return StatusCode::kInvalidArgument;
+    }
+
+    BATT_ASSIGN_OK_RESULT(const u32 version, this->read_u32());
+    if (version != kMetricBinaryVersion) {
+        return StatusCode::kInvalidArgument;
+    }
+
+    char start_time[8];
+    if (!this->src_.read(start_time, sizeof(start_time))) {
+        return StatusCode::kDataLoss;
+    }
+    this->start_time_usec_ = static_cast<i64>(detail::load_little_endian(start_time, sizeof(start_time)));
+
+    // String table.
+    //
+    BATT_ASSIGN_OK_RESULT(const u32 n_strings, this->read_u32());
+
+    std::vector<std::string> strings(n_strings);
+    for (std::string& s : strings) {
+        BATT_ASSIGN_OK_RESULT(const u32 length, this->read_u32());
+        s.resize(length);
+        if (!this->src_.read(s.data(), length)) {
+            return StatusCode::kDataLoss;
+        }
+    }
+
+    const auto get_string = [&](u32 index) -> StatusOr<std::string> {
+        if (index >= strings.size()) {
+            return {StatusCode::kDataLoss};
+        }
+        return strings[index];
+    };
+
+    // Columns.
+    //
+    BATT_ASSIGN_OK_RESULT(const u32 n_columns, this->read_u32());
+
+    this->columns_.clear();
+    for (u32 i = 0; i < n_columns; ++i) {
+        Column column;
+
+        BATT_ASSIGN_OK_RESULT(const u32 name, this->read_u32());
+        BATT_ASSIGN_OK_RESULT(column.name, get_string(name));
+
+        BATT_ASSIGN_OK_RESULT(const u32 n_labels, this->read_u32());
+        for (u32 j = 0; j < n_labels; ++j) {
+            BATT_ASSIGN_OK_RESULT(const u32 key, this->read_u32());
+            BATT_ASSIGN_OK_RESULT(const u32 value, this->read_u32());
+            BATT_ASSIGN_OK_RESULT(std::string key_str, get_string(key));
+            BATT_ASSIGN_OK_RESULT(std::string value_str, get_string(value));
+
+            column.labels.emplace_back(MetricLabel{Token{key_str}, Token{value_str}});
+        }
+        this->columns_.emplace_back(std::move(column));
+    }
+
+    this->row_count_ = 0;
+    this->row_time_usec_ = 0;
+    this->row_bits_.assign(n_columns, 0);
+    this->row_values_.assign(n_columns, 0);
+
+    return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL StatusOr<bool> MetricBinaryReader::read_row()
+{
+    this->row_.resize((this->columns_.size() + 1) * 8);
+
+    this->src_.read(this->row_.data(), this->row_.size());
+    if (this->src_.gcount() == 0 && this->src_.eof()) {
+        return false;
+    }
+    if (static_cast<usize>(this->src_.gcount()) != this->row_.size()) {
+        return {StatusCode::kDataLoss};
+    }
+
+    const char* next = this->row_.data();
+
+    this->row_time_usec_ += static_cast<i64>(detail::load_little_endian(next, 8));
+    next += 8;
+
+    for (usize i = 0; i < this->columns_.size(); ++i) {
+        this->row_bits_[i] ^= detail::load_little_endian(next, 8);
+        next += 8;
+        std::memcpy(&this->row_values_[i], &this->row_bits_[i], sizeof(double));
+    }
+
+    this->row_count_ += 1;
+
+    return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Status convert_metric_binary_to_csv(std::istream& src, std::ostream& dst)
+{
+    MetricBinaryReader reader{src};
+
+    BATT_REQUIRE_OK(reader.read_header());
+
+    dst << "id,time_usec,date_time";
+    for (const MetricBinaryReader::Column& column : reader.columns()) {
+        dst << "," << column.name;
+        for (const MetricLabel& label : column.labels) {
+            dst << "[" << label.key << "=" << label.value << "]";
+        }
+    }
+    dst << "\n";
+
+    const boost::posix_time::ptime start_time =
+        boost::posix_time::from_time_t(0) + boost::posix_time::microseconds(reader.start_time_usec());
+
+    for (;;) {
+        BATT_ASSIGN_OK_RESULT(const bool got_row, reader.read_row());
+        if (!got_row) {
+            break;
+        }
+
+        const boost::posix_time::ptime t =
+            start_time + boost::posix_time::microseconds(reader.row_time_usec());
+
+        dst << reader.row_count() << "," << reader.row_time_usec() << ","
+            << boost::posix_time::to_iso_extended_string(t);
+
+        for (double v : reader.row_values()) {
+            dst << "," << std::setprecision(10) << v;
+        }
+        dst << "\n";
+    }
+
+    return OkStatus();
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_METRICS_METRIC_BINARY_FORMATTER_IMPL_HPP
@@ -6,13 +6,20 @@
 #define BATTERIES_METRICS_METRIC_COLLECTORS_HPP
 
 #include <batteries/config.hpp>
+#include <batteries/assert.hpp>
+#include <batteries/cpu_align.hpp>
 #include <batteries/int_types.hpp>
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <ostream>
+#include <vector>
 
 namespace batt {
 
@@ -198,6 +205,12 @@ template <typename T>
 using DerivedMetric = std::function<T()>;
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Estimates the rate of change of a cumulative value.
+//
+// NOTE: the window is approximated by halving the start time/value, and the three atomics are not updated
+// together, so readings are jagged and racy under concurrent updates; new code should use
+// WindowedRateMetric or EwmaRateMetric instead.
+//
 template <typename T, i64 kIntervalSeconds>
 class RateMetric
 {
@@ -245,6 +258,190 @@ class RateMetric
     std::atomic<T> current_value_;
 };
 
+/*! \brief Counts events in per-second buckets and reports the average rate over the last
+ *  `kWindowSeconds` complete seconds.
+ *
+ *  Each bucket is a single atomic word holding the second it belongs to and the count for that second, so
+ *  `add` is a single (usually uncontended) CAS, and a bucket is reset atomically by the first update of a new
+ *  second. */
+template <i64 kWindowSeconds>
+class WindowedRateMetric
+{
+   public:
+    static_assert(kWindowSeconds > 0, "The window must be at least one second");
+
+    using Clock = std::chrono::steady_clock;
+
+    /*! \brief Initialize a metric with no events
+     *  \param The time from which the rate is measured, until a full window has passed */
+    explicit WindowedRateMetric(Clock::time_point start_time = Clock::now()) noexcept
+        : start_time_{start_time}
+    {
+        for (std::atomic<u64>& bucket : this->buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /*! \brief Record `count` events
+     *  \param The number of events
+     *  \param The current time */
+    void add(u64 count = 1, Clock::time_point now = Clock::now())
+    {
+        const u64 second = this->second_of(now);
+        std::atomic<u64>& bucket = this->buckets_[second % kNumBuckets];
+
+        u64 observed = bucket.load(std::memory_order_relaxed);
+        for (;;) {
+            const u64 bucket_count =
+                (epoch_of(observed) == epoch_of(second << kCountBits)) ? count_of(observed) : 0;
+            const u64 target = (second << kCountBits) | std::min(bucket_count + count, kMaxCount);
+            if (bucket.compare_exchange_weak(observed, target, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+    }
+
+    /*! \return The average number of events per second over the last `kWindowSeconds` complete seconds (or
+     *  the complete seconds since the start time, if fewer) */
+    double rate(Clock::time_point now = Clock::now()) const
+    {
+        const u64 second = this->second_of(now);
+        const u64 n_seconds = std::min<u64>(second, kWindowSeconds);
+        if (n_seconds == 0) {
+            return 0;
+        }
+
+        u64 total = 0;
+        for (u64 s = second - n_seconds; s < second; ++s) {
+            const u64 observed = this->buckets_[s % kNumBuckets].load(std::memory_order_relaxed);
+            if (epoch_of(observed) == epoch_of(s << kCountBits)) {
+                total += count_of(observed);
+            }
+        }
+        return static_cast<double>(total) / static_cast<double>(n_seconds);
+    }
+
+   private:
+    // One extra bucket for the current (incomplete) second.
+    //
+    static constexpr usize kNumBuckets = kWindowSeconds + 1;
+
+    // The low bits of each bucket hold the count; the high bits hold the low bits of the second number.
+    //
+    static constexpr u32 kCountBits = 40;
+    static constexpr u64 kMaxCount = (u64{1} << kCountBits) - 1;
+
+    static u64 epoch_of(u64 bucket)
+    {
+        return bucket >> kCountBits;
+    }
+
+    static u64 count_of(u64 bucket)
+    {
+        return bucket & kMaxCount;
+    }
+
+    u64 second_of(Clock::time_point now) const
+    {
+        const i64 elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - this->start_time_).count();
+        return static_cast<u64>(std::max<i64>(0, elapsed));
+    }
+
+    const Clock::time_point start_time_;
+    std::array<std::atomic<u64>, kNumBuckets> buckets_;
+};
+
+/*! \brief An exponentially weighted moving average of an event rate, like the Unix load average.
+ *
+ *  `add` only increments an atomic counter.  Once per tick interval, the first caller of `add` or `rate`
+ *  folds the events counted during the tick into the average; if another thread is already doing so, the
+ *  caller doesn't wait. */
+class EwmaRateMetric
+{
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    /*! \brief Initialize a metric with no events
+     *  \param The time over which the weight of past events decays by a factor of e
+     *  \param How often the average is updated
+     *  \param The time from which ticks are counted */
+    explicit EwmaRateMetric(Clock::duration time_constant = std::chrono::seconds{10},
+                            Clock::duration tick_interval = std::chrono::seconds{1},
+                            Clock::time_point start_time = Clock::now()) noexcept
+        : tick_interval_{tick_interval}
+        , tick_seconds_{std::chrono::duration<double>(tick_interval).count()}
+        , alpha_{1.0 - std::exp(-this->tick_seconds_ / std::chrono::duration<double>(time_constant).count())}
+        , start_time_{start_time}
+    {
+        BATT_ASSERT_GT(tick_interval.count(), 0);
+    }
+
+    /*! \brief Record `count` events
+     *  \param The number of events
+     *  \param The current time */
+    void add(u64 count = 1, Clock::time_point now = Clock::now())
+    {
+        this->maybe_tick(now);
+        this->pending_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /*! \return The average rate, in events per second, as of the last complete tick */
+    double rate(Clock::time_point now = Clock::now())
+    {
+        this->maybe_tick(now);
+        return this->rate_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    void maybe_tick(Clock::time_point now)
+    {
+        const i64 tick = (now - this->start_time_) / this->tick_interval_;
+        if (tick <= this->last_tick_.load(std::memory_order_acquire)) {
+            return;
+        }
+        if (this->ticking_.exchange(true, std::memory_order_acquire)) {
+            return;
+        }
+
+        const i64 last_tick = this->last_tick_.load(std::memory_order_relaxed);
+        if (tick > last_tick) {
+            // The events counted so far happened during the first elapsed tick; any further elapsed ticks had
+            // no events.
+            //
+            const u64 tick_count = this->pending_.exchange(0, std::memory_order_relaxed);
+            const double tick_rate = static_cast<double>(tick_count) / this->tick_seconds_;
+
+            double new_rate = this->rate_.load(std::memory_order_relaxed);
+            if (!this->initialized_) {
+                new_rate = tick_rate;
+                this->initialized_ = true;
+            } else {
+                new_rate += this->alpha_ * (tick_rate - new_rate);
+            }
+            new_rate *= std::pow(1.0 - this->alpha_, static_cast<double>(tick - last_tick - 1));
+
+            this->rate_.store(new_rate, std::memory_order_relaxed);
+            this->last_tick_.store(tick, std::memory_order_release);
+        }
+
+        this->ticking_.store(false, std::memory_order_release);
+    }
+
+    const Clock::duration tick_interval_;
+    const double tick_seconds_;
+    const double alpha_;
+    const Clock::time_point start_time_;
+
+    std::atomic<u64> pending_{0};
+    std::atomic<double> rate_{0};
+    std::atomic<i64> last_tick_{0};
+    std::atomic<bool> ticking_{false};
+
+    // Only accessed while `ticking_` is held.
+    //
+    bool initialized_ = false;
+};
+
 /*! \brief A Metric collector that stores and reports a single instantaneous value. */
 template <typename T>
 class GaugeMetric
@@ -338,6 +535,135 @@ class StatsMetric
     friend class MetricRegistry;
 };
 
+/*! \brief A counter that is spread over several cache lines, so that concurrent updates from different
+ *  threads don't contend; reads add up all the shards. */
+template <typename T>
+class ShardedCountMetric
+{
+   public:
+    static constexpr usize kShardCount = 8;
+
+    /*! \brief Initialize a zero counter */
+    ShardedCountMetric() = default;
+
+    /*! \brief Add `delta` to the shard of the calling thread
+     *  \param Delta value */
+    template <typename D>
+    void add(D delta)
+    {
+        this->shards_[this_thread_shard()].value().fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    /*! \return The sum of all shards */
+    T load() const
+    {
+        T total = 0;
+        for (const CpuCacheLineIsolated<std::atomic<T>>& shard : this->shards_) {
+            total += shard.value().load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    /*! \brief Reset all shards to zero */
+    void reset()
+    {
+        for (CpuCacheLineIsolated<std::atomic<T>>& shard : this->shards_) {
+            shard.value().store(0, std::memory_order_relaxed);
+        }
+    }
+
+   private:
+    static usize this_thread_shard()
+    {
+        static std::atomic<usize> next_shard{0};
+        thread_local const usize shard = next_shard.fetch_add(1) % kShardCount;
+        return shard;
+    }
+
+    std::array<CpuCacheLineIsolated<std::atomic<T>>, kShardCount> shards_;
+};
+
+/*! \brief Counts samples in buckets with fixed upper bounds, and tracks the count and sum of all samples. */
+class HistogramMetric
+{
+   public:
+    /*! \brief Initialize an empty histogram
+     *  \param The (sorted) inclusive upper bound of each bucket; an extra bucket holds all samples larger
+     *  than the last bound */
+    explicit HistogramMetric(std::shared_ptr<const std::vector<double>> upper_bounds) noexcept
+        : upper_bounds_{std::move(upper_bounds)}
+        , bucket_counts_{new std::atomic<u64>[this->upper_bounds_->size() + 1]}
+    {
+        BATT_ASSERT(std::is_sorted(this->upper_bounds_->begin(), this->upper_bounds_->end()));
+
+        this->reset();
+    }
+
+    /*! \brief Add a sample to the histogram
+     *  \param Sample value */
+    void update(double sample)
+    {
+        const std::vector<double>& bounds = *this->upper_bounds_;
+        const usize bucket = std::lower_bound(bounds.begin(), bounds.end(), sample) - bounds.begin();
+
+        this->bucket_counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+        this->count_.fetch_add(1, std::memory_order_relaxed);
+
+        double observed_sum = this->sum_.load(std::memory_order_relaxed);
+        while (!this->sum_.compare_exchange_weak(observed_sum, observed_sum + sample)) {
+        }
+    }
+
+    /*! \return The number of buckets, including the last (unbounded) one */
+    usize bucket_count() const
+    {
+        return this->upper_bounds_->size() + 1;
+    }
+
+    /*! \return The upper bound of bucket `i`; infinity for the last bucket */
+    double upper_bound(usize i) const
+    {
+        if (i < this->upper_bounds_->size()) {
+            return (*this->upper_bounds_)[i];
+        }
+        return std::numeric_limits<double>::infinity();
+    }
+
+    /*! \return The number of samples in bucket `i` */
+    u64 bucket(usize i) const
+    {
+        return this->bucket_counts_[i].load(std::memory_order_relaxed);
+    }
+
+    /*! \return The number of samples */
+    u64 count() const
+    {
+        return this->count_.load(std::memory_order_relaxed);
+    }
+
+    /*! \return The sum of all samples */
+    double sum() const
+    {
+        return this->sum_.load(std::memory_order_relaxed);
+    }
+
+    /*! \brief Reset to the empty state */
+    void reset()
+    {
+        for (usize i = 0; i < this->bucket_count(); ++i) {
+            this->bucket_counts_[i].store(0, std::memory_order_relaxed);
+        }
+        this->count_.store(0, std::memory_order_relaxed);
+        this->sum_.store(0, std::memory_order_relaxed);
+    }
+
+   private:
+    std::shared_ptr<const std::vector<double>> upper_bounds_;
+    std::unique_ptr<std::atomic<u64>[]> bucket_counts_;
+    std::atomic<u64> count_{0};
+    std::atomic<double> sum_{0};
+};
+
 }  // namespace batt
 
 #endif  // BATTERIES_METRICS_METRIC_COLLECTORS_HPP
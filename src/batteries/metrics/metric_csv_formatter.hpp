@@ -34,12 +34,16 @@ class MetricCsvFormatter : public MetricFormatter
     usize id_ = 0;
     std::chrono::steady_clock::time_point start_time_;
 
-    // Saved column names and positions.
+    // The column position of each metric, by MetricId; metrics registered after `initialize` have no column
+    // (kNoColumn).
     //
-    std::unordered_map<std::string, usize> index_of_;
+    static constexpr usize kNoColumn = ~usize{0};
+
+    std::vector<usize> column_of_id_;
 
     // So we don't have to keep reallocating.
     //
+    MetricSnapshot snapshot_;
     std::vector<double> values_;
 };
 
@@ -18,6 +18,9 @@ BATT_SUPPRESS("-Wswitch-enum")
 BATT_UNSUPPRESS()
 
 #include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace batt {
 
@@ -27,20 +30,32 @@ BATT_INLINE_IMPL void MetricCsvFormatter::initialize(MetricRegistry& src, std::o
 {
     // Build the schema for dumping metric rows.
     //
-    std::vector<std::string> all_names;
-    src.read_all([&](std::string_view name, double, const MetricLabelSet&) {
-        all_names.emplace_back(name);
+    std::vector<std::pair<std::string, MetricId>> all_names;
+    src.for_each_descriptor([&](const MetricDescriptor& metric) {
+        all_names.emplace_back(metric.name, metric.id);
     });
     std::sort(all_names.begin(), all_names.end());
 
+    // Metrics with the same name share a column.
+    //
+    this->column_of_id_.clear();
+
     dst << "id,time_usec,date_time";
+    usize n_columns = 0;
     for (usize i = 0; i < all_names.size(); ++i) {
-        this->index_of_[all_names[i]] = i;
-        dst << "," << all_names[i];
+        if (i == 0 || all_names[i].first != all_names[i - 1].first) {
+            dst << "," << all_names[i].first;
+            n_columns += 1;
+        }
+        const MetricId id = all_names[i].second;
+        if (id >= this->column_of_id_.size()) {
+            this->column_of_id_.resize(id + 1, kNoColumn);
+        }
+        this->column_of_id_[id] = n_columns - 1;
     }
     dst << "\n";
 
-    this->values_.resize(all_names.size());
+    this->values_.resize(n_columns);
     this->id_ = 0;
     this->start_time_ = std::chrono::steady_clock::now();
 }
@@ -56,13 +71,12 @@ BATT_INLINE_IMPL void MetricCsvFormatter::format_values(MetricRegistry& src, std
 
     // Read the registry, reordering the columns according to the schema we built above.
     //
-    src.read_all([&](std::string_view name, double value, const MetricLabelSet&) {
-        auto iter = this->index_of_.find(std::string(name));
-        if (iter == this->index_of_.end()) {
-            return;
+    src.read_snapshot(this->snapshot_);
+    for (const MetricSnapshot::Sample& sample : this->snapshot_.samples()) {
+        if (sample.id < this->column_of_id_.size() && this->column_of_id_[sample.id] != kNoColumn) {
+            this->values_[this->column_of_id_[sample.id]] = sample.value;
         }
-        this->values_[iter->second] = value;
-    });
+    }
 
     // First dump id and time_usec.
     //
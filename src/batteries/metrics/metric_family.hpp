@@ -0,0 +1,528 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2021-2023 Anthony Paul Astolfi, Eitan Steiner
+//
+#pragma once
+#ifndef BATTERIES_METRICS_METRIC_FAMILY_HPP
+#define BATTERIES_METRICS_METRIC_FAMILY_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/metrics/metric_collectors.hpp>
+#include <batteries/metrics/metric_registry.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/int_types.hpp>
+#include <batteries/stream_util.hpp>
+#include <batteries/token.hpp>
+
+#include <boost/functional/hash.hpp>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace batt {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/*! \brief Exports a value computed by a function object; used by metric families to export their series. */
+//
+template <typename Fn>
+class FunctionMetricExporter : public MetricExporter
+{
+   public:
+    explicit FunctionMetricExporter(const std::string& name, std::string_view type, Fn&& fn) noexcept
+        : name_{name}
+        , type_{type}
+        , fn_{std::move(fn)}
+    {
+    }
+
+    /*! \return The metric name. */
+    Token get_name() const override
+    {
+        return this->name_;
+    }
+
+    /*! \return The metric type. */
+    std::string_view get_type() const override
+    {
+        return this->type_;
+    }
+
+    /*! \return The metric value. */
+    double get_value() const override
+    {
+        return static_cast<double>(this->fn_());
+    }
+
+   private:
+    Token name_;
+    std::string_view type_;
+    Fn fn_;
+};
+
+/*! \brief Returns a new FunctionMetricExporter for `fn`. */
+template <typename Fn>
+inline std::unique_ptr<MetricExporter> make_function_metric_exporter(const std::string& name,
+                                                                     std::string_view type, Fn&& fn)
+{
+    return std::make_unique<FunctionMetricExporter<std::decay_t<Fn>>>(name, type, BATT_FORWARD(fn));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/*! \brief A set of metric series sharing the same name and label keys, each identified by its label values.
+ *
+ * Series are created on first use by with_labels().  Looking up an existing series takes no locks: the series
+ * are kept in a fixed-size open-addressing hash table whose slots are only ever filled, never cleared, so
+ * readers just probe atomically.  Creating a new series takes the family mutex.
+ *
+ * The number of distinct series is limited to `max_series()`; once the limit is reached, updates for new
+ * label values all go to a single overflow series whose label values are kOverflowLabelValue, and
+ * overflow_count() is incremented for each such lookup.
+ *
+ * A family is exported by passing it to MetricRegistry::add; series created after that are exported as
+ * they are created.  All the series are removed from the registry when the family is removed or destroyed.
+ */
+template <typename CellT>
+class MetricFamily
+{
+   public:
+    using Cell = CellT;
+
+    /*! \brief The default value for the maximum number of series in a family. */
+    static constexpr usize kDefaultMaxSeries = 1000;
+
+    /*! \brief The value of every label of the overflow series. */
+    static constexpr std::string_view kOverflowLabelValue = "__overflow__";
+
+    MetricFamily(const MetricFamily&) = delete;
+    MetricFamily& operator=(const MetricFamily&) = delete;
+
+    /*! \brief Removes all series from the registry the family is attached to, if any. */
+    virtual ~MetricFamily() noexcept
+    {
+        MetricRegistry* registry = nullptr;
+        {
+            std::unique_lock<std::mutex> lock{this->mutex_};
+            registry = this->registry_;
+        }
+        if (registry) {
+            registry->remove(*this);
+        }
+    }
+
+    /*! \return The label keys of every series, in the order their values are passed to with_labels(). */
+    const std::vector<Token>& label_keys() const
+    {
+        return this->label_keys_;
+    }
+
+    /*! \return The maximum number of distinct series (not counting the overflow series). */
+    usize max_series() const
+    {
+        return this->max_series_;
+    }
+
+    /*! \return The number of distinct series created so far (not counting the overflow series). */
+    usize series_count() const
+    {
+        return this->series_count_.load(std::memory_order_acquire);
+    }
+
+    /*! \return The number of lookups that were redirected to the overflow series. */
+    u64 overflow_count() const
+    {
+        return this->overflow_count_.load(std::memory_order_relaxed);
+    }
+
+    /*! \brief Returns the cell of the series with the given label values, creating it if necessary.
+     *  \param One value per label key, convertible to std::string_view */
+    template <typename... Values>
+    CellT& with_labels(const Values&... values)
+    {
+        const std::array<std::string_view, sizeof...(Values)> label_values{{std::string_view{values}...}};
+
+        BATT_CHECK_EQ(label_values.size(), this->label_keys_.size())
+            << "The number of label values must match the label keys of the family";
+
+        return this->find_or_create(label_values.data());
+    }
+
+    /*! \brief Invokes `fn(labels, cell)` for every series, including the overflow series if it exists.  The
+     * family is locked for the duration, so `fn` must not create new series. */
+    template <typename Fn>
+    void for_each_series(Fn&& fn) const
+    {
+        std::unique_lock<std::mutex> lock{this->mutex_};
+
+        for (const std::unique_ptr<SeriesNode>& node : this->nodes_) {
+            fn(static_cast<const MetricLabelSet&>(node->labels), static_cast<const CellT&>(*node->cell));
+        }
+    }
+
+    /*! \brief Exports all current and future series of this family to `registry` under `name`.  This is
+     * normally called via MetricRegistry::add. */
+    void attach_to_registry(MetricRegistry& registry, std::string_view name)
+    {
+        std::unique_lock<std::mutex> lock{this->mutex_};
+
+        BATT_CHECK_EQ(this->registry_, nullptr) << "A metric family can only be added to one registry";
+
+        this->registry_ = &registry;
+        this->name_ = std::string(name);
+
+        for (const std::unique_ptr<SeriesNode>& node : this->nodes_) {
+            this->export_cell(registry, this->name_, *node->cell, node->labels);
+        }
+    }
+
+    /*! \brief Stops exporting new series; called by MetricRegistry::remove before it removes the existing
+     * series. */
+    void detach_from_registry()
+    {
+        std::unique_lock<std::mutex> lock{this->mutex_};
+        this->registry_ = nullptr;
+    }
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+   protected:
+    explicit MetricFamily(std::vector<Token>&& label_keys, usize max_series) noexcept
+        : label_keys_{std::move(label_keys)}
+        , max_series_{max_series}
+        , capacity_{table_capacity_for(max_series)}
+        , table_{new std::atomic<SeriesNode*>[this->capacity_]}
+    {
+        for (usize i = 0; i < this->capacity_; ++i) {
+            this->table_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    /*! \brief Creates the cell of a new series. */
+    virtual std::unique_ptr<CellT> make_cell() const = 0;
+
+    /*! \brief Adds exporters for `cell` to `registry`; called with the family mutex held.  Derived classes
+     * must pass registry_key() as the exported object, so that MetricRegistry::remove(family) removes
+     * them. */
+    virtual void export_cell(MetricRegistry& registry, const std::string& name, CellT& cell,
+                             const MetricLabelSet& labels) = 0;
+
+    /*! \return The object pointer under which the series of this family are registered. */
+    const void* registry_key() const
+    {
+        return this;
+    }
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+   private:
+    struct SeriesNode {
+        usize hash;
+        std::vector<std::string> label_values;
+        MetricLabelSet labels;
+        std::unique_ptr<CellT> cell;
+    };
+
+    // The hash table never holds more than half its capacity, so probing always stops at an empty slot.
+    //
+    static usize table_capacity_for(usize max_series)
+    {
+        usize capacity = 2;
+        while (capacity < (max_series + 1) * 2) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    usize hash_of(const std::string_view* label_values) const
+    {
+        usize seed = 0;
+        for (usize i = 0; i < this->label_keys_.size(); ++i) {
+            boost::hash_combine(seed, std::hash<std::string_view>{}(label_values[i]));
+        }
+        return seed;
+    }
+
+    bool node_matches(const SeriesNode& node, usize hash, const std::string_view* label_values) const
+    {
+        if (node.hash != hash) {
+            return false;
+        }
+        for (usize i = 0; i < this->label_keys_.size(); ++i) {
+            if (node.label_values[i] != label_values[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Returns the first slot that is either empty or holds the series with the given label values.
+    //
+    std::atomic<SeriesNode*>& probe(usize hash, const std::string_view* label_values,
+                                    SeriesNode** found) const
+    {
+        const usize mask = this->capacity_ - 1;
+        for (usize i = hash & mask;; i = (i + 1) & mask) {
+            SeriesNode* const node = this->table_[i].load(std::memory_order_acquire);
+            if (node == nullptr || this->node_matches(*node, hash, label_values)) {
+                *found = node;
+                return this->table_[i];
+            }
+        }
+    }
+
+    CellT& find_or_create(const std::string_view* label_values)
+    {
+        const usize hash = this->hash_of(label_values);
+
+        SeriesNode* node = nullptr;
+        this->probe(hash, label_values, &node);
+        if (node != nullptr) {
+            return *node->cell;
+        }
+
+        if (this->series_count() >= this->max_series_) {
+            return this->overflow_cell();
+        }
+
+        std::unique_lock<std::mutex> lock{this->mutex_};
+
+        // Another thread may have created the series (or filled the family) while we waited for the lock.
+        //
+        std::atomic<SeriesNode*>& slot = this->probe(hash, label_values, &node);
+        if (node != nullptr) {
+            return *node->cell;
+        }
+        if (this->series_count_.load(std::memory_order_relaxed) >= this->max_series_) {
+            lock.unlock();
+            return this->overflow_cell();
+        }
+
+        node = this->create_node(hash, label_values);
+        slot.store(node, std::memory_order_release);
+        this->series_count_.fetch_add(1, std::memory_order_release);
+
+        return *node->cell;
+    }
+
+    CellT& overflow_cell()
+    {
+        this->overflow_count_.fetch_add(1, std::memory_order_relaxed);
+
+        SeriesNode* node = this->overflow_node_.load(std::memory_order_acquire);
+        if (node == nullptr) {
+            std::unique_lock<std::mutex> lock{this->mutex_};
+
+            node = this->overflow_node_.load(std::memory_order_relaxed);
+            if (node == nullptr) {
+                const std::vector<std::string_view> label_values(this->label_keys_.size(),
+                                                                 kOverflowLabelValue);
+
+                node = this->create_node(this->hash_of(label_values.data()), label_values.data());
+                this->overflow_node_.store(node, std::memory_order_release);
+            }
+        }
+        return *node->cell;
+    }
+
+    // Must be called with the family mutex held.
+    //
+    SeriesNode* create_node(usize hash, const std::string_view* label_values)
+    {
+        auto node = std::make_unique<SeriesNode>();
+
+        node->hash = hash;
+        for (usize i = 0; i < this->label_keys_.size(); ++i) {
+            node->label_values.emplace_back(label_values[i]);
+            node->labels.emplace_back(MetricLabel{this->label_keys_[i], Token{node->label_values.back()}});
+        }
+        node->cell = this->make_cell();
+
+        if (this->registry_) {
+            this->export_cell(*this->registry_, this->name_, *node->cell, node->labels);
+        }
+
+        this->nodes_.emplace_back(std::move(node));
+        return this->nodes_.back().get();
+    }
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+    const std::vector<Token> label_keys_;
+
+    const usize max_series_;
+
+    const usize capacity_;
+
+    // Open-addressing hash table (linear probing) of series, keyed by label values.
+    //
+    std::unique_ptr<std::atomic<SeriesNode*>[]> table_;
+
+    std::atomic<usize> series_count_{0};
+
+    std::atomic<SeriesNode*> overflow_node_{nullptr};
+
+    std::atomic<u64> overflow_count_{0};
+
+    // Protects everything below.
+    //
+    mutable std::mutex mutex_;
+
+    // Owns all series nodes (including the overflow series), in creation order.
+    //
+    std::vector<std::unique_ptr<SeriesNode>> nodes_;
+
+    MetricRegistry* registry_ = nullptr;
+
+    std::string name_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/*! \brief A family of counters.  Each series is a ShardedCountMetric, so that threads updating the same
+ * series don't contend on a single cache line. */
+//
+template <typename T>
+class CounterFamily : public MetricFamily<ShardedCountMetric<T>>
+{
+   public:
+    using Super = MetricFamily<ShardedCountMetric<T>>;
+
+    /*! \brief Initializes an empty family.
+     *  \param The label keys of every series
+     *  \param The maximum number of distinct series */
+    explicit CounterFamily(std::vector<Token> label_keys,
+                           usize max_series = Super::kDefaultMaxSeries) noexcept
+        : Super{std::move(label_keys), max_series}
+    {
+    }
+
+   protected:
+    std::unique_ptr<ShardedCountMetric<T>> make_cell() const override
+    {
+        return std::make_unique<ShardedCountMetric<T>>();
+    }
+
+    void export_cell(MetricRegistry& registry, const std::string& name, ShardedCountMetric<T>& cell,
+                     const MetricLabelSet& labels) override
+    {
+        registry.add_exporter(this->registry_key(),
+                              make_function_metric_exporter(name, "counter",
+                                                            [&cell] {
+                                                                return cell.load();
+                                                            }),
+                              MetricLabelSet{labels});
+    }
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/*! \brief A family of gauges; each series is a GaugeMetric, exported as `<name>_gauge`. */
+//
+template <typename T>
+class GaugeFamily : public MetricFamily<GaugeMetric<T>>
+{
+   public:
+    using Super = MetricFamily<GaugeMetric<T>>;
+
+    /*! \brief Initializes an empty family.
+     *  \param The label keys of every series
+     *  \param The maximum number of distinct series */
+    explicit GaugeFamily(std::vector<Token> label_keys, usize max_series = Super::kDefaultMaxSeries) noexcept
+        : Super{std::move(label_keys), max_series}
+    {
+    }
+
+   protected:
+    std::unique_ptr<GaugeMetric<T>> make_cell() const override
+    {
+        return std::make_unique<GaugeMetric<T>>();
+    }
+
+    void export_cell(MetricRegistry& registry, const std::string& name, GaugeMetric<T>& cell,
+                     const MetricLabelSet& labels) override
+    {
+        registry.add_exporter(this->registry_key(),
+                              make_function_metric_exporter(to_string(name, "_gauge"), "gauge",
+                                                            [&cell] {
+                                                                return cell.load();
+                                                            }),
+                              MetricLabelSet{labels});
+    }
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/*! \brief A family of histograms that all use the same bucket bounds.
+ *
+ * Each series is exported Prometheus-style: a cumulative `<name>_bucket` counter per bucket, labelled with
+ * the bucket's upper bound as `le` ("+Inf" for the last bucket), plus `<name>_count` and `<name>_sum`.
+ */
+class HistogramFamily : public MetricFamily<HistogramMetric>
+{
+   public:
+    using Super = MetricFamily<HistogramMetric>;
+
+    /*! \brief Initializes an empty family.
+     *  \param The label keys of every series
+     *  \param The (sorted) upper bounds of the buckets of every series; see HistogramMetric
+     *  \param The maximum number of distinct series */
+    explicit HistogramFamily(std::vector<Token> label_keys, std::vector<double> upper_bounds,
+                             usize max_series = Super::kDefaultMaxSeries) noexcept
+        : Super{std::move(label_keys), max_series}
+        , upper_bounds_{std::make_shared<const std::vector<double>>(std::move(upper_bounds))}
+    {
+    }
+
+   protected:
+    std::unique_ptr<HistogramMetric> make_cell() const override
+    {
+        return std::make_unique<HistogramMetric>(this->upper_bounds_);
+    }
+
+    void export_cell(MetricRegistry& registry, const std::string& name, HistogramMetric& cell,
+                     const MetricLabelSet& labels) override
+    {
+        const std::string bucket_name = to_string(name, "_bucket");
+
+        for (usize i = 0; i < cell.bucket_count(); ++i) {
+            MetricLabelSet bucket_labels = labels;
+            bucket_labels.emplace_back(MetricLabel{
+                Token{"le"},
+                Token{(i + 1 < cell.bucket_count()) ? to_string(cell.upper_bound(i)) : std::string{"+Inf"}},
+            });
+
+            registry.add_exporter(this->registry_key(),
+                                  make_function_metric_exporter(bucket_name, "histogram",
+                                                                [&cell, i] {
+                                                                    u64 total = 0;
+                                                                    for (usize j = 0; j <= i; ++j) {
+                                                                        total += cell.bucket(j);
+                                                                    }
+                                                                    return total;
+                                                                }),
+                                  std::move(bucket_labels));
+        }
+
+        registry.add_exporter(this->registry_key(),
+                              make_function_metric_exporter(to_string(name, "_count"), "histogram",
+                                                            [&cell] {
+                                                                return cell.count();
+                                                            }),
+                              MetricLabelSet{labels});
+
+        registry.add_exporter(this->registry_key(),
+                              make_function_metric_exporter(to_string(name, "_sum"), "histogram",
+                                                            [&cell] {
+                                                                return cell.sum();
+                                                            }),
+                              MetricLabelSet{labels});
+    }
+
+   private:
+    std::shared_ptr<const std::vector<double>> upper_bounds_;
+};
+
+}  // namespace batt
+
+#endif  // BATTERIES_METRICS_METRIC_FAMILY_HPP
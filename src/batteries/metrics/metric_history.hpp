@@ -0,0 +1,161 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2021-2023 Anthony Paul Astolfi, Eitan Steiner
+//
+#pragma once
+#ifndef BATTERIES_METRICS_METRIC_HISTORY_HPP
+#define BATTERIES_METRICS_METRIC_HISTORY_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/metrics/metric_registry.hpp>
+#include <batteries/metrics/metric_time_series.hpp>
+
+#include <batteries/int_types.hpp>
+#include <batteries/optional.hpp>
+#include <batteries/token.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace batt {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Keeps a recent history of all the metrics in a MetricRegistry, in memory, at several resolutions.
+//
+// Every `period` of the finest resolution, the current value of each metric is appended to that
+// resolution's MetricTimeSeries.  Each coarser resolution stores the average of the samples taken during each
+// of its periods.  Sample times are rounded down to a multiple of the resolution's period, which makes the
+// timestamps compress to a single bit per sample.
+//
+// Call `start()` to sample in the background (like MetricDumper), or call `sample` directly.
+//
+class MetricHistory
+{
+   public:
+    struct Resolution {
+        // The time between samples; must be a multiple of the period of the previous (finer) resolution.
+        //
+        std::chrono::milliseconds period;
+
+        // The number of samples to keep.
+        //
+        usize capacity;
+    };
+
+    // One second for five minutes, ten seconds for an hour, and one minute for a day.
+    //
+    static std::vector<Resolution> default_resolutions();
+
+    // The current time as used by `start()`: milliseconds since the (system clock) epoch.
+    //
+    static i64 now_ms();
+
+    explicit MetricHistory(MetricRegistry& registry,
+                           std::vector<Resolution> resolutions = default_resolutions()) noexcept;
+
+    ~MetricHistory() noexcept;
+
+    const std::vector<Resolution>& resolutions() const
+    {
+        return this->resolutions_;
+    }
+
+    // Starts a background thread that calls `sample(now_ms())` once per period of the finest resolution.
+    //
+    void start();
+
+    void halt();
+
+    void join();
+
+    void stop()
+    {
+        this->halt();
+        this->join();
+    }
+
+    // Reads the current value of all metrics and records it as of `time_ms`.  If a sample has already been
+    // taken in the same period of the finest resolution, this does nothing.
+    //
+    void sample(i64 time_ms);
+
+    // Returns the id of the metric with the given name and labels, if it is being recorded.
+    //
+    Optional<MetricId> find_metric(std::string_view name, const MetricLabelSet& labels = {}) const;
+
+    // Appends the recorded samples of metric `id` with `begin_ms <= time_ms < end_ms` to `out`, oldest first,
+    // using the finest resolution that goes back as far as `begin_ms` (or the one that goes back furthest,
+    // if none do).  Returns the index of the resolution used, or None if the metric isn't being recorded.
+    //
+    Optional<usize> query(MetricId id, i64 begin_ms, i64 end_ms, std::vector<MetricSample>& out) const;
+
+    // The total size of all compressed sample data.
+    //
+    usize compressed_size() const;
+
+   private:
+    // Accumulates the samples of a single period, to be averaged into a coarser resolution.
+    //
+    struct Accumulator {
+        i64 period_start = 0;
+        double total = 0;
+        usize count = 0;
+    };
+
+    struct Series {
+        explicit Series(MetricId id, Token name, const MetricLabelSet& labels,
+                        const std::vector<Resolution>& resolutions) noexcept;
+
+        MetricId id;
+        Token name;
+        MetricLabelSet labels;
+
+        // One per resolution.
+        //
+        std::vector<MetricTimeSeries> levels;
+
+        // One per resolution, except the finest.
+        //
+        std::vector<Accumulator> accumulators;
+    };
+
+    // Rebuilds `series_` from the metrics currently in the registry; called with `mutex_` held.
+    //
+    void refresh_series();
+
+    void append_sample(Series& series, i64 time_ms, double value);
+
+    MetricRegistry& registry_;
+    const std::vector<Resolution> resolutions_;
+
+    mutable std::mutex mutex_;
+
+    // All recorded metrics, in increasing id order.
+    //
+    std::vector<std::unique_ptr<Series>> series_;
+
+    u64 schema_version_ = ~u64{0};
+    Optional<i64> last_sample_time_;
+
+    // So we don't have to keep reallocating.
+    //
+    MetricSnapshot snapshot_;
+
+    std::atomic<bool> halt_requested_{false};
+    std::promise<bool> done_;
+    Optional<std::thread> thread_;
+};
+
+}  // namespace batt
+
+#endif  // BATTERIES_METRICS_METRIC_HISTORY_HPP
+
+#if BATT_HEADER_ONLY
+#include <batteries/metrics/metric_history_impl.hpp>
+#endif  // BATT_HEADER_ONLY
@@ -0,0 +1,297 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2021-2023 Anthony Paul Astolfi, Eitan Steiner
+//
+#pragma once
+#ifndef BATTERIES_METRICS_METRIC_HISTORY_IMPL_HPP
+#define BATTERIES_METRICS_METRIC_HISTORY_IMPL_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/metrics/metric_history.hpp>
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace batt {
+
+namespace detail {
+
+// Rounds `time_ms` down to a multiple of `period_ms` (towards negative infinity).
+//
+inline i64 metric_period_start(i64 time_ms, i64 period_ms)
+{
+    const i64 remainder = time_ms % period_ms;
+    return time_ms - remainder - ((remainder < 0) ? period_ms : 0);
+}
+
+}  // namespace detail
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL std::vector<MetricHistory::Resolution> MetricHistory::default_resolutions()
+{
+    return {
+        Resolution{std::chrono::seconds{1}, 300},
+        Resolution{std::chrono::seconds{10}, 360},
+        Resolution{std::chrono::minutes{1}, 1440},
+    };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL i64 MetricHistory::now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL /*explicit*/ MetricHistory::MetricHistory(MetricRegistry& registry,
+                                                           std::vector<Resolution> resolutions) noexcept
+    : registry_{registry}
+    , resolutions_{std::move(resolutions)}
+{
+    BATT_CHECK(!this->resolutions_.empty());
+
+    for (usize i = 0; i < this->resolutions_.size(); ++i) {
+        BATT_CHECK_GT(this->resolutions_[i].period.count(), 0);
+        if (i > 0) {
+            BATT_CHECK_EQ(this->resolutions_[i].period.count() % this->resolutions_[i - 1].period.count(), 0)
+                << "Each resolution's period must be a multiple of the previous one";
+        }
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL MetricHistory::~MetricHistory() noexcept
+{
+    this->stop();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricHistory::start()
+{
+    BATT_CHECK(!this->thread_) << "MetricHistory::start called more than once";
+
+    this->thread_.emplace([this] {
+        std::future<bool> done = this->done_.get_future();
+
+        const i64 period_ms = this->resolutions_.front().period.count();
+
+        for (;;) {
+            const i64 now = now_ms();
+            this->sample(now);
+
+            // Wake up at the start of the next period.
+            //
+            const i64 wait_ms = detail::metric_period_start(now, period_ms) + period_ms - now;
+
+            if (done.wait_for(std::chrono::milliseconds(wait_ms)) != std::future_status::timeout) {
+                break;
+            }
+        }
+    });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricHistory::halt()
+{
+    if (!this->halt_requested_.exchange(true)) {
+        this->done_.set_value(true);
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricHistory::join()
+{
+    if (this->thread_) {
+        this->thread_->join();
+        this->thread_ = None;
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricHistory::sample(i64 time_ms)
+{
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    const i64 sample_time = detail::metric_period_start(time_ms, this->resolutions_.front().period.count());
+    if (this->last_sample_time_ && sample_time <= *this->last_sample_time_) {
+        return;
+    }
+    this->last_sample_time_ = sample_time;
+
+    this->registry_.read_snapshot(this->snapshot_);
+    if (this->snapshot_.schema_version() != this->schema_version_) {
+        this->refresh_series();
+    }
+
+    // Both the snapshot and `series_` are in id order.
+    //
+    auto next_series = this->series_.begin();
+    for (const MetricSnapshot::Sample& sample : this->snapshot_.samples()) {
+        while (next_series != this->series_.end() && (*next_series)->id < sample.id) {
+            ++next_series;
+        }
+        if (next_series == this->series_.end()) {
+            break;
+        }
+        if ((*next_series)->id == sample.id) {
+            this->append_sample(**next_series, sample_time, sample.value);
+        }
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricHistory::refresh_series()
+{
+    std::vector<std::unique_ptr<Series>> old_series;
+    std::swap(old_series, this->series_);
+
+    // Keep the history of metrics that are still registered; forget the rest.
+    //
+    auto next_old = old_series.begin();
+    this->schema_version_ = this->registry_.for_each_descriptor([&](const MetricDescriptor& metric) {
+        while (next_old != old_series.end() && (*next_old)->id < metric.id) {
+            ++next_old;
+        }
+        if (next_old != old_series.end() && (*next_old)->id == metric.id) {
+            this->series_.emplace_back(std::move(*next_old));
+            ++next_old;
+        } else {
+            this->series_.emplace_back(
+                std::make_unique<Series>(metric.id, metric.name, metric.labels, this->resolutions_));
+        }
+    });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricHistory::append_sample(Series& series, i64 time_ms, double value)
+{
+    series.levels[0].append(time_ms, value);
+
+    for (usize i = 1; i < this->resolutions_.size(); ++i) {
+        Accumulator& acc = series.accumulators[i - 1];
+        const i64 period_start = detail::metric_period_start(time_ms, this->resolutions_[i].period.count());
+
+        if (acc.count != 0 && acc.period_start != period_start) {
+            series.levels[i].append(acc.period_start, acc.total / static_cast<double>(acc.count));
+            acc.total = 0;
+            acc.count = 0;
+        }
+        acc.period_start = period_start;
+        acc.total += value;
+        acc.count += 1;
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Optional<MetricId> MetricHistory::find_metric(std::string_view name,
+                                                               const MetricLabelSet& labels) const
+{
+    const MetricLabelSet normalized_labels = normalize_labels(MetricLabelSet{labels});
+
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    for (const std::unique_ptr<Series>& series : this->series_) {
+        if (static_cast<const std::string&>(series->name) != name ||
+            series->labels.size() != normalized_labels.size()) {
+            continue;
+        }
+        if (std::equal(series->labels.begin(), series->labels.end(), normalized_labels.begin(),
+                       [](const MetricLabel& l, const MetricLabel& r) {
+                           return l.key == r.key && l.value == r.value;
+                       })) {
+            return series->id;
+        }
+    }
+    return None;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Optional<usize> MetricHistory::query(MetricId id, i64 begin_ms, i64 end_ms,
+                                                      std::vector<MetricSample>& out) const
+{
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    const auto iter = std::lower_bound(this->series_.begin(), this->series_.end(), id,
+                                       [](const std::unique_ptr<Series>& series, MetricId id) {
+                                           return series->id < id;
+                                       });
+    if (iter == this->series_.end() || (*iter)->id != id) {
+        return None;
+    }
+    const Series& series = **iter;
+
+    // Find the finest resolution that covers `begin_ms`; failing that, the one with the oldest data.
+    //
+    usize level = 0;
+    Optional<i64> level_oldest_time = series.levels[0].oldest_time();
+    for (usize i = 0; i < series.levels.size(); ++i) {
+        const Optional<i64> oldest_time = series.levels[i].oldest_time();
+        if (!oldest_time) {
+            continue;
+        }
+        if (*oldest_time <= begin_ms) {
+            level = i;
+            break;
+        }
+        if (!level_oldest_time || *oldest_time < *level_oldest_time) {
+            level = i;
+            level_oldest_time = oldest_time;
+        }
+    }
+
+    series.levels[level].for_each_in_range(begin_ms, end_ms, [&out](const MetricSample& sample) {
+        out.emplace_back(sample);
+    });
+
+    return level;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL usize MetricHistory::compressed_size() const
+{
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    usize total = 0;
+    for (const std::unique_ptr<Series>& series : this->series_) {
+        for (const MetricTimeSeries& level : series->levels) {
+            total += level.compressed_size();
+        }
+    }
+    return total;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL MetricHistory::Series::Series(MetricId id, Token name, const MetricLabelSet& labels,
+                                               const std::vector<Resolution>& resolutions) noexcept
+    : id{id}
+    , name{std::move(name)}
+    , labels{labels}
+    , accumulators(resolutions.size() - 1)
+{
+    this->levels.reserve(resolutions.size());
+    for (const Resolution& resolution : resolutions) {
+        this->levels.emplace_back(resolution.capacity);
+    }
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_METRICS_METRIC_HISTORY_IMPL_HPP
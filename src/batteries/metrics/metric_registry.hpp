@@ -18,10 +18,12 @@
 #include <batteries/stream_util.hpp>
 #include <batteries/token.hpp>
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <string_view>
-#include <unordered_map>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace batt {
@@ -121,7 +123,17 @@ using CountMetricExporter = ScalarMetricExporter<CountMetric<T>>;
 /*! \brief Exports a GaugeMetric<T>. */
 //
 template <typename T>
-using GaugeMetricExporter = ScalarMetricExporter<GaugeMetric<T>>;
+class GaugeMetricExporter : public ScalarMetricExporter<GaugeMetric<T>>
+{
+   public:
+    using ScalarMetricExporter<GaugeMetric<T>>::ScalarMetricExporter;
+
+    /*! \return The metric type. */
+    std::string_view get_type() const override
+    {
+        return "gauge";
+    }
+};
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 // Exports a DerivedMetric<T>.
@@ -167,6 +179,11 @@ class VariableExporter : public MetricExporter
         return this->name_;
     }
 
+    std::string_view get_type() const override
+    {
+        return "gauge";
+    }
+
     double get_value() const override
     {
         return static_cast<double>(this->var_);
@@ -193,6 +210,11 @@ class WatchExporter : public MetricExporter
         return this->name_;
     }
 
+    std::string_view get_type() const override
+    {
+        return "gauge";
+    }
+
     double get_value() const override
     {
         return static_cast<double>(this->watch_.get_value());
@@ -220,6 +242,11 @@ class QueueDepthExporter : public MetricExporter
         return this->name_;
     }
 
+    std::string_view get_type() const override
+    {
+        return "gauge";
+    }
+
     double get_value() const override
     {
         return static_cast<double>(this->queue_.size());
@@ -230,6 +257,101 @@ class QueueDepthExporter : public MetricExporter
     QueueBase& queue_;
 };
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Exports the current rate of a WindowedRateMetric or EwmaRateMetric.
+//
+template <typename T>
+class RateMetricExporter : public MetricExporter
+{
+   public:
+    explicit RateMetricExporter(const std::string& name, T& metric) noexcept : name_{name}, metric_{metric}
+    {
+    }
+
+    Token get_name() const override
+    {
+        return this->name_;
+    }
+
+    std::string_view get_type() const override
+    {
+        return "gauge";
+    }
+
+    double get_value() const override
+    {
+        return this->metric_.rate();
+    }
+
+   private:
+    Token name_;
+    T& metric_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Identifies a single exported metric within a MetricRegistry.  Ids are assigned in registration order and
+// are never reused, even after the metric is removed.
+//
+using MetricId = u64;
+
+// The name, labels and type of an exported metric, fixed when it is registered.
+//
+struct MetricDescriptor {
+    MetricId id;
+    Token name;
+    const MetricLabelSet& labels;
+
+    // See MetricExporter::get_type: "counter" (a cumulative value) or "gauge".
+    //
+    std::string_view type;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// A caller-owned buffer of metric values, filled by MetricRegistry::read_snapshot.  Reusing the same
+// snapshot object for repeated reads avoids allocation once it has grown to hold all the metrics.
+//
+class MetricSnapshot
+{
+   public:
+    struct Sample {
+        MetricId id;
+        double value;
+    };
+
+    // The values read by the last call to MetricRegistry::read_snapshot, in increasing id order.
+    //
+    const std::vector<Sample>& samples() const
+    {
+        return this->samples_;
+    }
+
+    // Changes whenever metrics are added to or removed from the registry; a reader that caches information
+    // about the set of metrics (see MetricRegistry::for_each_descriptor) should refresh it when this changes.
+    //
+    u64 schema_version() const
+    {
+        return this->schema_version_;
+    }
+
+   private:
+    friend class MetricRegistry;
+
+    std::vector<Sample> samples_;
+    u64 schema_version_ = 0;
+};
+
+namespace detail {
+
+template <typename T, typename = void>
+struct IsMetricFamily : std::false_type {
+};
+
+template <typename T>
+struct IsMetricFamily<T, std::void_t<decltype(std::declval<T&>().detach_from_registry())>> : std::true_type {
+};
+
+}  // namespace detail
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 // A set of metric exporters.
 //
@@ -241,7 +363,9 @@ class MetricRegistry
     {
         exporter->set_labels(std::move(labels));
         std::unique_lock<std::mutex> lock{this->mutex_};
-        this->metrics_.emplace(obj, std::move(exporter));
+        this->metrics_.emplace_back(Entry{this->next_id_, obj, std::move(exporter)});
+        this->next_id_ += 1;
+        this->schema_version_ += 1;
         return *this;
     }
 
@@ -309,6 +433,28 @@ class MetricRegistry
         return *this;
     }
 
+    template <i64 kWindowSeconds>
+    MetricRegistry& add(std::string_view name, WindowedRateMetric<kWindowSeconds>& rate,
+                        MetricLabelSet&& labels = MetricLabelSet{})
+    {
+        BATT_VLOG(1) << "adding WindowedRateMetric:" << name;
+
+        return this->add_exporter(&rate,
+                                  std::make_unique<RateMetricExporter<WindowedRateMetric<kWindowSeconds>>>(
+                                      to_string(name, "_rate"), rate),
+                                  std::move(labels));
+    }
+
+    MetricRegistry& add(std::string_view name, EwmaRateMetric& rate,
+                        MetricLabelSet&& labels = MetricLabelSet{})
+    {
+        BATT_VLOG(1) << "adding EwmaRateMetric:" << name;
+
+        return this->add_exporter(
+            &rate, std::make_unique<RateMetricExporter<EwmaRateMetric>>(to_string(name, "_ewma_rate"), rate),
+            std::move(labels));
+    }
+
     template <typename T>
     MetricRegistry& add(std::string_view name, Watch<T>& watch, MetricLabelSet&& labels = MetricLabelSet{})
     {
@@ -349,24 +495,38 @@ class MetricRegistry
                                   std::move(labels));
     }
 
+    // Exports all series of a metric family (see metric_family.hpp); series created later are added as they
+    // are created.
+    //
+    template <typename FamilyT, typename = decltype(std::declval<FamilyT&>().attach_to_registry(
+                                    std::declval<MetricRegistry&>(), std::string_view{}))>
+    MetricRegistry& add(std::string_view name, FamilyT& family)
+    {
+        BATT_VLOG(1) << "adding metric family:" << name;
+
+        family.attach_to_registry(*this, name);
+
+        return *this;
+    }
+
     // Invokes the passed function for all registered metrics.
     //
     void read_all(
         std::function<void(std::string_view name, double value, const MetricLabelSet& labels)>&& fn) const
     {
-        struct MetricSnapshot {
+        struct NamedValue {
             std::string_view name;
             double value;
             MetricLabelSet labels;
         };
-        std::vector<MetricSnapshot> local_snapshot;
+        std::vector<NamedValue> local_snapshot;
         {
             std::unique_lock<std::mutex> lock{this->mutex_};
-            for (const auto& p : this->metrics_) {
-                local_snapshot.emplace_back(MetricSnapshot{
-                    static_cast<const std::string&>(p.second->get_name()),
-                    p.second->get_value(),
-                    p.second->get_labels(),
+            for (const Entry& entry : this->metrics_) {
+                local_snapshot.emplace_back(NamedValue{
+                    static_cast<const std::string&>(entry.exporter->get_name()),
+                    entry.exporter->get_value(),
+                    entry.exporter->get_labels(),
                 });
             }
         }
@@ -375,13 +535,61 @@ class MetricRegistry
         }
     }
 
+    // Reads the current value of all registered metrics into `snapshot`, replacing its previous contents.
+    // Unlike `read_all`, this copies no names or labels (use `for_each_descriptor` to look those up by id),
+    // so it doesn't allocate unless `snapshot` needs to grow.
+    //
+    void read_snapshot(MetricSnapshot& snapshot) const
+    {
+        std::unique_lock<std::mutex> lock{this->mutex_};
+
+        snapshot.samples_.resize(this->metrics_.size());
+        snapshot.schema_version_ = this->schema_version_;
+
+        MetricSnapshot::Sample* next_sample = snapshot.samples_.data();
+        for (const Entry& entry : this->metrics_) {
+            next_sample->id = entry.id;
+            next_sample->value = entry.exporter->get_value();
+            ++next_sample;
+        }
+    }
+
+    // Invokes `fn` with the MetricDescriptor of each registered metric, in increasing id order, and returns
+    // the current schema version (see MetricSnapshot::schema_version).  The registry is locked for the
+    // duration, so `fn` must not call back into this object.
+    //
+    template <typename Fn>
+    u64 for_each_descriptor(Fn&& fn) const
+    {
+        std::unique_lock<std::mutex> lock{this->mutex_};
+
+        for (const Entry& entry : this->metrics_) {
+            fn(MetricDescriptor{entry.id, entry.exporter->get_name(), entry.exporter->get_labels(),
+                                entry.exporter->get_type()});
+        }
+        return this->schema_version_;
+    }
+
     // Removes the passed metric from this registry.
     //
     template <typename T>
     MetricRegistry& remove(T& obj)
     {
+        // Stop a metric family from adding new series before removing the ones it already has.
+        //
+        if constexpr (detail::IsMetricFamily<T>{}) {
+            obj.detach_from_registry();
+        }
+
         std::unique_lock<std::mutex> lock{this->mutex_};
-        this->metrics_.erase(&obj);
+        const auto first_removed =
+            std::remove_if(this->metrics_.begin(), this->metrics_.end(), [&obj](const Entry& entry) {
+                return entry.obj == &obj;
+            });
+        if (first_removed != this->metrics_.end()) {
+            this->metrics_.erase(first_removed, this->metrics_.end());
+            this->schema_version_ += 1;
+        }
         return *this;
     }
 
@@ -399,8 +607,22 @@ class MetricRegistry
     }
 
    private:
+    struct Entry {
+        MetricId id;
+        const void* obj;
+        std::unique_ptr<MetricExporter> exporter;
+    };
+
     mutable std::mutex mutex_;
-    std::unordered_multimap<const void*, std::unique_ptr<MetricExporter>> metrics_;
+
+    // All registered metrics, in increasing id order; stored contiguously so that reading a snapshot is a
+    // single linear scan.
+    //
+    std::vector<Entry> metrics_;
+
+    MetricId next_id_ = 0;
+
+    u64 schema_version_ = 0;
 };
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -0,0 +1,155 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2021-2023 Anthony Paul Astolfi, Eitan Steiner
+//
+#pragma once
+#ifndef BATTERIES_METRICS_METRIC_STATSD_EXPORTER_HPP
+#define BATTERIES_METRICS_METRIC_STATSD_EXPORTER_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/metrics/metric_registry.hpp>
+
+#include <batteries/async/task.hpp>
+#include <batteries/async/watch.hpp>
+
+#include <batteries/int_types.hpp>
+#include <batteries/optional.hpp>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace batt {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Periodically pushes the metrics in a MetricRegistry to a StatsD agent over UDP.
+//
+// Each round reads a snapshot of the registry and sends one line per metric, packing as many lines as fit
+// into each datagram:
+//
+//  - counters (MetricExporter::get_type() == "counter") are sent as `<name>:<delta>|c`, where the delta is
+//    the change since the previous round (or the full value, the first time a counter is seen); counters that
+//    didn't change are skipped
+//  - everything else is sent as `<name>:<value>|g`; since StatsD reads a signed gauge value as a change, a
+//    negative value is sent as `<name>:0|g` followed by `<name>:<value>|g` in the same datagram
+//
+// Labels are sent as DogStatsD-style tags: `|#key:value,...`.
+//
+// The rounds are run by a Task on the executor passed to the constructor; a final round is sent when the
+// exporter is stopped, so that counter increments since the last round aren't lost.
+//
+class MetricStatsdExporter
+{
+   public:
+    struct Options {
+        // How often to send the metrics.
+        //
+        std::chrono::milliseconds interval{10000};
+
+        // The largest datagram to send, in bytes.  The default fits (with IP and UDP headers) within a
+        // 1500-byte Ethernet MTU.
+        //
+        usize max_datagram_size = 1432;
+
+        // Prepended to every metric name.
+        //
+        std::string prefix;
+    };
+
+    explicit MetricStatsdExporter(MetricRegistry& registry, const boost::asio::any_io_executor& ex,
+                                  const boost::asio::ip::udp::endpoint& destination) noexcept;
+
+    explicit MetricStatsdExporter(MetricRegistry& registry, const boost::asio::any_io_executor& ex,
+                                  const boost::asio::ip::udp::endpoint& destination,
+                                  Options options) noexcept;
+
+    ~MetricStatsdExporter() noexcept;
+
+    void halt();
+
+    void join();
+
+    void stop()
+    {
+        this->halt();
+        this->join();
+    }
+
+    // The number of datagrams sent so far.
+    //
+    u64 datagram_count() const
+    {
+        return this->datagram_count_.load();
+    }
+
+    // The number of failed sends so far.
+    //
+    u64 error_count() const
+    {
+        return this->error_count_.load();
+    }
+
+   private:
+    // The formatted parts of a metric's lines, so each round only has to format the value.
+    //
+    struct Column {
+        MetricId id;
+        bool is_counter;
+        std::string name;    // `<prefix><name>:`
+        std::string suffix;  // `|c` or `|g`, plus tags
+        double last_value;
+        bool has_last_value;
+    };
+
+    void run();
+
+    // Blocks the task until `halt` is called or `timeout` has elapsed; returns true if halted.
+    //
+    bool await_halt_requested(std::chrono::milliseconds timeout);
+
+    void send_round();
+
+    void refresh_columns();
+
+    void append_line(std::string_view line);
+
+    void flush_datagram();
+
+    MetricRegistry& registry_;
+    const boost::asio::ip::udp::endpoint destination_;
+    const Options options_;
+    boost::asio::ip::udp::socket socket_;
+    Watch<bool> halt_requested_{false};
+
+    // The timer for the wait between rounds; guarded by `timer_mutex_`, so that `halt` can cancel it.
+    //
+    std::mutex timer_mutex_;
+    boost::asio::steady_timer timer_;
+
+    std::atomic<u64> datagram_count_{0};
+    std::atomic<u64> error_count_{0};
+
+    // Only accessed by `task_`.
+    //
+    Optional<u64> schema_version_;
+    std::vector<Column> columns_;
+    MetricSnapshot snapshot_;
+    std::string datagram_;
+    std::string line_;
+
+    Optional<Task> task_;
+};
+
+}  // namespace batt
+
+#endif  // BATTERIES_METRICS_METRIC_STATSD_EXPORTER_HPP
+
+#if BATT_HEADER_ONLY
+#include <batteries/metrics/metric_statsd_exporter_impl.hpp>
+#endif  // BATT_HEADER_ONLY
@@ -0,0 +1,295 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2021-2023 Anthony Paul Astolfi, Eitan Steiner
+//
+#pragma once
+#ifndef BATTERIES_METRICS_METRIC_STATSD_EXPORTER_IMPL_HPP
+#define BATTERIES_METRICS_METRIC_STATSD_EXPORTER_IMPL_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/metrics/metric_statsd_exporter.hpp>
+
+#include <batteries/async/io_result.hpp>
+#include <batteries/logging.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+namespace batt {
+
+namespace detail {
+
+// Appends `s` to `dst`, replacing the characters that have a meaning in the StatsD line format.
+//
+inline void append_statsd_escaped(std::string& dst, std::string_view s)
+{
+    for (char ch : s) {
+        switch (ch) {
+        case ':':
+        case '|':
+        case '@':
+        case '#':
+        case ',':
+        case '\n':
+            dst.push_back('_');
+            break;
+        default:
+            dst.push_back(ch);
+            break;
+        }
+    }
+}
+
+}  // namespace detail
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL MetricStatsdExporter::MetricStatsdExporter(
+    MetricRegistry& registry, const boost::asio::any_io_executor& ex,
+    const boost::asio::ip::udp::endpoint& destination) noexcept
+    : MetricStatsdExporter{registry, ex, destination, Options{}}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL MetricStatsdExporter::MetricStatsdExporter(MetricRegistry& registry,
+                                                            const boost::asio::any_io_executor& ex,
+                                                            const boost::asio::ip::udp::endpoint& destination,
+                                                            Options options) noexcept
+    : registry_{registry}
+    , destination_{destination}
+    , options_{std::move(options)}
+    , socket_{ex}
+    , timer_{ex}
+{
+    this->task_.emplace(
+        ex,
+        [this] {
+            this->run();
+        },
+        "MetricStatsdExporter");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL MetricStatsdExporter::~MetricStatsdExporter() noexcept
+{
+    this->stop();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricStatsdExporter::halt()
+{
+    this->halt_requested_.set_value(true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricStatsdExporter::join()
+{
+    if (this->task_) {
+        this->task_->join();
+    }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricStatsdExporter::run()
+{
+    ErrorCode ec;
+    this->socket_.open(this->destination_.protocol(), ec);
+    if (ec) {
+        BATT_LOG(WARNING) << "MetricStatsdExporter failed to open socket: " << ec.message();
+        this->error_count_.fetch_add(1);
+        return;
+    }
+
+    // Cut short the wait for the next round as soon as `halt` is called.
+    //
+    this->halt_requested_.async_wait(/*last_seen=*/false, [this](const StatusOr<bool>& /*halted*/) {
+        std::unique_lock<std::mutex> lock{this->timer_mutex_};
+        this->timer_.cancel();
+    });
+
+    for (;;) {
+        const bool halted = this->await_halt_requested(this->options_.interval);
+        this->send_round();
+        if (halted) {
+            break;
+        }
+    }
+
+    this->socket_.close(ec);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL bool MetricStatsdExporter::await_halt_requested(std::chrono::milliseconds timeout)
+{
+    Task::await<ErrorCode>([&](auto&& handler) {
+        // Check the Watch while holding the timer lock, so that `halt` either sees the wait below (and
+        // cancels it), or happened before it.
+        //
+        std::unique_lock<std::mutex> lock{this->timer_mutex_};
+        if (this->halt_requested_.get_value()) {
+            BATT_FORWARD(handler)(ErrorCode{});
+            return;
+        }
+        this->timer_.expires_after(timeout);
+        this->timer_.async_wait(BATT_FORWARD(handler));
+    });
+
+    return this->halt_requested_.get_value();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricStatsdExporter::send_round()
+{
+    this->registry_.read_snapshot(this->snapshot_);
+    if (!this->schema_version_ || this->snapshot_.schema_version() != *this->schema_version_) {
+        this->refresh_columns();
+    }
+
+    // Both the snapshot and `columns_` are in id order.
+    //
+    auto next_column = this->columns_.begin();
+    for (const MetricSnapshot::Sample& sample : this->snapshot_.samples()) {
+        while (next_column != this->columns_.end() && next_column->id < sample.id) {
+            ++next_column;
+        }
+        if (next_column == this->columns_.end()) {
+            break;
+        }
+        if (next_column->id != sample.id) {
+            continue;
+        }
+        Column& column = *next_column;
+
+        double value = sample.value;
+        if (!std::isfinite(value)) {
+            continue;
+        }
+        if (column.is_counter) {
+            // A counter that went down was reset; count everything since the reset.
+            //
+            if (column.has_last_value && value >= column.last_value) {
+                value -= column.last_value;
+            }
+            column.last_value = sample.value;
+            column.has_last_value = true;
+            if (value == 0) {
+                continue;
+            }
+        }
+
+        char value_str[32];
+        const int value_len = std::snprintf(value_str, sizeof(value_str), "%.15g", value);
+
+        this->line_.clear();
+        if (!column.is_counter && std::signbit(value)) {
+            // A signed gauge value means "change by this amount", so a negative gauge is sent as a reset to
+            // zero followed by the (negative) change, in the same datagram.
+            //
+            this->line_ += column.name;
+            this->line_ += "0";
+            this->line_ += column.suffix;
+            this->line_ += "\n";
+        }
+        this->line_ += column.name;
+        this->line_.append(value_str, value_len);
+        this->line_ += column.suffix;
+
+        this->append_line(this->line_);
+    }
+
+    this->flush_datagram();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricStatsdExporter::refresh_columns()
+{
+    std::vector<Column> old_columns;
+    std::swap(old_columns, this->columns_);
+
+    // Keep the last values of counters that are still registered, so their deltas stay correct.
+    //
+    auto next_old = old_columns.begin();
+    this->schema_version_ = this->registry_.for_each_descriptor([&](const MetricDescriptor& metric) {
+        while (next_old != old_columns.end() && next_old->id < metric.id) {
+            ++next_old;
+        }
+        if (next_old != old_columns.end() && next_old->id == metric.id) {
+            this->columns_.emplace_back(std::move(*next_old));
+            ++next_old;
+            return;
+        }
+
+        Column column;
+        column.id = metric.id;
+        column.is_counter = (metric.type == "counter");
+        column.last_value = 0;
+        column.has_last_value = false;
+
+        detail::append_statsd_escaped(column.name, this->options_.prefix);
+        detail::append_statsd_escaped(column.name, metric.name.get());
+        column.name += ":";
+
+        column.suffix = column.is_counter ? "|c" : "|g";
+        for (usize i = 0; i < metric.labels.size(); ++i) {
+            column.suffix += (i == 0) ? "|#" : ",";
+            detail::append_statsd_escaped(column.suffix, metric.labels[i].key.get());
+            column.suffix += ":";
+            detail::append_statsd_escaped(column.suffix, metric.labels[i].value.get());
+        }
+
+        this->columns_.emplace_back(std::move(column));
+    });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricStatsdExporter::append_line(std::string_view line)
+{
+    if (!this->datagram_.empty() &&
+        this->datagram_.size() + 1 + line.size() > this->options_.max_datagram_size) {
+        this->flush_datagram();
+    }
+    if (!this->datagram_.empty()) {
+        this->datagram_ += "\n";
+    }
+    this->datagram_ += line;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricStatsdExporter::flush_datagram()
+{
+    if (this->datagram_.empty()) {
+        return;
+    }
+
+    IOResult<usize> result = Task::await<IOResult<usize>>([&](auto&& handler) {
+        this->socket_.async_send_to(boost::asio::buffer(this->datagram_), this->destination_,
+                                    BATT_FORWARD(handler));
+    });
+
+    if (result.ok()) {
+        this->datagram_count_.fetch_add(1);
+    } else {
+        BATT_VLOG(1) << "MetricStatsdExporter failed to send: " << result.error().message();
+        this->error_count_.fetch_add(1);
+    }
+
+    this->datagram_.clear();
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_METRICS_METRIC_STATSD_EXPORTER_IMPL_HPP
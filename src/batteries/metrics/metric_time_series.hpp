@@ -0,0 +1,154 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2021-2023 Anthony Paul Astolfi, Eitan Steiner
+//
+#pragma once
+#ifndef BATTERIES_METRICS_METRIC_TIME_SERIES_HPP
+#define BATTERIES_METRICS_METRIC_TIME_SERIES_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/int_types.hpp>
+#include <batteries/optional.hpp>
+
+#include <vector>
+
+namespace batt {
+
+// A single value of a metric, with the time (in milliseconds) at which it was sampled.
+//
+struct MetricSample {
+    i64 time_ms;
+    double value;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// A fixed-capacity, compressed ring buffer of MetricSample values.
+//
+// Samples are stored in blocks of up to kSamplesPerBlock.  Within a block, timestamps are encoded as the
+// delta of the delta from the previous timestamp and values as the XOR with the previous value (the scheme
+// described in "Gorilla: A Fast, Scalable, In-Memory Time Series Database", Pelkonen et al. 2015); samples
+// taken at a regular interval of a slowly changing metric take only a couple of bits each.  When all blocks
+// are full, the oldest block is reused, so at least `capacity` of the most recent samples are retained.
+// Once all blocks have been used, appending doesn't allocate.
+//
+class MetricTimeSeries
+{
+   public:
+    static constexpr usize kSamplesPerBlock = 120;
+
+    explicit MetricTimeSeries(usize capacity) noexcept;
+
+    // The minimum number of (most recent) samples retained.
+    //
+    usize capacity() const
+    {
+        return this->capacity_;
+    }
+
+    // The number of samples currently retained; this may exceed `capacity()` by up to kSamplesPerBlock.
+    //
+    usize size() const;
+
+    // The time of the oldest/newest retained sample, or None if the series is empty.
+    //
+    Optional<i64> oldest_time() const;
+    Optional<i64> newest_time() const;
+
+    // The number of bytes used to hold the compressed samples.
+    //
+    usize compressed_size() const;
+
+    // Appends a sample; `time_ms` must not be less than the time of the newest sample.
+    //
+    void append(i64 time_ms, double value);
+
+    // Invokes `fn(const MetricSample&)` for each retained sample with `begin_ms <= time_ms < end_ms`, oldest
+    // first.  Only blocks that overlap the range are decoded.
+    //
+    template <typename Fn>
+    void for_each_in_range(i64 begin_ms, i64 end_ms, Fn&& fn) const
+    {
+        for (usize i = 0; i < this->block_count_; ++i) {
+            const Block& block = this->blocks_[(this->first_block_ + i) % this->blocks_.size()];
+            if (block.last_time < begin_ms) {
+                continue;
+            }
+            if (block.first_time >= end_ms) {
+                break;
+            }
+            BlockReader reader{block};
+            MetricSample sample;
+            while (reader.read_next(&sample)) {
+                if (sample.time_ms >= end_ms) {
+                    break;
+                }
+                if (sample.time_ms >= begin_ms) {
+                    fn(static_cast<const MetricSample&>(sample));
+                }
+            }
+        }
+    }
+
+   private:
+    struct Block {
+        // Compressed samples, most significant bit first.
+        //
+        std::vector<u64> words;
+        usize bit_count = 0;
+        usize sample_count = 0;
+
+        i64 first_time = 0;
+        i64 last_time = 0;
+
+        // Encoder state.
+        //
+        i64 last_delta = 0;
+        u64 last_value_bits = 0;
+        u32 last_leading_zeros = 0;
+        u32 last_trailing_zeros = 0;
+
+        void clear();
+
+        void write_bits(u64 bits, u32 n_bits);
+
+        void append(i64 time_ms, double value);
+    };
+
+    class BlockReader
+    {
+       public:
+        explicit BlockReader(const Block& block) noexcept : block_{block}
+        {
+        }
+
+        bool read_next(MetricSample* sample);
+
+       private:
+        u64 read_bits(u32 n_bits);
+
+        const Block& block_;
+        usize bit_offset_ = 0;
+        usize samples_read_ = 0;
+        i64 time_ = 0;
+        i64 delta_ = 0;
+        u64 value_bits_ = 0;
+        u32 leading_zeros_ = 0;
+        u32 trailing_zeros_ = 0;
+    };
+
+    const usize capacity_;
+
+    // Ring buffer of blocks; the live blocks are `first_block_ .. first_block_ + block_count_` (mod size).
+    //
+    std::vector<Block> blocks_;
+    usize first_block_ = 0;
+    usize block_count_ = 0;
+};
+
+}  // namespace batt
+
+#endif  // BATTERIES_METRICS_METRIC_TIME_SERIES_HPP
+
+#if BATT_HEADER_ONLY
+#include <batteries/metrics/metric_time_series_impl.hpp>
+#endif  // BATT_HEADER_ONLY
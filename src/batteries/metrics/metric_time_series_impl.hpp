@@ -0,0 +1,305 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2021-2023 Anthony Paul Astolfi, Eitan Steiner
+//
+#pragma once
+#ifndef BATTERIES_METRICS_METRIC_TIME_SERIES_IMPL_HPP
+#define BATTERIES_METRICS_METRIC_TIME_SERIES_IMPL_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/metrics/metric_time_series.hpp>
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace batt {
+
+namespace detail {
+
+inline u64 metric_value_bits(double value)
+{
+    u64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline double metric_value_from_bits(u64 bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Maps small negative and positive numbers to small unsigned numbers: 0, -1, 1, -2, 2, ...
+//
+inline u64 zigzag_encode(i64 n)
+{
+    return (static_cast<u64>(n) << 1) ^ static_cast<u64>(n >> 63);
+}
+
+inline i64 zigzag_decode(u64 z)
+{
+    return static_cast<i64>(z >> 1) ^ -static_cast<i64>(z & 1);
+}
+
+// Value of `leading_zeros` meaning that no XOR window has been written yet.
+//
+constexpr u32 kNoMetricValueWindow = 0xffffffffu;
+
+// The leading zero count is stored in 5 bits.
+//
+constexpr u32 kMaxMetricValueLeadingZeros = 31;
+
+}  // namespace detail
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL /*explicit*/ MetricTimeSeries::MetricTimeSeries(usize capacity) noexcept
+    : capacity_{capacity}
+    , blocks_((capacity + kSamplesPerBlock - 1) / kSamplesPerBlock + 1)
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL usize MetricTimeSeries::size() const
+{
+    usize total = 0;
+    for (usize i = 0; i < this->block_count_; ++i) {
+        total += this->blocks_[(this->first_block_ + i) % this->blocks_.size()].sample_count;
+    }
+    return total;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Optional<i64> MetricTimeSeries::oldest_time() const
+{
+    if (this->block_count_ == 0) {
+        return None;
+    }
+    return this->blocks_[this->first_block_].first_time;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL Optional<i64> MetricTimeSeries::newest_time() const
+{
+    if (this->block_count_ == 0) {
+        return None;
+    }
+    return this->blocks_[(this->first_block_ + this->block_count_ - 1) % this->blocks_.size()].last_time;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL usize MetricTimeSeries::compressed_size() const
+{
+    usize total = 0;
+    for (const Block& block : this->blocks_) {
+        total += block.words.capacity() * sizeof(u64);
+    }
+    return total;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricTimeSeries::append(i64 time_ms, double value)
+{
+    BATT_CHECK_GE(time_ms, this->newest_time().value_or(time_ms)) << "Samples must be appended in time order";
+
+    if (this->block_count_ == 0 ||
+        this->blocks_[(this->first_block_ + this->block_count_ - 1) % this->blocks_.size()].sample_count ==
+            kSamplesPerBlock) {
+        // Start a new block, dropping the oldest one if they are all in use.
+        //
+        if (this->block_count_ == this->blocks_.size()) {
+            this->first_block_ = (this->first_block_ + 1) % this->blocks_.size();
+            this->block_count_ -= 1;
+        }
+        this->blocks_[(this->first_block_ + this->block_count_) % this->blocks_.size()].clear();
+        this->block_count_ += 1;
+    }
+
+    Block& last_block = this->blocks_[(this->first_block_ + this->block_count_ - 1) % this->blocks_.size()];
+    last_block.append(time_ms, value);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricTimeSeries::Block::clear()
+{
+    this->words.clear();
+    this->bit_count = 0;
+    this->sample_count = 0;
+    this->first_time = 0;
+    this->last_time = 0;
+    this->last_delta = 0;
+    this->last_value_bits = 0;
+    this->last_leading_zeros = detail::kNoMetricValueWindow;
+    this->last_trailing_zeros = 0;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricTimeSeries::Block::write_bits(u64 bits, u32 n_bits)
+{
+    BATT_ASSERT_GE(n_bits, 1u);
+    BATT_ASSERT_LE(n_bits, 64u);
+
+    if (n_bits < 64) {
+        bits &= (u64{1} << n_bits) - 1;
+    }
+
+    const u32 offset = this->bit_count % 64;
+    if (offset == 0) {
+        this->words.push_back(0);
+    }
+
+    const u32 free_bits = 64 - offset;
+    if (n_bits <= free_bits) {
+        this->words.back() |= bits << (free_bits - n_bits);
+    } else {
+        this->words.back() |= bits >> (n_bits - free_bits);
+        this->words.push_back(bits << (64 - (n_bits - free_bits)));
+    }
+    this->bit_count += n_bits;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void MetricTimeSeries::Block::append(i64 time_ms, double value)
+{
+    const u64 value_bits = detail::metric_value_bits(value);
+
+    if (this->sample_count == 0) {
+        this->write_bits(static_cast<u64>(time_ms), 64);
+        this->write_bits(value_bits, 64);
+        this->first_time = time_ms;
+    } else {
+        // Timestamp: delta-of-delta, with a variable-length prefix code for its size.
+        //
+        const i64 delta = time_ms - this->last_time;
+        const u64 dod = detail::zigzag_encode(delta - this->last_delta);
+
+        if (dod == 0) {
+            this->write_bits(0b0, 1);
+        } else if (dod < (u64{1} << 7)) {
+            this->write_bits(0b10, 2);
+            this->write_bits(dod, 7);
+        } else if (dod < (u64{1} << 9)) {
+            this->write_bits(0b110, 3);
+            this->write_bits(dod, 9);
+        } else if (dod < (u64{1} << 12)) {
+            this->write_bits(0b1110, 4);
+            this->write_bits(dod, 12);
+        } else {
+            this->write_bits(0b1111, 4);
+            this->write_bits(dod, 64);
+        }
+        this->last_delta = delta;
+
+        // Value: XOR with the previous value; only the bits between the leading and trailing zeros are
+        // stored, reusing the previous window when the new bits fit inside it.
+        //
+        const u64 xor_bits = value_bits ^ this->last_value_bits;
+        if (xor_bits == 0) {
+            this->write_bits(0b0, 1);
+        } else {
+            const u32 leading_zeros =
+                std::min<u32>(__builtin_clzll(xor_bits), detail::kMaxMetricValueLeadingZeros);
+            const u32 trailing_zeros = __builtin_ctzll(xor_bits);
+
+            if (this->last_leading_zeros != detail::kNoMetricValueWindow &&
+                leading_zeros >= this->last_leading_zeros && trailing_zeros >= this->last_trailing_zeros) {
+                this->write_bits(0b10, 2);
+                this->write_bits(xor_bits >> this->last_trailing_zeros,
+                                 64 - this->last_leading_zeros - this->last_trailing_zeros);
+            } else {
+                const u32 n_meaningful_bits = 64 - leading_zeros - trailing_zeros;
+
+                this->write_bits(0b11, 2);
+                this->write_bits(leading_zeros, 5);
+                this->write_bits(n_meaningful_bits - 1, 6);
+                this->write_bits(xor_bits >> trailing_zeros, n_meaningful_bits);
+
+                this->last_leading_zeros = leading_zeros;
+                this->last_trailing_zeros = trailing_zeros;
+            }
+        }
+    }
+
+    this->last_time = time_ms;
+    this->last_value_bits = value_bits;
+    this->sample_count += 1;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL u64 MetricTimeSeries::BlockReader::read_bits(u32 n_bits)
+{
+    const usize word = this->bit_offset_ / 64;
+    const u32 offset = this->bit_offset_ % 64;
+    const u32 free_bits = 64 - offset;
+
+    u64 bits = (this->block_.words[word] << offset) >> (64 - n_bits);
+    if (n_bits > free_bits) {
+        bits |= this->block_.words[word + 1] >> (64 - (n_bits - free_bits));
+    }
+    this->bit_offset_ += n_bits;
+
+    return bits;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL bool MetricTimeSeries::BlockReader::read_next(MetricSample* sample)
+{
+    if (this->samples_read_ == this->block_.sample_count) {
+        return false;
+    }
+
+    if (this->samples_read_ == 0) {
+        this->time_ = static_cast<i64>(this->read_bits(64));
+        this->value_bits_ = this->read_bits(64);
+        this->leading_zeros_ = detail::kNoMetricValueWindow;
+    } else {
+        u64 dod = 0;
+        if (this->read_bits(1) != 0) {
+            if (this->read_bits(1) == 0) {
+                dod = this->read_bits(7);
+            } else if (this->read_bits(1) == 0) {
+                dod = this->read_bits(9);
+            } else if (this->read_bits(1) == 0) {
+                dod = this->read_bits(12);
+            } else {
+                dod = this->read_bits(64);
+            }
+        }
+        this->delta_ += detail::zigzag_decode(dod);
+        this->time_ += this->delta_;
+
+        if (this->read_bits(1) != 0) {
+            if (this->read_bits(1) != 0) {
+                this->leading_zeros_ = static_cast<u32>(this->read_bits(5));
+                const u32 n_meaningful_bits = static_cast<u32>(this->read_bits(6)) + 1;
+                this->trailing_zeros_ = 64 - this->leading_zeros_ - n_meaningful_bits;
+            }
+            const u32 n_meaningful_bits = 64 - this->leading_zeros_ - this->trailing_zeros_;
+            this->value_bits_ ^= this->read_bits(n_meaningful_bits) << this->trailing_zeros_;
+        }
+    }
+
+    this->samples_read_ += 1;
+
+    sample->time_ms = this->time_;
+    sample->value = detail::metric_value_from_bits(this->value_bits_);
+
+    return true;
+}
+
+}  // namespace batt
+
+#endif  // BATTERIES_METRICS_METRIC_TIME_SERIES_IMPL_HPP
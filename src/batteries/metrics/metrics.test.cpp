@@ -1,24 +1,45 @@
 //######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
 // Copyright 2022-2023 Anthony Paul Astolfi, Eitan Steiner
 //
+#include <batteries/metrics/metric_binary_formatter.hpp>
+#include <batteries/metrics/contention_metrics.hpp>
 #include <batteries/metrics/metric_collectors.hpp>
 #include <batteries/metrics/metric_csv_formatter.hpp>
 #include <batteries/metrics/metric_dumper.hpp>
+#include <batteries/metrics/metric_family.hpp>
 #include <batteries/metrics/metric_formatter.hpp>
+#include <batteries/metrics/metric_history.hpp>
 #include <batteries/metrics/metric_registry.hpp>
+#include <batteries/metrics/metric_statsd_exporter.hpp>
+#include <batteries/metrics/metric_time_series.hpp>
 //
+#include <batteries/metrics/metric_binary_formatter.hpp>
+#include <batteries/metrics/contention_metrics.hpp>
 #include <batteries/metrics/metric_collectors.hpp>
 #include <batteries/metrics/metric_csv_formatter.hpp>
 #include <batteries/metrics/metric_dumper.hpp>
+#include <batteries/metrics/metric_family.hpp>
 #include <batteries/metrics/metric_formatter.hpp>
+#include <batteries/metrics/metric_history.hpp>
 #include <batteries/metrics/metric_registry.hpp>
+#include <batteries/metrics/metric_statsd_exporter.hpp>
+#include <batteries/metrics/metric_time_series.hpp>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <experimental/random>
 
+#include <boost/asio/io_context.hpp>
+
+#include <atomic>
+
 #include <chrono>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace {
 
@@ -151,6 +172,125 @@ TEST(Metrics, RateMetricTest)
     EXPECT_THAT(actual_rate, testing::DoubleNear(expect_rate, 0.4 * expect_rate));  // 40% for robustness
 }
 
+TEST(Metrics, WindowedRateMetricTest)
+{
+    using Clock = std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+    using std::chrono::seconds;
+
+    const Clock::time_point t0 = Clock::now();
+    batt::WindowedRateMetric<4> rate{t0};
+
+    // No complete seconds yet.
+    //
+    rate.add(10, t0 + milliseconds(500));
+    EXPECT_EQ(rate.rate(t0 + milliseconds(900)), 0);
+
+    // Before a full window has passed, the rate is averaged over the complete seconds so far.
+    //
+    rate.add(20, t0 + milliseconds(1500));
+    EXPECT_EQ(rate.rate(t0 + seconds(1)), 10);
+    EXPECT_EQ(rate.rate(t0 + seconds(2)), 15);
+
+    rate.add(30, t0 + milliseconds(2100));
+    rate.add(40, t0 + milliseconds(3100));
+    EXPECT_EQ(rate.rate(t0 + seconds(4)), 25);  // (10 + 20 + 30 + 40) / 4
+
+    // Older seconds drop out of the window, even though their buckets are reused.
+    //
+    rate.add(50, t0 + milliseconds(4100));
+    rate.add(60, t0 + milliseconds(5100));
+    EXPECT_EQ(rate.rate(t0 + seconds(6)), 45);  // (30 + 40 + 50 + 60) / 4
+
+    rate.add(1, t0 + milliseconds(10100));
+    EXPECT_EQ(rate.rate(t0 + milliseconds(10999)), 0);
+    EXPECT_EQ(rate.rate(t0 + seconds(11)), 0.25);
+}
+
+TEST(Metrics, WindowedRateMetricConcurrentTest)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point t0 = Clock::now();
+    const Clock::time_point t1 = t0 + std::chrono::milliseconds(1500);
+    batt::WindowedRateMetric<1> rate{t0};
+
+    constexpr int kNumThreads = 4;
+    constexpr int kNumAdds = 100000;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kNumThreads; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < kNumAdds; ++j) {
+                rate.add(1, t1);
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(rate.rate(t0 + std::chrono::seconds(2)), kNumThreads * kNumAdds);
+}
+
+TEST(Metrics, EwmaRateMetricTest)
+{
+    using Clock = std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+    using std::chrono::seconds;
+
+    const Clock::time_point t0 = Clock::now();
+    batt::EwmaRateMetric rate{/*time_constant=*/seconds(10), /*tick_interval=*/seconds(1), t0};
+
+    EXPECT_EQ(rate.rate(t0), 0);
+
+    // The first tick sets the rate directly.
+    //
+    rate.add(100, t0 + milliseconds(500));
+    EXPECT_EQ(rate.rate(t0 + milliseconds(999)), 0);
+    EXPECT_DOUBLE_EQ(rate.rate(t0 + seconds(1)), 100);
+
+    // A steady rate stays put.
+    //
+    for (int i = 1; i < 20; ++i) {
+        rate.add(100, t0 + seconds(i) + milliseconds(500));
+    }
+    EXPECT_DOUBLE_EQ(rate.rate(t0 + seconds(20)), 100);
+
+    // When events stop, the rate decays by a factor of e every time constant; ticks with no calls count as
+    // ticks with no events.
+    //
+    EXPECT_NEAR(rate.rate(t0 + seconds(30)), 100 / std::exp(1.0), 1e-9);
+    EXPECT_NEAR(rate.rate(t0 + seconds(40)), 100 / std::exp(2.0), 1e-9);
+
+    // A new steady rate is approached gradually.
+    //
+    for (int i = 40; i < 80; ++i) {
+        rate.add(200, t0 + seconds(i) + milliseconds(500));
+    }
+    EXPECT_NEAR(rate.rate(t0 + seconds(80)), 200, 200 * std::exp(-3.0));
+}
+
+TEST(Metrics, RateMetricRegistryTest)
+{
+    batt::WindowedRateMetric<10> windowed;
+    batt::EwmaRateMetric ewma;
+
+    batt::MetricRegistry registry;
+    registry.add("requests", windowed).add("requests", ewma);
+
+    std::map<std::string, double> values;
+    registry.read_all([&](std::string_view name, double value, const batt::MetricLabelSet&) {
+        values[std::string(name)] = value;
+    });
+
+    EXPECT_THAT(values, ::testing::UnorderedElementsAre(::testing::Pair("requests_rate", 0.0),
+                                                         ::testing::Pair("requests_ewma_rate", 0.0)));
+
+    registry.remove(windowed);
+    registry.remove(ewma);
+}
+
 TEST(Metrics, GaugeMetricInt64Test)
 {
     const batt::int_types::i64 zero_value = 0;
@@ -442,4 +582,701 @@ TEST(Metrics, StatsRegistryTest)
     EXPECT_THAT(actual, testing::EndsWith(/* skip time_usec,date_time timestamps */ ",4,20,12,64\n"));
 }
 
+TEST(Metrics, SnapshotRegistryTest)
+{
+    const batt::MetricLabel label{batt::Token("Job"), batt::Token("batteries")};
+
+    batt::CountMetric<int> counter{7};
+    batt::GaugeMetric<double> gauge;
+    gauge.set(2.5);
+
+    batt::MetricRegistry registry;
+    registry.add("test_snapshot_counter", counter, batt::MetricLabelSet{label});
+    registry.add("test_snapshot", gauge);
+
+    // Names and labels are looked up by id, once.
+    //
+    std::map<batt::MetricId, std::string> name_of;
+    std::map<batt::MetricId, batt::int_types::usize> label_count_of;
+    const batt::int_types::u64 schema_version =
+        registry.for_each_descriptor([&](const batt::MetricDescriptor& metric) {
+            name_of[metric.id] = metric.name;
+            label_count_of[metric.id] = metric.labels.size();
+        });
+
+    ASSERT_EQ(name_of.size(), 2u);
+
+    batt::MetricSnapshot snapshot;
+    registry.read_snapshot(snapshot);
+
+    EXPECT_EQ(snapshot.schema_version(), schema_version);
+    ASSERT_EQ(snapshot.samples().size(), 2u);
+    EXPECT_LT(snapshot.samples()[0].id, snapshot.samples()[1].id);
+
+    std::map<std::string, double> values;
+    for (const batt::MetricSnapshot::Sample& sample : snapshot.samples()) {
+        values[name_of[sample.id]] = sample.value;
+    }
+    EXPECT_EQ(values["test_snapshot_counter"], 7);
+    EXPECT_EQ(values["test_snapshot_gauge"], 2.5);
+    EXPECT_EQ(label_count_of[snapshot.samples()[0].id], 1u);
+    EXPECT_EQ(label_count_of[snapshot.samples()[1].id], 0u);
+
+    // Reading again into the same snapshot reuses its storage.
+    //
+    const batt::MetricSnapshot::Sample* const samples_data = snapshot.samples().data();
+
+    counter.add(1);
+    registry.read_snapshot(snapshot);
+
+    EXPECT_EQ(snapshot.samples().data(), samples_data);
+    EXPECT_EQ(snapshot.samples()[0].value, 8);
+    EXPECT_EQ(snapshot.schema_version(), schema_version);
+
+    // Removing a metric changes the schema version; the remaining metric keeps its id.
+    //
+    const batt::MetricId gauge_id = snapshot.samples()[1].id;
+
+    registry.remove(counter);
+    registry.read_snapshot(snapshot);
+
+    EXPECT_NE(snapshot.schema_version(), schema_version);
+    ASSERT_EQ(snapshot.samples().size(), 1u);
+    EXPECT_EQ(snapshot.samples()[0].id, gauge_id);
+    EXPECT_EQ(snapshot.samples()[0].value, 2.5);
+}
+
+TEST(Metrics, HistogramMetricTest)
+{
+    batt::HistogramMetric histogram{std::make_shared<const std::vector<double>>(std::vector<double>{1, 10})};
+
+    ASSERT_EQ(histogram.bucket_count(), 3u);
+    EXPECT_EQ(histogram.upper_bound(0), 1);
+    EXPECT_EQ(histogram.upper_bound(1), 10);
+    EXPECT_EQ(histogram.upper_bound(2), std::numeric_limits<double>::infinity());
+
+    for (double sample : {0.5, 1.0, 2.0, 10.0, 11.0, 100.0}) {
+        histogram.update(sample);
+    }
+
+    EXPECT_EQ(histogram.bucket(0), 2u);
+    EXPECT_EQ(histogram.bucket(1), 2u);
+    EXPECT_EQ(histogram.bucket(2), 2u);
+    EXPECT_EQ(histogram.count(), 6u);
+    EXPECT_EQ(histogram.sum(), 124.5);
+
+    histogram.reset();
+
+    EXPECT_EQ(histogram.bucket(0), 0u);
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.sum(), 0);
+}
+
+TEST(Metrics, CounterFamilyTest)
+{
+    batt::CounterFamily<batt::int_types::u64> requests{{batt::Token{"host"}, batt::Token{"method"}}};
+
+    EXPECT_EQ(requests.series_count(), 0u);
+
+    // The same label values always give the same series.
+    //
+    batt::ShardedCountMetric<batt::int_types::u64>& get_a = requests.with_labels("a.com", "GET");
+    EXPECT_EQ(&requests.with_labels(std::string{"a.com"}, std::string_view{"GET"}), &get_a);
+    EXPECT_NE(&requests.with_labels("a.com", "PUT"), &get_a);
+    EXPECT_NE(&requests.with_labels("b.com", "GET"), &get_a);
+    EXPECT_EQ(requests.series_count(), 3u);
+
+    // Concurrent updates, some of which create new series.
+    //
+    constexpr int kNumThreads = 4;
+    constexpr int kNumUpdates = 10000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kNumThreads; ++t) {
+        threads.emplace_back([&requests, t] {
+            const std::string host = "host" + std::to_string(t % 2) + ".com";
+            for (int i = 0; i < kNumUpdates; ++i) {
+                requests.with_labels("a.com", "GET").add(1);
+                requests.with_labels(host, "GET").add(1);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(get_a.load(), static_cast<batt::int_types::u64>(kNumThreads * kNumUpdates));
+    EXPECT_EQ(requests.with_labels("host0.com", "GET").load(),
+              static_cast<batt::int_types::u64>(kNumThreads * kNumUpdates / 2));
+    EXPECT_EQ(requests.series_count(), 5u);
+    EXPECT_EQ(requests.overflow_count(), 0u);
+}
+
+TEST(Metrics, MetricFamilyCardinalityLimitTest)
+{
+    batt::GaugeFamily<double> gauges{{batt::Token{"path"}}, /*max_series=*/2};
+
+    gauges.with_labels("/a").set(1);
+    gauges.with_labels("/b").set(2);
+    gauges.with_labels("/c").set(3);
+    gauges.with_labels("/d").set(4);
+
+    EXPECT_EQ(gauges.series_count(), 2u);
+    EXPECT_EQ(gauges.overflow_count(), 2u);
+
+    // Existing series can still be found; new label values all map to the overflow series.
+    //
+    EXPECT_EQ(gauges.with_labels("/a").load(), 1);
+    EXPECT_EQ(gauges.with_labels("/b").load(), 2);
+    EXPECT_EQ(&gauges.with_labels("/c"), &gauges.with_labels("/e"));
+    EXPECT_EQ(gauges.with_labels("/c").load(), 4);
+
+    std::map<std::string, double> values;
+    gauges.for_each_series([&](const batt::MetricLabelSet& labels, const batt::GaugeMetric<double>& gauge) {
+        ASSERT_EQ(labels.size(), 1u);
+        EXPECT_EQ(labels[0].key, "path");
+        values[labels[0].value] = gauge.load();
+    });
+
+    EXPECT_THAT(values, ::testing::ElementsAre(::testing::Pair("/a", 1), ::testing::Pair("/b", 2),
+                                               ::testing::Pair("__overflow__", 4)));
+}
+
+TEST(Metrics, MetricFamilyRegistryTest)
+{
+    batt::MetricRegistry registry;
+
+    // Read all metrics as "name{key=value,...}" -> value.
+    //
+    const auto read_all = [&registry] {
+        std::map<std::string, double> values;
+        registry.read_all([&](std::string_view name, double value, const batt::MetricLabelSet& labels) {
+            std::string key{name};
+            key += "{";
+            for (const batt::MetricLabel& label : labels) {
+                key += batt::to_string(label.key, "=", label.value, ",");
+            }
+            key += "}";
+            values[key] = value;
+        });
+        return values;
+    };
+
+    {
+        batt::CounterFamily<int> counters{{batt::Token{"endpoint"}}};
+        counters.with_labels("/x").add(3);
+
+        registry.add("test_requests", counters);
+        counters.with_labels("/y").add(5);
+
+        batt::HistogramFamily latency{{batt::Token{"endpoint"}}, {1, 10}};
+        latency.with_labels("/x").update(0.5);
+        latency.with_labels("/x").update(5);
+        latency.with_labels("/x").update(50);
+
+        registry.add("test_latency", latency);
+
+        EXPECT_THAT(read_all(), ::testing::ElementsAre(  //
+                                    ::testing::Pair("test_latency_bucket{endpoint=/x,le=+Inf,}", 3),
+                                    ::testing::Pair("test_latency_bucket{endpoint=/x,le=1,}", 1),
+                                    ::testing::Pair("test_latency_bucket{endpoint=/x,le=10,}", 2),
+                                    ::testing::Pair("test_latency_count{endpoint=/x,}", 3),
+                                    ::testing::Pair("test_latency_sum{endpoint=/x,}", 55.5),
+                                    ::testing::Pair("test_requests{endpoint=/x,}", 3),
+                                    ::testing::Pair("test_requests{endpoint=/y,}", 5)));
+
+        // Removing a family removes all its series and stops new ones from being exported.
+        //
+        registry.remove(counters);
+        counters.with_labels("/z").add(1);
+
+        EXPECT_EQ(read_all().size(), 5u);
+    }
+
+    // Destroying a family removes it from the registry.
+    //
+    EXPECT_TRUE(read_all().empty());
+}
+
+TEST(Metrics, MetricTimeSeriesRoundTripTest)
+{
+    using batt::int_types::i64;
+    using batt::int_types::usize;
+
+    // Irregular timestamps and a mix of repeated, smoothly changing and random values.
+    //
+    std::default_random_engine rng{1};
+    std::uniform_int_distribution<i64> pick_delta{0, 5000};
+    std::uniform_real_distribution<double> pick_value{-1e9, 1e9};
+
+    std::vector<batt::MetricSample> expected;
+    i64 time_ms = -1000;
+    for (usize i = 0; i < 1000; ++i) {
+        switch (i % 4) {
+        case 0:
+            time_ms += 1000;
+            break;
+        case 1:
+            time_ms += pick_delta(rng);
+            break;
+        case 2:
+            time_ms += i64{1} << 40;
+            break;
+        default:
+            break;
+        }
+        const double value = (i % 3 == 0) ? pick_value(rng) : (i % 3 == 1) ? 1.5 : double(i) / 7;
+        expected.emplace_back(batt::MetricSample{time_ms, value});
+    }
+
+    batt::MetricTimeSeries series{expected.size()};
+    for (const batt::MetricSample& sample : expected) {
+        series.append(sample.time_ms, sample.value);
+    }
+    EXPECT_EQ(series.size(), expected.size());
+    EXPECT_EQ(series.oldest_time(), expected.front().time_ms);
+    EXPECT_EQ(series.newest_time(), expected.back().time_ms);
+
+    std::vector<batt::MetricSample> actual;
+    series.for_each_in_range(std::numeric_limits<i64>::min(), std::numeric_limits<i64>::max(),
+                             [&](const batt::MetricSample& sample) {
+                                 actual.emplace_back(sample);
+                             });
+
+    ASSERT_EQ(actual.size(), expected.size());
+    for (usize i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(actual[i].time_ms, expected[i].time_ms) << BATT_INSPECT(i);
+        EXPECT_EQ(actual[i].value, expected[i].value) << BATT_INSPECT(i);
+    }
+}
+
+TEST(Metrics, MetricTimeSeriesRetentionTest)
+{
+    using batt::int_types::i64;
+    using batt::int_types::usize;
+
+    const usize capacity = 300;
+    batt::MetricTimeSeries series{capacity};
+
+    // A regularly sampled, slowly changing counter.
+    //
+    for (i64 t = 0; t < 10000; ++t) {
+        series.append(t * 1000, double(t / 10));
+    }
+
+    EXPECT_GE(series.size(), capacity);
+    EXPECT_LE(series.size(), capacity + batt::MetricTimeSeries::kSamplesPerBlock);
+    EXPECT_EQ(series.newest_time(), 9999 * 1000);
+
+    // Well under a byte per sample.
+    //
+    EXPECT_LT(series.compressed_size(), series.size());
+
+    // Range queries are half-open.
+    //
+    std::vector<batt::MetricSample> samples;
+    series.for_each_in_range(9900 * 1000, 9910 * 1000, [&](const batt::MetricSample& sample) {
+        samples.emplace_back(sample);
+    });
+
+    ASSERT_EQ(samples.size(), 10u);
+    for (usize i = 0; i < samples.size(); ++i) {
+        EXPECT_EQ(samples[i].time_ms, i64(9900 + i) * 1000);
+        EXPECT_EQ(samples[i].value, 990);
+    }
+}
+
+TEST(Metrics, MetricHistoryTest)
+{
+    using batt::int_types::i64;
+
+    batt::CountMetric<int> counter{0};
+    batt::GaugeMetric<double> gauge;
+
+    batt::MetricRegistry registry;
+    registry.add("test_history_counter", counter);
+
+    batt::MetricHistory history{registry,
+                                {
+                                    batt::MetricHistory::Resolution{std::chrono::seconds{1}, 60},
+                                    batt::MetricHistory::Resolution{std::chrono::seconds{10}, 60},
+                                }};
+
+    EXPECT_EQ(history.find_metric("test_history_counter"), batt::None);
+
+    // Sample once per second for five minutes, plus some extra samples that fall in the same second.
+    //
+    const i64 start_ms = 1700000000000;
+    for (i64 t = 0; t < 300; ++t) {
+        counter.set(int(t));
+        history.sample(start_ms + t * 1000 + 250);
+        history.sample(start_ms + t * 1000 + 750);
+
+        if (t == 100) {
+            registry.add("test_history", gauge);
+        }
+        gauge.set(0.5);
+    }
+
+    const batt::Optional<batt::MetricId> counter_id = history.find_metric("test_history_counter");
+    ASSERT_TRUE(counter_id);
+
+    // The last minute is available at full resolution.
+    //
+    std::vector<batt::MetricSample> samples;
+    EXPECT_EQ(history.query(*counter_id, start_ms + 250 * 1000, start_ms + 260 * 1000, samples), 0u);
+
+    ASSERT_EQ(samples.size(), 10u);
+    for (i64 i = 0; i < 10; ++i) {
+        EXPECT_EQ(samples[i].time_ms, start_ms + (250 + i) * 1000);
+        EXPECT_EQ(samples[i].value, 250 + i);
+    }
+
+    // Older data comes from the coarser resolution, averaged over each ten-second period.
+    //
+    samples.clear();
+    EXPECT_EQ(history.query(*counter_id, start_ms, start_ms + 30 * 1000, samples), 1u);
+
+    ASSERT_EQ(samples.size(), 3u);
+    for (i64 i = 0; i < 3; ++i) {
+        EXPECT_EQ(samples[i].time_ms, start_ms + i * 10 * 1000);
+        EXPECT_EQ(samples[i].value, i * 10 + 4.5);
+    }
+
+    // Metrics added later are picked up at the next sample.
+    //
+    const batt::Optional<batt::MetricId> gauge_id = history.find_metric("test_history_gauge");
+    ASSERT_TRUE(gauge_id);
+
+    samples.clear();
+    EXPECT_EQ(history.query(*gauge_id, start_ms + 290 * 1000, start_ms + 300 * 1000, samples), 0u);
+    EXPECT_EQ(samples.size(), 10u);
+
+    // Removed metrics are forgotten.
+    //
+    registry.remove(counter);
+    history.sample(start_ms + 300 * 1000);
+
+    EXPECT_EQ(history.find_metric("test_history_counter"), batt::None);
+    EXPECT_EQ(history.query(*counter_id, start_ms, start_ms + 300 * 1000, samples), batt::None);
+}
+
+TEST(Metrics, MetricHistoryBackgroundTest)
+{
+    batt::CountMetric<int> counter{42};
+
+    batt::MetricRegistry registry;
+    registry.add("test_history_bg", counter);
+
+    batt::MetricHistory history{registry,
+                                {batt::MetricHistory::Resolution{std::chrono::milliseconds{5}, 100}}};
+    history.start();
+
+    while (!history.find_metric("test_history_bg")) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    history.stop();
+
+    std::vector<batt::MetricSample> samples;
+    history.query(*history.find_metric("test_history_bg"), 0, batt::MetricHistory::now_ms() + 1, samples);
+
+    ASSERT_FALSE(samples.empty());
+    EXPECT_EQ(samples.back().value, 42);
+}
+
+TEST(Metrics, BinaryFormatterTest)
+{
+    batt::CountMetric<int> counter{1};
+    batt::GaugeMetric<double> gauge;
+    gauge.set(0.25);
+
+    batt::MetricRegistry registry;
+    registry.add("test_bin_counter", counter, batt::MetricLabelSet{{batt::Token{"k"}, batt::Token{"v"}}});
+    registry.add("test_bin", gauge);
+
+    std::ostringstream oss;
+    batt::MetricBinaryFormatter formatter;
+    formatter.initialize(registry, oss);
+
+    const std::vector<std::pair<int, double>> rows = {{1, 0.25}, {2, 0.25}, {2, -7.5}, {1000000, 1e100}};
+    for (const auto& [counter_value, gauge_value] : rows) {
+        counter.set(counter_value);
+        gauge.set(gauge_value);
+        formatter.format_values(registry, oss);
+    }
+    formatter.finished(registry, oss);
+
+    // Rows are fixed-width: a timestamp plus one value per column.
+    //
+    const std::string data = oss.str();
+    const batt::int_types::usize header_size = data.size() - rows.size() * 3 * 8;
+
+    {
+        std::istringstream iss{data};
+        batt::MetricBinaryReader reader{iss};
+
+        ASSERT_TRUE(reader.read_header().ok());
+        ASSERT_EQ(reader.columns().size(), 2u);
+        EXPECT_EQ(reader.columns()[0].name, "test_bin_counter");
+        ASSERT_EQ(reader.columns()[0].labels.size(), 1u);
+        EXPECT_EQ(reader.columns()[0].labels[0].key, "k");
+        EXPECT_EQ(reader.columns()[0].labels[0].value, "v");
+        EXPECT_EQ(reader.columns()[1].name, "test_bin_gauge");
+        EXPECT_TRUE(reader.columns()[1].labels.empty());
+        EXPECT_EQ(static_cast<batt::int_types::usize>(iss.tellg()), header_size);
+
+        batt::int_types::i64 prev_time_usec = 0;
+        for (const auto& [counter_value, gauge_value] : rows) {
+            batt::StatusOr<bool> got_row = reader.read_row();
+            ASSERT_TRUE(got_row.ok());
+            ASSERT_TRUE(*got_row);
+
+            EXPECT_GE(reader.row_time_usec(), prev_time_usec);
+            prev_time_usec = reader.row_time_usec();
+
+            EXPECT_THAT(reader.row_values(), ::testing::ElementsAre(counter_value, gauge_value));
+        }
+
+        batt::StatusOr<bool> got_row = reader.read_row();
+        ASSERT_TRUE(got_row.ok());
+        EXPECT_FALSE(*got_row);
+    }
+
+    // Conversion to CSV.
+    {
+        std::istringstream iss{data};
+        std::ostringstream csv;
+
+        ASSERT_TRUE(batt::convert_metric_binary_to_csv(iss, csv).ok());
+
+        const std::string csv_text = csv.str();
+        EXPECT_THAT(csv_text, ::testing::StartsWith(
+                                  "id,time_usec,date_time,test_bin_counter[k=v],test_bin_gauge\n1,"));
+        EXPECT_THAT(csv_text, ::testing::EndsWith(",1000000,1e+100\n"));
+        EXPECT_EQ(std::count(csv_text.begin(), csv_text.end(), '\n'), 5);
+    }
+
+    // A truncated row is an error.
+    {
+        std::istringstream iss{data.substr(0, data.size() - 1)};
+        std::ostringstream csv;
+
+        EXPECT_EQ(batt::convert_metric_binary_to_csv(iss, csv), batt::StatusCode::kDataLoss);
+    }
+
+    // So is the wrong kind of file.
+    {
+        std::istringstream iss{"id,time_usec,date_time\n"};
+        batt::MetricBinaryReader reader{iss};
+
+        EXPECT_EQ(reader.read_header(), batt::StatusCode::kInvalidArgument);
+    }
+}
+
+TEST(Metrics, ContentionMetricsTest)
+{
+    batt::Mutex<int> m{0};
+    batt::MutexCallSite& site = BATT_MUTEX_CALL_SITE();
+    const int site_line = __LINE__ - 1;
+
+    {
+        auto lock = batt::lock_instrumented(m, site);
+        EXPECT_FALSE(lock.was_contended());
+        EXPECT_TRUE(m.is_locked());
+
+        std::atomic<bool> waiting{false};
+        std::thread other{[&] {
+            waiting = true;
+            auto other_lock = batt::lock_instrumented(m, site);
+            EXPECT_TRUE(other_lock.was_contended());
+            *other_lock += 1;
+        }};
+
+        while (!waiting) {
+            std::this_thread::yield();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        *lock += 1;
+        EXPECT_TRUE(lock.release());
+        EXPECT_FALSE(lock.release());
+
+        other.join();
+    }
+    EXPECT_FALSE(m.is_locked());
+
+    EXPECT_EQ(site.acquire_count.load(), 2u);
+    EXPECT_EQ(site.contended_count.load(), 1u);
+    EXPECT_EQ(site.wait_usec.count(), 2u);
+    EXPECT_EQ(site.hold_usec.count(), 2u);
+    EXPECT_GE(site.wait_usec.sum(), 10 * 1000);
+    EXPECT_GE(site.hold_usec.sum(), 10 * 1000);
+
+    // Evaluating the same call site again gives the same object.
+    //
+    const auto get_site = []() -> batt::MutexCallSite& {
+        return BATT_MUTEX_CALL_SITE();
+    };
+    EXPECT_EQ(&get_site(), &get_site());
+    EXPECT_NE(&get_site(), &site);
+
+    // Instrumentation is off by default.
+    //
+    {
+        auto lock = BATT_LOCK_MUTEX(m);
+        static_assert(std::is_same_v<decltype(lock), batt::Mutex<int>::Lock>);
+        EXPECT_EQ(*lock, 2);
+    }
+
+    // The metrics are exported by call site.
+    //
+    batt::add_contention_metrics(batt::global_metric_registry());
+
+    const std::string site_label = batt::to_string(__FILE__, ":", site_line);
+    std::map<std::string, double> values;
+    batt::global_metric_registry().read_all(
+        [&](std::string_view name, double value, const batt::MetricLabelSet& labels) {
+            if (name.substr(0, 11) == "batt_watch_") {
+                values[std::string{name}] = value;
+            }
+            for (const batt::MetricLabel& label : labels) {
+                if (label.key == "site" && label.value == site_label && labels.size() == 1) {
+                    values[std::string{name}] = value;
+                }
+            }
+        });
+
+    EXPECT_EQ(values["batt_mutex_acquires"], 2);
+    EXPECT_EQ(values["batt_mutex_contended_acquires"], 1);
+    EXPECT_EQ(values["batt_mutex_wait_usec_count"], 2);
+    EXPECT_EQ(values["batt_mutex_hold_usec_count"], 2);
+    EXPECT_EQ(values.count("batt_watch_lock_observers_contended"), 1u);
+    EXPECT_EQ(values.count("batt_watch_lock_observers_spins"), 1u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(Metrics, StatsdExporterTest)
+{
+    boost::asio::io_context io;
+    auto work_guard = boost::asio::make_work_guard(io);
+    std::thread io_thread{[&io] {
+        io.run();
+    }};
+    auto on_test_exit = batt::finally([&] {
+        work_guard.reset();
+        io_thread.join();
+    });
+
+    // The listener is only used synchronously from this thread.
+    //
+    boost::asio::ip::udp::socket listener{io};
+    listener.open(boost::asio::ip::udp::v4());
+    listener.bind(boost::asio::ip::udp::endpoint{boost::asio::ip::make_address_v4("127.0.0.1"), /*port=*/0});
+    listener.non_blocking(true);
+
+    std::vector<std::string> datagrams;
+    std::vector<std::string> lines;
+
+    const auto receive_until = [&](const std::string& expected_line) -> bool {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        char buffer[2048];
+        while (std::find(lines.begin(), lines.end(), expected_line) == lines.end()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            boost::system::error_code ec;
+            boost::asio::ip::udp::endpoint sender;
+            const std::size_t n = listener.receive_from(boost::asio::buffer(buffer), sender, 0, ec);
+            if (ec == boost::asio::error::would_block) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            if (ec) {
+                return false;
+            }
+            datagrams.emplace_back(buffer, n);
+
+            std::istringstream iss{datagrams.back()};
+            std::string line;
+            while (std::getline(iss, line)) {
+                lines.emplace_back(line);
+            }
+        }
+        return true;
+    };
+
+    batt::CountMetric<batt::u64> requests{0};
+    batt::GaugeMetric<batt::i64> depth;
+    batt::CountMetric<batt::u64> errors{0};
+
+    batt::MetricRegistry registry;
+    registry.add("requests", requests, batt::MetricLabelSet{{batt::Token{"shard"}, batt::Token{"1"}}});
+    registry.add("depth", depth);
+    registry.add("errors", errors);
+    auto on_remove = batt::finally([&] {
+        registry.remove(requests);
+        registry.remove(depth);
+        registry.remove(errors);
+    });
+
+    requests.add(3);
+    depth.set(7);
+    errors.add(1);
+
+    batt::MetricStatsdExporter::Options options;
+    options.interval = std::chrono::milliseconds(10);
+    options.max_datagram_size = 48;
+    options.prefix = "test.";
+
+    batt::MetricStatsdExporter exporter{registry, io.get_executor(), listener.local_endpoint(), options};
+
+    EXPECT_TRUE(receive_until("test.requests:3|c|#shard:1"));
+    EXPECT_TRUE(receive_until("test.depth_gauge:7|g"));
+    EXPECT_TRUE(receive_until("test.errors:1|c"));
+
+    // Counters are sent as deltas, and only when they change.
+    //
+    requests.add(5);
+    depth.set(-2);
+
+    EXPECT_TRUE(receive_until("test.requests:5|c|#shard:1"));
+    EXPECT_TRUE(receive_until("test.depth_gauge:-2|g"));
+
+    // A negative gauge is reset to zero first (a signed value alone would be read as a change).
+    //
+    EXPECT_THAT(datagrams,
+                ::testing::Contains(::testing::HasSubstr("test.depth_gauge:0|g\ntest.depth_gauge:-2|g")));
+
+    exporter.stop();
+
+    EXPECT_EQ(std::count(lines.begin(), lines.end(), "test.requests:3|c|#shard:1"), 1);
+    EXPECT_EQ(std::count(lines.begin(), lines.end(), "test.errors:1|c"), 1);
+    EXPECT_EQ(exporter.error_count(), 0u);
+    EXPECT_GE(exporter.datagram_count(), datagrams.size());
+
+    // Lines are packed into datagrams up to the size limit.
+    //
+    EXPECT_EQ(datagrams.front(), "test.requests:3|c|#shard:1\ntest.depth_gauge:7|g");
+    for (const std::string& datagram : datagrams) {
+        EXPECT_LE(datagram.size(), options.max_datagram_size);
+    }
+
+    // Stopping an exporter doesn't wait for the next round, even if it is stopped before the task first
+    // waits for one.
+    //
+    options.interval = std::chrono::hours(1);
+    for (int i = 0; i < 20; ++i) {
+        const auto start_time = std::chrono::steady_clock::now();
+        {
+            batt::MetricStatsdExporter quick_exporter{registry, io.get_executor(), listener.local_endpoint(),
+                                                      options};
+            if (i % 2 == 1) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        EXPECT_LT(std::chrono::steady_clock::now() - start_time, std::chrono::seconds(5)) << BATT_INSPECT(i);
+    }
+}
+
 }  // namespace
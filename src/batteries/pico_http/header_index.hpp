@@ -0,0 +1,223 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_PICO_HTTP_HEADER_INDEX_HPP
+#define BATTERIES_PICO_HTTP_HEADER_INDEX_HPP
+
+#include <batteries/config.hpp>
+//
+#include <batteries/int_types.hpp>
+#include <batteries/optional.hpp>
+
+#include <array>
+#include <string_view>
+
+namespace pico_http {
+
+using namespace batt::int_types;
+
+// Header names that are indexed by the parser, so that looking them up is O(1).
+//
+enum struct KnownHeader : u8 {
+    kAccept,
+    kAcceptEncoding,
+    kAuthorization,
+    kCacheControl,
+    kConnection,
+    kContentEncoding,
+    kContentLength,
+    kContentType,
+    kCookie,
+    kDate,
+    kExpect,
+    kHost,
+    kKeepAlive,
+    kLocation,
+    kServer,
+    kSetCookie,
+    kTrailer,
+    kTransferEncoding,
+    kUpgrade,
+    kUserAgent,
+
+    // Not a header; the number of known headers.
+    //
+    kCount,
+};
+
+constexpr usize kKnownHeaderCount = static_cast<usize>(KnownHeader::kCount);
+
+// Canonical spelling of each KnownHeader, in enum order.
+//
+constexpr std::array<std::string_view, kKnownHeaderCount> kKnownHeaderNames = {
+    "Accept",             //
+    "Accept-Encoding",    //
+    "Authorization",      //
+    "Cache-Control",      //
+    "Connection",         //
+    "Content-Encoding",   //
+    "Content-Length",     //
+    "Content-Type",       //
+    "Cookie",             //
+    "Date",               //
+    "Expect",             //
+    "Host",               //
+    "Keep-Alive",         //
+    "Location",           //
+    "Server",             //
+    "Set-Cookie",         //
+    "Trailer",            //
+    "Transfer-Encoding",  //
+    "Upgrade",            //
+    "User-Agent",         //
+};
+
+inline std::string_view known_header_name(KnownHeader h)
+{
+    return kKnownHeaderNames[static_cast<usize>(h)];
+}
+
+// Case-insensitive comparison of header names (which are ASCII tokens).
+//
+inline bool header_name_equals(const std::string_view& a, const std::string_view& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (usize i = 0; i < a.size(); ++i) {
+        if (((a[i] ^ b[i]) & ~0x20) != 0) {
+            return false;
+        }
+        // The case bit may only differ for letters.
+        //
+        if (a[i] != b[i] && !((a[i] | 0x20) >= 'a' && (a[i] | 0x20) <= 'z')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace detail {
+
+// Known header names are distinguished by (length, case-folded first letter), which gives a perfect hash
+// into a small table.
+//
+constexpr usize kMaxKnownHeaderNameSize = 17;
+
+constexpr usize known_header_slot(usize name_size, char first_char)
+{
+    return name_size * 32 + (static_cast<u8>(first_char) & 0x1f);
+}
+
+constexpr usize kKnownHeaderSlotCount = known_header_slot(kMaxKnownHeaderNameSize, '\x1f') + 1;
+
+// Maps each slot to 1 + the KnownHeader that hashes there, or 0 for none.
+//
+constexpr std::array<u8, kKnownHeaderSlotCount> make_known_header_slots()
+{
+    std::array<u8, kKnownHeaderSlotCount> slots{};
+    for (usize i = 0; i < kKnownHeaderCount; ++i) {
+        slots[known_header_slot(kKnownHeaderNames[i].size(), kKnownHeaderNames[i][0])] = u8(i + 1);
+    }
+    return slots;
+}
+
+constexpr std::array<u8, kKnownHeaderSlotCount> kKnownHeaderSlots = make_known_header_slots();
+
+// Verifies that no two known header names hash to the same slot.
+//
+constexpr bool known_header_slots_are_unique()
+{
+    usize n_used = 0;
+    for (u8 slot : kKnownHeaderSlots) {
+        n_used += (slot != 0);
+    }
+    return n_used == kKnownHeaderCount;
+}
+
+static_assert(known_header_slots_are_unique(), "Two KnownHeader names collide; change known_header_slot");
+
+}  // namespace detail
+
+// Returns the KnownHeader for `name` (compared case-insensitively), or None if it is not a known header.
+//
+inline batt::Optional<KnownHeader> classify_header_name(const std::string_view& name)
+{
+    if (name.empty() || name.size() > detail::kMaxKnownHeaderNameSize) {
+        return batt::None;
+    }
+    const u8 slot = detail::kKnownHeaderSlots[detail::known_header_slot(name.size(), name[0])];
+    if (slot == 0) {
+        return batt::None;
+    }
+    const auto candidate = static_cast<KnownHeader>(slot - 1);
+    if (!header_name_equals(name, known_header_name(candidate))) {
+        return batt::None;
+    }
+    return candidate;
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// The position of the first occurrence of each KnownHeader in a header list, filled in by the parser.
+//
+// The index covers the first `indexed_count()` headers of the list it was built from; if headers are added
+// to the list some other way, lookups must fall back to scanning (see batt::find_header).
+//
+class HeaderIndex
+{
+   public:
+    // Positions are stored as u16; headers past this point are not indexed.
+    //
+    static constexpr usize kMaxIndexedHeaders = 0xfffe;
+
+    void clear()
+    {
+        this->first_.fill(0);
+        this->indexed_count_ = 0;
+    }
+
+    // Records that the header at position `this->indexed_count()` has the given name.
+    //
+    void add(const std::string_view& name)
+    {
+        if (this->indexed_count_ >= kMaxIndexedHeaders) {
+            return;
+        }
+        this->indexed_count_ += 1;
+        if (batt::Optional<KnownHeader> h = classify_header_name(name)) {
+            u16& first = this->first_[static_cast<usize>(*h)];
+            if (first == 0) {
+                first = static_cast<u16>(this->indexed_count_);
+            }
+        }
+    }
+
+    usize indexed_count() const
+    {
+        return this->indexed_count_;
+    }
+
+    // Returns the position of the first header named `h`, or None if there is none among the indexed
+    // headers.
+    //
+    batt::Optional<usize> find(KnownHeader h) const
+    {
+        const u16 first = this->first_[static_cast<usize>(h)];
+        if (first == 0) {
+            return batt::None;
+        }
+        return first - 1;
+    }
+
+   private:
+    // 1 + the position of the first occurrence of each header, or 0 if it has not been seen.
+    //
+    std::array<u16, kKnownHeaderCount> first_{};
+
+    usize indexed_count_ = 0;
+};
+
+}  // namespace pico_http
+
+#endif  // BATTERIES_PICO_HTTP_HEADER_INDEX_HPP
@@ -0,0 +1,85 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/pico_http/header_index.hpp>
+//
+#include <batteries/pico_http/header_index.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <batteries/pico_http/parser.hpp>
+
+#include <cctype>
+#include <string>
+
+namespace {
+
+using namespace batt::int_types;
+
+using pico_http::KnownHeader;
+
+TEST(PicoHttpHeaderIndexTest, ClassifyKnownNames)
+{
+    for (usize i = 0; i < pico_http::kKnownHeaderCount; ++i) {
+        const auto h = static_cast<KnownHeader>(i);
+        const std::string_view name = pico_http::known_header_name(h);
+
+        std::string lower{name}, upper{name};
+        for (char& ch : lower) {
+            ch = std::tolower(ch);
+        }
+        for (char& ch : upper) {
+            ch = std::toupper(ch);
+        }
+
+        EXPECT_EQ(pico_http::classify_header_name(name), h) << name;
+        EXPECT_EQ(pico_http::classify_header_name(lower), h) << lower;
+        EXPECT_EQ(pico_http::classify_header_name(upper), h) << upper;
+    }
+}
+
+TEST(PicoHttpHeaderIndexTest, ClassifyUnknownNames)
+{
+    for (const char* name : {"", "X", "Hosts", "Hast", "Content-Lengthy", "Content_Length", "Accept-Language",
+                             "Upgrade-Insecure-Requests", "X-Forwarded-For", "Transfer-Encodinh"}) {
+        EXPECT_EQ(pico_http::classify_header_name(name), batt::None) << name;
+    }
+
+    // Only letters may differ in case: '-' (0x2d) and '\r' (0x0d) differ only in the case bit.
+    //
+    EXPECT_EQ(pico_http::classify_header_name("Content\rLength"), batt::None);
+}
+
+TEST(PicoHttpHeaderIndexTest, ParsedMessageIndex)
+{
+    const std::string_view text =
+        "HTTP/1.1 200 OK\r\n"
+        "X-Custom: a\r\n"
+        "set-cookie: first\r\n"
+        "Content-Length: 10\r\n"
+        "Set-Cookie: second\r\n"
+        "CONNECTION: keep-alive\r\n"
+        "\r\n";
+
+    pico_http::Response response;
+    ASSERT_EQ(response.parse(text.data(), text.size()), (int)text.size());
+
+    EXPECT_EQ(response.header_index.indexed_count(), response.headers.size());
+    EXPECT_EQ(response.header_index.find(KnownHeader::kSetCookie), 1u);
+    EXPECT_EQ(response.header_index.find(KnownHeader::kContentLength), 2u);
+    EXPECT_EQ(response.header_index.find(KnownHeader::kConnection), 4u);
+    EXPECT_EQ(response.header_index.find(KnownHeader::kTransferEncoding), batt::None);
+
+    // Re-parsing resets the index.
+    //
+    const std::string_view text2 = "HTTP/1.1 204 No Content\r\nDate: today\r\n\r\n";
+
+    ASSERT_EQ(response.parse(text2.data(), text2.size()), (int)text2.size());
+
+    EXPECT_EQ(response.header_index.indexed_count(), 1u);
+    EXPECT_EQ(response.header_index.find(KnownHeader::kDate), 0u);
+    EXPECT_EQ(response.header_index.find(KnownHeader::kContentLength), batt::None);
+}
+
+}  // namespace
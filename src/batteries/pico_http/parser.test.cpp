@@ -8,7 +8,12 @@
 #include <batteries/assert.hpp>
 #include <batteries/stream_util.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
 #include <string>
+#include <vector>
 
 namespace {
 
@@ -166,6 +171,53 @@ TEST(PicoHttpParserTest, ChromeRequestOk)
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 
+TEST(PicoHttpParserTest, RequestAppendToMatchesPrint)
+{
+    pico_http::Request request;
+    ASSERT_EQ(request.parse(kChromeRequest.data(), kChromeRequest.size()), (int)kChromeRequest.size());
+
+    std::string out = "prefix";
+    pico_http::append_to(out, request);
+
+    EXPECT_EQ(out, "prefix" + batt::to_string(request));
+
+    // Serializing a cleared request doesn't see any of the old headers, but the header storage is kept.
+    //
+    const usize capacity = request.headers.capacity();
+
+    request.clear();
+    request.method = "POST";
+    request.path = "/x";
+    request.headers.push_back(pico_http::MessageHeader{"Host", "localhost"});
+
+    EXPECT_EQ(request.headers.capacity(), capacity);
+    EXPECT_FALSE(request.header_index.find(pico_http::KnownHeader::kConnection));
+
+    out.clear();
+    pico_http::append_to(out, request);
+
+    EXPECT_EQ(out, "POST /x HTTP/1.1\r\nHost: localhost\r\n\r\n");
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+TEST(PicoHttpParserTest, ResponseAppendToMatchesPrint)
+{
+    const std::string_view kResponse =
+        "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+
+    pico_http::Response response;
+    ASSERT_EQ(response.parse(kResponse.data(), kResponse.size()), (int)kResponse.size());
+
+    std::string out;
+    pico_http::append_to(out, response);
+
+    EXPECT_EQ(out, kResponse);
+    EXPECT_EQ(out, batt::to_string(response));
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
 TEST(PicoHttpParserTest, RequestIncomplete)
 {
     for (const std::string& request_data : {kFirefoxRequest, kChromeRequest}) {
@@ -281,4 +333,190 @@ TEST(PicoHttpParserTest, ResponseError)
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+using pico_http::detail::FindCharKernel;
+
+std::vector<FindCharKernel> supported_findchar_kernels()
+{
+    std::vector<FindCharKernel> kernels;
+    for (int k = 0; k <= (int)pico_http::detail::best_findchar_kernel(); ++k) {
+        kernels.emplace_back((FindCharKernel)k);
+    }
+    return kernels;
+}
+
+// Sets the active findchar kernel for the lifetime of the guard.
+//
+class ScopedFindCharKernel
+{
+   public:
+    explicit ScopedFindCharKernel(FindCharKernel kernel) noexcept
+        : saved_{pico_http::detail::active_findchar_kernel()}
+    {
+        pico_http::detail::active_findchar_kernel() = kernel;
+    }
+
+    ~ScopedFindCharKernel() noexcept
+    {
+        pico_http::detail::active_findchar_kernel() = this->saved_;
+    }
+
+   private:
+    FindCharKernel saved_;
+};
+
+template <typename Ranges>
+void verify_findchar_kernels(const std::string& data)
+{
+    const char* const buf_end = data.data() + data.size();
+
+    // Reference: the first byte in any range.
+    //
+    const char* expected = buf_end;
+    for (const char* p = data.data(); p != buf_end && expected == buf_end; ++p) {
+        for (usize i = 0; i < Ranges::kSize; i += 2) {
+            if ((u8)*p >= (u8)Ranges::kRanges[i] && (u8)*p <= (u8)Ranges::kRanges[i + 1]) {
+                expected = p;
+                break;
+            }
+        }
+    }
+
+    for (FindCharKernel kernel : supported_findchar_kernels()) {
+        int found = -1;
+        const char* actual =
+            pico_http::detail::findchar_fast_with<Ranges>(kernel, data.data(), buf_end, &found);
+
+        if (found) {
+            EXPECT_EQ(actual, expected) << BATT_INSPECT((int)kernel) << BATT_INSPECT(data.size());
+        } else {
+            // No match in the whole blocks scanned: there must be none before `actual`, and fewer than 16
+            // bytes may be left for the caller's scalar loop.
+            //
+            EXPECT_GE(expected, actual) << BATT_INSPECT((int)kernel) << BATT_INSPECT(data.size());
+            EXPECT_LE(actual, buf_end);
+            if (kernel != FindCharKernel::kNone) {
+                EXPECT_LT(buf_end - actual, 16);
+            }
+        }
+    }
+}
+
+TEST(PicoHttpParserTest, FindCharKernelsAgree)
+{
+    std::default_random_engine rng{1};
+    std::uniform_int_distribution<int> pick_byte{0, 255};
+    std::uniform_int_distribution<int> pick_letter{'a', 'z'};
+
+    for (usize len = 0; len < 300; ++len) {
+        for (usize trial = 0; trial < 10; ++trial) {
+            // Mostly "boring" bytes, with a few arbitrary ones sprinkled in.
+            //
+            std::string data(len, 'x');
+            for (char& ch : data) {
+                ch = (pick_byte(rng) % 64 == 0) ? char(pick_byte(rng)) : char(pick_letter(rng));
+            }
+
+            verify_findchar_kernels<pico_http::detail::PathEndRanges>(data);
+            verify_findchar_kernels<pico_http::detail::EolRanges>(data);
+            verify_findchar_kernels<pico_http::detail::NonTokenRanges>(data);
+        }
+    }
+}
+
+TEST(PicoHttpParserTest, AllFindCharKernelsParse)
+{
+    for (FindCharKernel kernel : supported_findchar_kernels()) {
+        ScopedFindCharKernel scoped{kernel};
+
+        for (const std::string* request_data : {&kFirefoxRequest, &kChromeRequest}) {
+            pico_http::Request request;
+            EXPECT_EQ(request.parse(request_data->data(), request_data->size()), (int)request_data->size())
+                << BATT_INSPECT((int)kernel);
+        }
+        {
+            pico_http::Request request;
+            request.parse(kChromeRequest.data(), kChromeRequest.size());
+
+            ASSERT_EQ(request.headers.size(), 14u);
+            EXPECT_THAT(request.headers[6].value,
+                        ::testing::StrEq("Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/537.36 "
+                                         "(KHTML, like Gecko) Chrome/99.0.4844.51 Safari/537.36"));
+        }
+        {
+            pico_http::Response response;
+            const usize content_length = get_response_content_length(kGoogleResponse);
+            EXPECT_EQ(response.parse(kGoogleResponse.data(), kGoogleResponse.size()),
+                      (int)(kGoogleResponse.size() - content_length));
+        }
+        {
+            std::string copy = kChromeRequest;
+            copy[copy.find("Chrome/99")] = '\x01';
+
+            pico_http::Request request;
+            EXPECT_EQ(request.parse(copy.data(), copy.size()), pico_http::kParseFailed);
+        }
+    }
+}
+
+// Parse throughput for each findchar kernel.  Run with `--gtest_also_run_disabled_tests`.
+//
+TEST(PicoHttpParserTest, DISABLED_ParseThroughputBenchmark)
+{
+    // A response with the kind of long header values (cookies, CSP, etc.) that dominate real traffic.
+    //
+    std::string big_response = "HTTP/1.1 200 OK\r\n";
+    big_response += "Content-Type: text/html; charset=UTF-8\r\n";
+    big_response += "Content-Security-Policy: default-src 'self'; script-src 'self' https://cdn.example.com "
+                    "'nonce-2726c7f26c'; style-src 'self' 'unsafe-inline'; img-src * data:\r\n";
+    for (int i = 0; i < 8; ++i) {
+        big_response += "Set-Cookie: session_token_" + std::to_string(i) +
+                        "=eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9."
+                        "eyJzdWIiOiIxMjM0NTY3ODkwIiwibmFtZSI6IkpvaG4gRG9lIiwi"
+                        "aWF0IjoxNTE2MjM5MDIyfQ; Path=/; Secure; HttpOnly; SameSite=Lax\r\n";
+    }
+    big_response += "Cache-Control: private, max-age=0, no-cache\r\n\r\n";
+
+    const std::vector<std::pair<const char*, const std::string*>> corpus = {
+        {"firefox_request", &kFirefoxRequest},
+        {"chrome_request", &kChromeRequest},
+        {"cookie_heavy_response", &big_response},
+    };
+
+    constexpr usize kIterations = 100 * 1000;
+    constexpr usize kRounds = 5;
+
+    for (const auto& [name, data] : corpus) {
+        const bool is_request = (std::string_view{name}.find("request") != std::string_view::npos);
+
+        for (FindCharKernel kernel : supported_findchar_kernels()) {
+            ScopedFindCharKernel scoped{kernel};
+
+            pico_http::Request request;
+            pico_http::Response response;
+            i64 checksum = 0;
+
+            // Report the fastest round, to filter out noise from other processes.
+            //
+            double elapsed_sec = 1e9;
+            for (usize round = 0; round < kRounds; ++round) {
+                const auto start = std::chrono::steady_clock::now();
+                for (usize i = 0; i < kIterations; ++i) {
+                    checksum += is_request ? request.parse(data->data(), data->size())
+                                           : response.parse(data->data(), data->size());
+                }
+                const auto round_duration = std::chrono::steady_clock::now() - start;
+                elapsed_sec = std::min(elapsed_sec, std::chrono::duration<double>(round_duration).count());
+            }
+
+            EXPECT_GT(checksum, 0);
+
+            std::cout << name << " kernel=" << (int)kernel << ": "
+                      << (double(data->size()) * kIterations / elapsed_sec / (1024.0 * 1024.0)) << " MiB/s, "
+                      << (elapsed_sec * 1e9 / kIterations) << " ns/parse" << std::endl;
+        }
+    }
+}
+
 }  // namespace
@@ -29,11 +29,14 @@
 
 #include <batteries/config.hpp>
 //
+#include <batteries/pico_http/header_index.hpp>
+
 #include <batteries/buffer.hpp>
 #include <batteries/int_types.hpp>
 #include <batteries/small_vec.hpp>
 #include <batteries/status.hpp>
 
+#include <string>
 #include <string_view>
 
 #include <sys/types.h>
@@ -69,6 +72,10 @@ struct Request {
     int minor_version;
     batt::SmallVec<MessageHeader, kDefaultNumHeaders> headers;
 
+    // The positions of well-known headers in `headers`, filled in by `parse`.
+    //
+    HeaderIndex header_index;
+
     /* returns number of bytes consumed if successful, kParseIncomplete if request is partial,
      * kParseFailed if failed
      */
@@ -80,10 +87,25 @@ struct Request {
     {
         return this->parse(static_cast<const char*>(buf.data()), buf.size());
     }
+
+    // Empties the request so it can be filled in again, keeping the storage allocated for headers.
+    //
+    void clear()
+    {
+        this->method = {};
+        this->path = {};
+        this->headers.clear();
+        this->header_index.clear();
+    }
 };
 
 std::ostream& operator<<(std::ostream& out, const Request& t);
 
+// Appends the serialized form of `t` (the same text as operator<<) to `out`.  Unlike operator<<, this does
+// not allocate unless `out` needs to grow.
+//
+void append_to(std::string& out, const Request& t);
+
 struct Response {
     int major_version;
     int minor_version;
@@ -91,6 +113,10 @@ struct Response {
     std::string_view message;
     batt::SmallVec<MessageHeader, kDefaultNumHeaders> headers;
 
+    // The positions of well-known headers in `headers`, filled in by `parse`.
+    //
+    HeaderIndex header_index;
+
     /* returns number of bytes consumed if successful, kParseIncomplete if request is partial,
      * kParseFailed if failed
      */
@@ -106,6 +132,11 @@ struct Response {
 
 std::ostream& operator<<(std::ostream& out, const Response& t);
 
+// Appends the serialized form of `t` (the same text as operator<<) to `out`.  Unlike operator<<, this does
+// not allocate unless `out` needs to grow.
+//
+void append_to(std::string& out, const Response& t);
+
 /* returns number of bytes consumed if successful, kParseIncomplete if request is partial,
  * kParseFailed if failed
  */
@@ -35,6 +35,10 @@
 #include <assert.h>
 #include <stddef.h>
 #include <string.h>
+#include <array>
+#include <charconv>
+#include <utility>
+
 #ifdef __SSE4_2__
 #ifdef _MSC_VER
 #include <nmmintrin.h>
@@ -43,18 +47,28 @@
 #endif
 #endif
 
+// On x86-64 with GCC/Clang, the widest SIMD kernel for findchar_fast is chosen at runtime (see
+// `active_findchar_kernel()` below), so the same binary can use AVX-512/AVX2 where available.
+//
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BATT_PICO_HTTP_X86_DISPATCH 1
+#include <immintrin.h>
+#else
+#define BATT_PICO_HTTP_X86_DISPATCH 0
+#endif
+
+#if BATT_PICO_HTTP_X86_DISPATCH || defined(__SSE4_2__)
+#define BATT_PICO_HTTP_FINDCHAR_SIMD 1
+#else
+#define BATT_PICO_HTTP_FINDCHAR_SIMD 0
+#endif
+
 #include <batteries/pico_http/parser_decl.hpp>
 
 namespace pico_http {
 using namespace batt::int_types;
 }
 
-#ifdef _MSC_VER
-#define BATT_PICO_HTTP_ALIGNED(n) _declspec(align(n))
-#else
-#define BATT_PICO_HTTP_ALIGNED(n) __attribute__((aligned(n)))
-#endif
-
 #define BATT_PICO_HTTP_IS_PRINTABLE_ASCII(c) ((unsigned char)(c)-040u < 0137u)
 
 #define BATT_PICO_HTTP_CHECK_EOF()                                                                           \
@@ -76,9 +90,8 @@ using namespace batt::int_types;
 #define BATT_PICO_HTTP_ADVANCE_TOKEN(tok, toklen)                                                            \
     do {                                                                                                     \
         const char* tok_start = buf;                                                                         \
-        static const char BATT_PICO_HTTP_ALIGNED(16) ranges2[16] = "\000\040\177\177";                       \
         int found2;                                                                                          \
-        buf = findchar_fast(buf, buf_end, ranges2, 4, &found2);                                              \
+        buf = findchar_fast<PathEndRanges>(buf, buf_end, &found2);                                           \
         if (!found2) {                                                                                       \
             BATT_PICO_HTTP_CHECK_EOF();                                                                      \
         }                                                                                                    \
@@ -113,37 +126,290 @@ const char* token_char_map =
     "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0"
     "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0";
 
-BATT_INLINE_IMPL const char* findchar_fast(const char* buf, const char* buf_end, const char* ranges,
-                                           usize ranges_size, int* found)
+// The byte ranges searched for by findchar_fast.  Each range set is a type, so that the kernels below can be
+// specialized on it and keep the per-range constants in registers (or fold them into the instructions).
+//
+// `kRanges` holds `kSize` bytes (an even number, at most 16), which are pairs of inclusive bounds `[lo, hi]`;
+// it is padded to 16 bytes because pcmpestri always loads 16.
+
+/* end of the request path: control chars and SP, or DEL */
+struct PathEndRanges {
+    alignas(16) static constexpr char kRanges[16] = "\000\040\177\177";
+    static constexpr usize kSize = 4;
+};
+
+/* end of a header value or status message: control chars (except HT), or DEL */
+struct EolRanges {
+    alignas(16) static constexpr char kRanges[16] =
+        "\0\010"    /* allow HT */
+        "\012\037"  /* allow SP and up to but not including DEL */
+        "\177\177"; /* allow chars w. MSB set */
+    static constexpr usize kSize = 6;
+};
+
+/* end of a method or header name: any non-token char (see parse_token) */
+struct NonTokenRanges {
+    /* pcmpestri can take no more than eight character ranges (8*2*8=128 bits that is the size of a SSE
+     * register). Due to this restriction, characters `|` and `~` are handled in the slow loop. */
+    alignas(16) static constexpr char kRanges[16] = {
+        '\x00', ' ',     /* control chars and up to SP */
+        '"',    '"',     /* 0x22 */
+        '(',    ')',     /* 0x28,0x29 */
+        ',',    ',',     /* 0x2c */
+        '/',    '/',     /* 0x2f */
+        ':',    '@',     /* 0x3a-0x40 */
+        '[',    ']',     /* 0x5b-0x5d */
+        '{',    '\xff',  /* 0x7b-0xff */
+    };
+    static constexpr usize kSize = 16;
+};
+
+// The SIMD kernels available to findchar_fast.  Each kernel scans whole blocks of 16 or more bytes for the
+// first byte that falls within any of the ranges, leaving any partial block at the end of the input to the
+// caller's scalar loop.
+//
+enum struct FindCharKernel : int {
+    // No SIMD; findchar_fast returns `buf` unchanged.
+    //
+    kNone = 0,
+
+    // 16 bytes per step, using SSE2 range compares.
+    //
+    kSse2 = 1,
+
+    // 16 bytes per step, using pcmpestri.
+    //
+    kSse42 = 2,
+
+    // 32 bytes per step, using AVX2 range compares.
+    //
+    kAvx2 = 3,
+
+    // 64 bytes per step, using AVX-512BW range compares.
+    //
+    kAvx512 = 4,
+};
+
+#if BATT_PICO_HTTP_X86_DISPATCH
+#define BATT_PICO_HTTP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BATT_PICO_HTTP_TARGET(isa)
+#endif
+
+#if BATT_PICO_HTTP_FINDCHAR_SIMD
+
+template <typename Ranges>
+BATT_PICO_HTTP_TARGET("sse4.2")
+inline const char* findchar_sse42(const char* buf, const char* buf_end, int* found)
 {
-    *found = 0;
-#if __SSE4_2__
-    if (BATT_HINT_TRUE(buf_end - buf >= 16)) {
-        __m128i ranges16 = _mm_loadu_si128((const __m128i*)ranges);
+    const __m128i ranges16 = _mm_load_si128(reinterpret_cast<const __m128i*>(Ranges::kRanges));
+
+    while (BATT_HINT_TRUE(buf_end - buf >= 16)) {
+        const __m128i b16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+        const int r = _mm_cmpestri(ranges16, Ranges::kSize, b16, 16,
+                                   _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
+        if (BATT_HINT_FALSE(r != 16)) {
+            *found = 1;
+            return buf + r;
+        }
+        buf += 16;
+    }
+    return buf;
+}
 
-        usize left = (buf_end - buf) & ~15;
-        do {
-            __m128i b16 = _mm_loadu_si128((const __m128i*)buf);
-            int r = _mm_cmpestri(ranges16, ranges_size, b16, 16,
-                                 _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
-            if (BATT_HINT_FALSE(r != 16)) {
-                buf += r;
+#endif  // BATT_PICO_HTTP_FINDCHAR_SIMD
+
+#if BATT_PICO_HTTP_X86_DISPATCH
+
+// Byte `x` is in `[lo, hi]` iff `u8(x - lo) <= u8(hi - lo)`; the SSE2/AVX2 kernels test this as `min(d, span)
+// == d`, and the AVX-512 kernel with an unsigned compare, which costs 2-3 instructions per range per block.
+// pcmpestri checks all ranges at once but only 16 bytes at a time, so the wide kernels use it for the first
+// block (most tokens are short) and the last.
+
+// SSE2 is part of the x86-64 baseline, so these need no target attribute.
+//
+inline __m128i findchar_in_range_sse2(__m128i b16, char lo, char hi)
+{
+    const __m128i d = _mm_sub_epi8(b16, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(static_cast<char>(hi - lo))), d);
+}
+
+template <typename Ranges, usize... kI>
+inline u32 findchar_mask_sse2(__m128i b16, std::index_sequence<kI...>)
+{
+    __m128i match = _mm_setzero_si128();
+    ((match = _mm_or_si128(
+          match, findchar_in_range_sse2(b16, Ranges::kRanges[kI * 2], Ranges::kRanges[kI * 2 + 1]))),
+     ...);
+
+    return static_cast<u32>(_mm_movemask_epi8(match));
+}
+
+template <typename Ranges>
+inline const char* findchar_sse2(const char* buf, const char* buf_end, int* found)
+{
+    while (buf_end - buf >= 16) {
+        const u32 mask = findchar_mask_sse2<Ranges>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf)),
+                                                    std::make_index_sequence<Ranges::kSize / 2>{});
+        if (BATT_HINT_FALSE(mask != 0)) {
+            *found = 1;
+            return buf + __builtin_ctz(mask);
+        }
+        buf += 16;
+    }
+    return buf;
+}
+
+__attribute__((target("avx2"))) inline __m256i findchar_in_range_avx2(__m256i b32, char lo, char hi)
+{
+    const __m256i d = _mm256_sub_epi8(b32, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(static_cast<char>(hi - lo))), d);
+}
+
+template <typename Ranges, usize... kI>
+__attribute__((target("avx2"))) inline u32 findchar_mask_avx2(__m256i b32, std::index_sequence<kI...>)
+{
+    __m256i match = _mm256_setzero_si256();
+    ((match = _mm256_or_si256(
+          match, findchar_in_range_avx2(b32, Ranges::kRanges[kI * 2], Ranges::kRanges[kI * 2 + 1]))),
+     ...);
+
+    return static_cast<u32>(_mm256_movemask_epi8(match));
+}
+
+template <typename Ranges>
+__attribute__((target("avx2"))) inline const char* findchar_avx2(const char* buf, const char* buf_end,
+                                                                 int* found)
+{
+    if (buf_end - buf >= 32) {
+        while (buf_end - buf >= 32) {
+            const u32 mask = findchar_mask_avx2<Ranges>(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf)),
+                std::make_index_sequence<Ranges::kSize / 2>{});
+            if (BATT_HINT_FALSE(mask != 0)) {
                 *found = 1;
-                break;
+                return buf + __builtin_ctz(mask);
+            }
+            buf += 32;
+        }
+    }
+    return findchar_sse42<Ranges>(buf, buf_end, found);
+}
+
+template <typename Ranges, usize... kI>
+__attribute__((target("avx512bw"))) inline u64 findchar_mask_avx512(__m512i b64, std::index_sequence<kI...>)
+{
+    return (_mm512_cmple_epu8_mask(
+                _mm512_sub_epi8(b64, _mm512_set1_epi8(Ranges::kRanges[kI * 2])),
+                _mm512_set1_epi8(static_cast<char>(Ranges::kRanges[kI * 2 + 1] - Ranges::kRanges[kI * 2]))) |
+            ...);
+}
+
+template <typename Ranges>
+__attribute__((target("avx512bw"))) inline const char* findchar_avx512(const char* buf, const char* buf_end,
+                                                                       int* found)
+{
+    if (buf_end - buf >= 64) {
+        while (buf_end - buf >= 64) {
+            const u64 mask = findchar_mask_avx512<Ranges>(_mm512_loadu_si512(buf),
+                                                          std::make_index_sequence<Ranges::kSize / 2>{});
+            if (BATT_HINT_FALSE(mask != 0)) {
+                *found = 1;
+                return buf + __builtin_ctzll(mask);
             }
-            buf += 16;
-            left -= 16;
-        } while (BATT_HINT_TRUE(left != 0));
+            buf += 64;
+        }
+    }
+    return findchar_avx2<Ranges>(buf, buf_end, found);
+}
+
+#endif  // BATT_PICO_HTTP_X86_DISPATCH
+
+#undef BATT_PICO_HTTP_TARGET
+
+// Returns the widest kernel supported by both the compiler and the host CPU.
+//
+BATT_INLINE_IMPL FindCharKernel best_findchar_kernel()
+{
+#if BATT_PICO_HTTP_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) {
+        return FindCharKernel::kAvx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return FindCharKernel::kAvx2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return FindCharKernel::kSse42;
     }
+    return FindCharKernel::kSse2;
+#elif BATT_PICO_HTTP_FINDCHAR_SIMD
+    return FindCharKernel::kSse42;
 #else
+    return FindCharKernel::kNone;
+#endif
+}
+
+// The kernel used by findchar_fast.  This is a namespace-scope variable rather than a function-local static
+// so that reading it (on every findchar_fast call) is a plain load; if it is read during static
+// initialization before being set, it is zero (kNone), which is still correct.
+//
+FindCharKernel active_findchar_kernel_ = best_findchar_kernel();
+
+// Tests and benchmarks may set the active kernel to any narrower kernel to compare them.
+//
+inline FindCharKernel& active_findchar_kernel()
+{
+    return active_findchar_kernel_;
+}
+
+template <typename Ranges>
+inline const char* findchar_fast_with(FindCharKernel kernel, const char* buf, const char* buf_end, int* found)
+{
+    *found = 0;
+#if BATT_PICO_HTTP_X86_DISPATCH
+    // Most tokens end within a few bytes, so the first block is scanned right here, with an instruction set
+    // the caller is compiled for (so it can be inlined); the selected kernel is only called for longer
+    // tokens.
+    //
+    if (kernel != FindCharKernel::kNone && buf_end - buf >= 16) {
+#ifdef __SSE4_2__
+        buf = findchar_sse42<Ranges>(buf, buf + 16, found);
+#else
+        buf = findchar_sse2<Ranges>(buf, buf + 16, found);
+#endif
+        if (*found) {
+            return buf;
+        }
+    }
+#endif
+    switch (kernel) {
+#if BATT_PICO_HTTP_X86_DISPATCH
+    case FindCharKernel::kAvx512:
+        return findchar_avx512<Ranges>(buf, buf_end, found);
+    case FindCharKernel::kAvx2:
+        return findchar_avx2<Ranges>(buf, buf_end, found);
+    case FindCharKernel::kSse2:
+        return findchar_sse2<Ranges>(buf, buf_end, found);
+#endif
+#if BATT_PICO_HTTP_FINDCHAR_SIMD
+    case FindCharKernel::kSse42:
+        return findchar_sse42<Ranges>(buf, buf_end, found);
+#endif
+    default:
+        break;
+    }
     /* suppress unused parameter warning */
     (void)buf_end;
-    (void)ranges;
-    (void)ranges_size;
-#endif
     return buf;
 }
 
+template <typename Ranges>
+inline const char* findchar_fast(const char* buf, const char* buf_end, int* found)
+{
+    return findchar_fast_with<Ranges>(active_findchar_kernel(), buf, buf_end, found);
+}
+
 BATT_INLINE_IMPL const char* get_token_to_eol(const char* buf, const char* buf_end, std::string_view* token,
                                               int* ret)
 {
@@ -151,13 +417,9 @@ BATT_INLINE_IMPL const char* get_token_to_eol(const char* buf, const char* buf_e
 
     int token_len = 0;
 
-#ifdef __SSE4_2__
-    static const char BATT_PICO_HTTP_ALIGNED(16) ranges1[16] =
-        "\0\010"    /* allow HT */
-        "\012\037"  /* allow SP and up to but not including DEL */
-        "\177\177"; /* allow chars w. MSB set */
+#if BATT_PICO_HTTP_FINDCHAR_SIMD
     int found;
-    buf = findchar_fast(buf, buf_end, ranges1, 6, &found);
+    buf = findchar_fast<EolRanges>(buf, buf_end, &found);
     if (found) {
         goto FOUND_CTL;
     }
@@ -270,22 +532,9 @@ BATT_INLINE_IMPL const char* is_complete(const char* buf, const char* buf_end, u
 BATT_INLINE_IMPL const char* parse_token(const char* buf, const char* buf_end, std::string_view* token,
                                          char next_char, int* ret)
 {
-    /* We use pcmpestri to detect non-token characters. This instruction can take no more than eight character
-     * ranges (8*2*8=128
-     * bits that is the size of a SSE register). Due to this restriction, characters `|` and `~` are handled
-     * in the slow loop. */
-    static const char BATT_PICO_HTTP_ALIGNED(16) ranges[] =
-        "\x00 "  /* control chars and up to SP */
-        "\"\""   /* 0x22 */
-        "()"     /* 0x28,0x29 */
-        ",,"     /* 0x2c */
-        "//"     /* 0x2f */
-        ":@"     /* 0x3a-0x40 */
-        "[]"     /* 0x5b-0x5d */
-        "{\xff"; /* 0x7b-0xff */
     const char* buf_start = buf;
     int found;
-    buf = findchar_fast(buf, buf_end, ranges, sizeof(ranges) - 1, &found);
+    buf = findchar_fast<NonTokenRanges>(buf, buf_end, &found);
     if (!found) {
         BATT_PICO_HTTP_CHECK_EOF();
     }
@@ -325,7 +574,7 @@ BATT_INLINE_IMPL const char* parse_http_version(const char* buf, const char* buf
 
 BATT_INLINE_IMPL const char* parse_headers_impl(const char* buf, const char* buf_end,
                                                 batt::SmallVecBase<pico_http::MessageHeader>* headers,
-                                                int* ret)
+                                                pico_http::HeaderIndex* header_index, int* ret)
 {
     usize num_headers = 0;
     std::string_view header_name;
@@ -334,6 +583,9 @@ BATT_INLINE_IMPL const char* parse_headers_impl(const char* buf, const char* buf
     const auto commit_header = [&] {
         headers->emplace_back(pico_http::MessageHeader{header_name, header_value});
         ++num_headers;
+        if (header_index) {
+            header_index->add(header_name);
+        }
     };
 
     for (;; commit_header()) {
@@ -389,7 +641,7 @@ BATT_INLINE_IMPL const char* parse_request_impl(const char* buf, const char* buf
                                                 std::string_view* method, std::string_view* path,
                                                 int* minor_version,
                                                 batt::SmallVecBase<pico_http::MessageHeader>* headers,
-                                                int* ret)
+                                                pico_http::HeaderIndex* header_index, int* ret)
 {
     /* skip first empty line (some clients add CRLF after POST content) */
     BATT_PICO_HTTP_CHECK_EOF();
@@ -435,7 +687,7 @@ BATT_INLINE_IMPL const char* parse_request_impl(const char* buf, const char* buf
         return nullptr;
     }
 
-    return ::pico_http::detail::parse_headers_impl(buf, buf_end, headers, ret);
+    return ::pico_http::detail::parse_headers_impl(buf, buf_end, headers, header_index, ret);
 }
 
 }  // namespace
@@ -454,6 +706,7 @@ BATT_INLINE_IMPL int pico_http::Request::parse(const char* buf_start, usize len,
     this->major_version = -1;
     this->minor_version = -1;
     this->headers.clear();
+    this->header_index.clear();
 
     /* if last_len != 0, check if the request is complete (a fast countermeasure
        againt slowloris */
@@ -463,7 +716,8 @@ BATT_INLINE_IMPL int pico_http::Request::parse(const char* buf_start, usize len,
     }
 
     buf = ::pico_http::detail::parse_request_impl(buf, buf_end, &this->method, &this->path,
-                                                  &this->minor_version, &this->headers, &r);
+                                                  &this->minor_version, &this->headers,
+                                                  &this->header_index, &r);
     if (buf == nullptr) {
         return r;
     }
@@ -480,7 +734,7 @@ namespace {
 BATT_INLINE_IMPL const char* parse_response_impl(const char* buf, const char* buf_end, int* minor_version,
                                                  int* status, std::string_view* msg,
                                                  batt::SmallVecBase<pico_http::MessageHeader>* headers,
-                                                 int* ret)
+                                                 pico_http::HeaderIndex* header_index, int* ret)
 {
     /* parse "HTTP/1.x" */
     if ((buf = parse_http_version(buf, buf_end, minor_version, ret)) == nullptr) {
@@ -524,7 +778,7 @@ BATT_INLINE_IMPL const char* parse_response_impl(const char* buf, const char* bu
         return nullptr;
     }
 
-    return ::pico_http::detail::parse_headers_impl(buf, buf_end, headers, ret);
+    return ::pico_http::detail::parse_headers_impl(buf, buf_end, headers, header_index, ret);
 }
 
 }  // namespace
@@ -546,6 +800,7 @@ BATT_INLINE_IMPL int pico_http::Response::parse(const char* buf_start, usize len
     this->status = 0;
     this->message = std::string_view{};
     this->headers.clear();
+    this->header_index.clear();
 
     /* if last_len != 0, check if the response is complete (a fast countermeasure
        against slowloris */
@@ -555,7 +810,7 @@ BATT_INLINE_IMPL int pico_http::Response::parse(const char* buf_start, usize len
     }
 
     buf = ::pico_http::detail::parse_response_impl(buf, buf_end, &this->minor_version, &this->status,
-                                                   &this->message, &this->headers, &r);
+                                                   &this->message, &this->headers, &this->header_index, &r);
     if (buf == nullptr) {
         return r;
     }
@@ -581,7 +836,8 @@ BATT_INLINE_IMPL int pico_http::parse_headers(const char* buf_start, usize len,
         return r;
     }
 
-    if ((buf = ::pico_http::detail::parse_headers_impl(buf, buf_end, headers, &r)) == nullptr) {
+    buf = ::pico_http::detail::parse_headers_impl(buf, buf_end, headers, /*header_index=*/nullptr, &r);
+    if (buf == nullptr) {
         return r;
     }
 
@@ -758,7 +1014,6 @@ BATT_INLINE_IMPL int pico_http::decode_chunked_is_in_data(pico_http::ChunkedDeco
 #undef BATT_PICO_HTTP_CHECK_EOF
 #undef BATT_PICO_HTTP_EXPECT_CHAR
 #undef BATT_PICO_HTTP_ADVANCE_TOKEN
-#undef BATT_PICO_HTTP_ALIGNED
 
 namespace pico_http {
 
@@ -787,6 +1042,33 @@ BATT_INLINE_IMPL std::ostream& operator<<(std::ostream& out, const Request& t)
                << t.headers << "\r\n";
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void append_to(std::string& out, const Request& t)
+{
+    const auto append_int = [&out](int i) {
+        std::array<char, 16> digits;
+        const std::to_chars_result result = std::to_chars(digits.data(), digits.data() + digits.size(), i);
+        out.append(digits.data(), result.ptr);
+    };
+
+    out.append(t.method);
+    out += ' ';
+    out.append(t.path);
+    out.append(" HTTP/");
+    append_int(t.major_version);
+    out += '.';
+    append_int(t.minor_version);
+    out.append("\r\n");
+    for (const MessageHeader& hdr : t.headers) {
+        out.append(hdr.name);
+        out.append(": ");
+        out.append(hdr.value);
+        out.append("\r\n");
+    }
+    out.append("\r\n");
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 BATT_INLINE_IMPL std::ostream& operator<<(std::ostream& out, const Response& t)
@@ -796,6 +1078,34 @@ BATT_INLINE_IMPL std::ostream& operator<<(std::ostream& out, const Response& t)
                << t.headers << "\r\n";
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BATT_INLINE_IMPL void append_to(std::string& out, const Response& t)
+{
+    const auto append_int = [&out](int i) {
+        std::array<char, 16> digits;
+        const std::to_chars_result result = std::to_chars(digits.data(), digits.data() + digits.size(), i);
+        out.append(digits.data(), result.ptr);
+    };
+
+    out.append("HTTP/");
+    append_int(t.major_version);
+    out += '.';
+    append_int(t.minor_version);
+    out += ' ';
+    append_int(t.status);
+    out += ' ';
+    out.append(t.message);
+    out.append("\r\n");
+    for (const MessageHeader& hdr : t.headers) {
+        out.append(hdr.name);
+        out.append(": ");
+        out.append(hdr.value);
+        out.append("\r\n");
+    }
+    out.append("\r\n");
+}
+
 }  // namespace pico_http
 
 #endif  // BATTERIES_PICO_HTTP_PARSER_IMPL_HPP
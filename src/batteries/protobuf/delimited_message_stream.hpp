@@ -0,0 +1,327 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#pragma once
+#ifndef BATTERIES_PROTOBUF_DELIMITED_MESSAGE_STREAM_HPP
+#define BATTERIES_PROTOBUF_DELIMITED_MESSAGE_STREAM_HPP
+
+#include <batteries/config.hpp>
+
+#ifndef BATT_PROTOBUF_AVAILABLE
+#error This header may only be included if BATT_PROTOBUF_AVAILABLE is defined
+#else
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream.h>
+#include <google/protobuf/message_lite.h>
+
+#include <batteries/assert.hpp>
+#include <batteries/async/framed_records.hpp>
+#include <batteries/async/stream_buffer.hpp>
+#include <batteries/buffer.hpp>
+#include <batteries/checked_cast.hpp>
+#include <batteries/int_types.hpp>
+#include <batteries/small_vec.hpp>
+#include <batteries/status.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace batt {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// A batch of protobuf messages of type `Msg`, all allocated on a single Arena that is reused from one batch
+// to the next.
+//
+// The Arena is given an initial block owned by the batch, which survives `clear()`; so as long as a batch
+// fits in that block, reading batches does no heap allocation at all in the steady state.
+//
+template <typename Msg>
+class DelimitedMessageBatch
+{
+   public:
+    static constexpr usize kDefaultInitialBlockSize = 64 * 1024;
+
+    explicit DelimitedMessageBatch(usize initial_block_size = kDefaultInitialBlockSize)
+        : initial_block_{new char[initial_block_size]}
+        , arena_{[&] {
+            google::protobuf::ArenaOptions options;
+            options.initial_block = this->initial_block_.get();
+            options.initial_block_size = initial_block_size;
+            return options;
+        }()}
+    {
+    }
+
+    DelimitedMessageBatch(const DelimitedMessageBatch&) = delete;
+    DelimitedMessageBatch& operator=(const DelimitedMessageBatch&) = delete;
+
+    google::protobuf::Arena& arena()
+    {
+        return this->arena_;
+    }
+
+    const std::vector<Msg*>& messages() const
+    {
+        return this->messages_;
+    }
+
+    usize size() const
+    {
+        return this->messages_.size();
+    }
+
+    bool empty() const
+    {
+        return this->messages_.empty();
+    }
+
+    auto begin() const
+    {
+        return this->messages_.begin();
+    }
+
+    auto end() const
+    {
+        return this->messages_.end();
+    }
+
+    // Allocates a new (empty) message on the arena and adds it to the end of the batch.
+    //
+    Msg* add()
+    {
+        Msg* msg = google::protobuf::Arena::CreateMessage<Msg>(&this->arena_);
+        this->messages_.emplace_back(msg);
+        return msg;
+    }
+
+    // Destroys all messages in the batch, retaining the arena's initial block for reuse.
+    //
+    void clear()
+    {
+        this->messages_.clear();
+        this->arena_.Reset();
+    }
+
+   private:
+    std::unique_ptr<char[]> initial_block_;
+    google::protobuf::Arena arena_;
+    std::vector<Msg*> messages_;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Reads a stream of varint-length-delimited protobuf messages (the format produced by
+// `google::protobuf::util::SerializeDelimitedToZeroCopyStream` and DelimitedMessageWriter) from a
+// StreamBuffer.
+//
+// Each message is parsed directly out of the StreamBuffer's memory (see FramedRecordReader); consumption of
+// the parsed bytes is batched.  So every message's frame (length prefix plus message) must fit in the
+// StreamBuffer; a longer frame fails with StatusCode::kInvalidArgument.
+//
+class DelimitedMessageReader
+{
+   public:
+    explicit DelimitedMessageReader(
+        StreamBuffer& buffer,
+        usize max_message_size = FramedRecordReader<StreamBuffer&>::kDefaultMaxRecordSize) noexcept
+        : records_{buffer, RecordLengthFormat::kVarint, max_message_size}
+    {
+    }
+
+    // Parses the next message into `msg`, blocking until it is available.  Returns StatusCode::kEndOfStream
+    // if the stream is closed cleanly at a message boundary.
+    //
+    Status read_next(google::protobuf::MessageLite* msg)
+    {
+        Optional<ConstBuffer> record = this->records_.next();
+        if (!record) {
+            return this->records_.status();
+        }
+        return parse_message(*record, msg);
+    }
+
+    // Clears `batch`, then reads at least one and at most `max_count` messages into it.  Blocks only for
+    // the first message; after that, reads only the messages whose data is already buffered.  Returns the
+    // number of messages read; if the stream ends (or fails) before the first message, returns the error
+    // status (StatusCode::kEndOfStream on a clean end of stream).
+    //
+    template <typename Msg>
+    StatusOr<usize> read_batch(DelimitedMessageBatch<Msg>& batch, usize max_count)
+    {
+        batch.clear();
+
+        if (max_count == 0) {
+            return 0;
+        }
+
+        Optional<ConstBuffer> record = this->records_.next();
+        if (!record) {
+            return this->records_.status();
+        }
+        for (;;) {
+            BATT_REQUIRE_OK(parse_message(*record, batch.add()));
+            if (batch.size() == max_count) {
+                break;
+            }
+            record = this->records_.next_buffered();
+            if (!record) {
+                break;
+            }
+        }
+
+        return batch.size();
+    }
+
+   private:
+    static Status parse_message(const ConstBuffer& data, google::protobuf::MessageLite* msg)
+    {
+        if (!msg->ParseFromArray(data.data(), BATT_CHECKED_CAST(int, data.size()))) {
+            return {StatusCode::kDataLoss};
+        }
+        return OkStatus();
+    }
+
+    FramedRecordReader<StreamBuffer&> records_;
+};
+
+namespace detail {
+
+// A ZeroCopyOutputStream over a fixed sequence of (already prepared) buffers.
+//
+class PreparedBuffersOutputStream : public google::protobuf::io::ZeroCopyOutputStream
+{
+   public:
+    explicit PreparedBuffersOutputStream(const SmallVec<MutableBuffer, 2>& buffers) noexcept
+        : buffers_{buffers}
+    {
+    }
+
+    bool Next(void** data, int* size) override
+    {
+        if (this->next_ == this->buffers_.size()) {
+            return false;
+        }
+        const MutableBuffer& next = this->buffers_[this->next_];
+        this->next_ += 1;
+        this->byte_count_ += next.size();
+
+        *data = next.data();
+        *size = BATT_CHECKED_CAST(int, next.size());
+
+        return true;
+    }
+
+    void BackUp(int count) override
+    {
+        this->byte_count_ -= count;
+    }
+
+    i64 ByteCount() const override
+    {
+        return this->byte_count_;
+    }
+
+   private:
+    const SmallVec<MutableBuffer, 2>& buffers_;
+    usize next_ = 0;
+    i64 byte_count_ = 0;
+};
+
+}  // namespace detail
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Writes varint-length-delimited protobuf messages to a StreamBuffer.
+//
+class DelimitedMessageWriter
+{
+   public:
+    explicit DelimitedMessageWriter(StreamBuffer& buffer) noexcept : buffer_{buffer}
+    {
+    }
+
+    Status write(const google::protobuf::MessageLite& msg)
+    {
+        const google::protobuf::MessageLite* msgs[1] = {&msg};
+        return this->write_batch(std::begin(msgs), std::end(msgs));
+    }
+
+    // Writes all the messages in the range `[first, last)`, whose elements must be (smart or raw) pointers
+    // to google::protobuf::MessageLite.
+    //
+    // As many messages as will fit in the StreamBuffer are serialized into a single prepared region, which
+    // is then committed all at once.
+    //
+    // A DelimitedMessageReader can only read a message whose frame (length prefix plus message) fits in the
+    // StreamBuffer, so if a message's frame is larger than the buffer's capacity, this returns
+    // StatusCode::kInvalidArgument; the messages before it are written, and none after.
+    //
+    template <typename Iter>
+    Status write_batch(Iter first, Iter last)
+    {
+        const usize capacity = this->buffer_.capacity();
+
+        while (first != last) {
+            // Find the longest prefix of the remaining messages that fits in the buffer.
+            //
+            usize batch_size = 0;
+            Iter batch_last = first;
+            for (; batch_last != last; ++batch_last) {
+                const usize msg_size = (*batch_last)->ByteSizeLong();
+                const usize frame_size =
+                    framed_record_header_size(RecordLengthFormat::kVarint, msg_size) + msg_size;
+
+                if (batch_size + frame_size > capacity) {
+                    break;
+                }
+                batch_size += frame_size;
+            }
+
+            if (batch_last == first) {
+                // The first message is too large to fit in the buffer at all.
+                //
+                return {StatusCode::kInvalidArgument};
+            }
+
+            StatusOr<SmallVec<MutableBuffer, 2>> prepared = this->buffer_.prepare_exactly(batch_size);
+            BATT_REQUIRE_OK(prepared);
+
+            if (prepared->front().size() == batch_size) {
+                // Fast path: the prepared region is contiguous.
+                //
+                u8* dst = static_cast<u8*>(prepared->front().data());
+                for (; first != batch_last; ++first) {
+                    const auto& msg = **first;
+                    dst = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+                        BATT_CHECKED_CAST(u32, msg.GetCachedSize()), dst);
+                    dst = msg.SerializeWithCachedSizesToArray(dst);
+                }
+                BATT_CHECK_EQ(dst, static_cast<u8*>(prepared->front().data()) + batch_size);
+            } else {
+                detail::PreparedBuffersOutputStream raw_out{*prepared};
+                google::protobuf::io::CodedOutputStream out{&raw_out};
+                for (; first != batch_last; ++first) {
+                    const auto& msg = **first;
+                    out.WriteVarint32(BATT_CHECKED_CAST(u32, msg.GetCachedSize()));
+                    msg.SerializeWithCachedSizes(&out);
+                }
+                out.Trim();
+                BATT_CHECK(!out.HadError());
+                BATT_CHECK_EQ(out.ByteCount(), BATT_CHECKED_CAST(i64, batch_size));
+            }
+
+            this->buffer_.commit(batch_size);
+        }
+
+        return OkStatus();
+    }
+
+   private:
+    StreamBuffer& buffer_;
+};
+
+}  // namespace batt
+
+#endif  // BATT_PROTOBUF_AVAILABLE
+
+#endif  // BATTERIES_PROTOBUF_DELIMITED_MESSAGE_STREAM_HPP
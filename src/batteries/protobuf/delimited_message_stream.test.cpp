@@ -0,0 +1,244 @@
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// Copyright 2022 Anthony Paul Astolfi
+//
+#include <batteries/config.hpp>
+
+#ifdef BATT_PROTOBUF_AVAILABLE
+
+#include <batteries/protobuf/delimited_message_stream.hpp>
+//
+#include <batteries/protobuf/delimited_message_stream.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <google/protobuf/api.pb.h>
+#include <google/protobuf/timestamp.pb.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. write_batch -> read_batch roundtrip
+//     a. max_count limits the batch
+//     b. a partially written message is not included in a batch
+//  2. messages split across the end of the StreamBuffer's ring
+//  3. truncated length prefix -> kDataLoss
+//  4. oversized length prefix -> kInvalidArgument
+//  5. the batch arena is reused, not grown, from one batch to the next
+//  6. a message too large for the StreamBuffer is rejected by the writer
+//
+
+using namespace batt::int_types;
+
+using google::protobuf::Timestamp;
+
+std::vector<std::unique_ptr<Timestamp>> make_timestamps(usize count, i64 first_seconds)
+{
+    std::vector<std::unique_ptr<Timestamp>> msgs;
+    for (usize i = 0; i < count; ++i) {
+        auto msg = std::make_unique<Timestamp>();
+        msg->set_seconds(first_seconds + i * 1000003);
+        msg->set_nanos(i * 7919);
+        msgs.emplace_back(std::move(msg));
+    }
+    return msgs;
+}
+
+void expect_timestamps_eq(const batt::DelimitedMessageBatch<Timestamp>& batch,
+                          const std::vector<std::unique_ptr<Timestamp>>& expected, usize first)
+{
+    ASSERT_LE(first + batch.size(), expected.size());
+
+    usize i = first;
+    for (const Timestamp* msg : batch) {
+        EXPECT_EQ(msg->seconds(), expected[i]->seconds()) << BATT_INSPECT(i);
+        EXPECT_EQ(msg->nanos(), expected[i]->nanos()) << BATT_INSPECT(i);
+        ++i;
+    }
+}
+
+TEST(DelimitedMessageStreamTest, BatchRoundTrip)
+{
+    batt::StreamBuffer stream{4096};
+    batt::DelimitedMessageWriter writer{stream};
+    batt::DelimitedMessageReader reader{stream};
+
+    const auto msgs = make_timestamps(10, /*first_seconds=*/1600000000);
+
+    ASSERT_TRUE(writer.write_batch(msgs.begin(), msgs.end()).ok());
+
+    // Leave a partial message at the end of the stream.
+    //
+    const std::array<u8, 3> partial = {10, 0x08, 0x01};
+    ASSERT_TRUE(stream.write_all(batt::ConstBuffer{partial.data(), partial.size()}).ok());
+
+    batt::DelimitedMessageBatch<Timestamp> batch;
+
+    batt::StatusOr<usize> n_read = reader.read_batch(batch, /*max_count=*/4);
+    ASSERT_TRUE(n_read.ok()) << n_read.status();
+    EXPECT_EQ(*n_read, 4u);
+    expect_timestamps_eq(batch, msgs, 0);
+
+    n_read = reader.read_batch(batch, /*max_count=*/100);
+    ASSERT_TRUE(n_read.ok()) << n_read.status();
+    EXPECT_EQ(*n_read, 6u);
+    expect_timestamps_eq(batch, msgs, 4);
+
+    stream.close_for_write();
+
+    n_read = reader.read_batch(batch, /*max_count=*/100);
+    EXPECT_EQ(n_read.status(), batt::StatusCode::kDataLoss);
+}
+
+TEST(DelimitedMessageStreamTest, MessagesSplitAcrossRingWrap)
+{
+    const auto msgs = make_timestamps(5, /*first_seconds=*/1700000000);
+
+    // Try every write position in the ring, so that both the length prefix and the message body of some
+    // message are split across the end of the buffer.
+    //
+    for (usize offset = 0; offset < 64; ++offset) {
+        batt::StreamBuffer stream{64};
+        batt::DelimitedMessageWriter writer{stream};
+        batt::DelimitedMessageReader reader{stream};
+
+        if (offset != 0) {
+            const std::vector<char> filler(offset, 'x');
+            ASSERT_TRUE(stream.write_all(batt::ConstBuffer{filler.data(), filler.size()}).ok());
+            ASSERT_TRUE(stream.fetch_at_least(offset).ok());
+            stream.consume(offset);
+        }
+
+        ASSERT_TRUE(writer.write_batch(msgs.begin(), msgs.end()).ok());
+        stream.close_for_write();
+
+        batt::DelimitedMessageBatch<Timestamp> batch;
+
+        batt::StatusOr<usize> n_read = reader.read_batch(batch, /*max_count=*/100);
+        ASSERT_TRUE(n_read.ok()) << n_read.status() << BATT_INSPECT(offset);
+        EXPECT_EQ(*n_read, msgs.size()) << BATT_INSPECT(offset);
+        expect_timestamps_eq(batch, msgs, 0);
+
+        n_read = reader.read_batch(batch, /*max_count=*/100);
+        EXPECT_EQ(n_read.status(), batt::StatusCode::kEndOfStream);
+    }
+}
+
+TEST(DelimitedMessageStreamTest, TruncatedLengthPrefix)
+{
+    batt::StreamBuffer stream{1024};
+    batt::DelimitedMessageWriter writer{stream};
+    batt::DelimitedMessageReader reader{stream};
+
+    const auto msgs = make_timestamps(1, /*first_seconds=*/1);
+    ASSERT_TRUE(writer.write(*msgs.front()).ok());
+
+    // The continuation bit is set on the last byte of the stream.
+    //
+    const std::array<u8, 1> partial = {0x80};
+    ASSERT_TRUE(stream.write_all(batt::ConstBuffer{partial.data(), partial.size()}).ok());
+    stream.close_for_write();
+
+    Timestamp msg;
+    ASSERT_TRUE(reader.read_next(&msg).ok());
+    EXPECT_EQ(msg.seconds(), 1);
+
+    EXPECT_EQ(reader.read_next(&msg), batt::StatusCode::kDataLoss);
+}
+
+TEST(DelimitedMessageStreamTest, OversizedLengthPrefix)
+{
+    batt::StreamBuffer stream{1024};
+    batt::DelimitedMessageReader reader{stream, /*max_message_size=*/64};
+
+    // The length prefix (varint 1000) claims more than the reader allows.
+    //
+    const std::array<u8, 2> prefix = {0xe8, 0x07};
+    ASSERT_TRUE(stream.write_all(batt::ConstBuffer{prefix.data(), prefix.size()}).ok());
+    stream.close_for_write();
+
+    batt::DelimitedMessageBatch<Timestamp> batch;
+
+    batt::StatusOr<usize> n_read = reader.read_batch(batch, /*max_count=*/10);
+    EXPECT_EQ(n_read.status(), batt::StatusCode::kInvalidArgument);
+    EXPECT_TRUE(batch.empty());
+}
+
+TEST(DelimitedMessageStreamTest, ArenaReusedAcrossBatches)
+{
+    batt::StreamBuffer stream{4096};
+    batt::DelimitedMessageWriter writer{stream};
+    batt::DelimitedMessageReader reader{stream};
+
+    batt::DelimitedMessageBatch<Timestamp> batch{/*initial_block_size=*/16 * 1024};
+
+    batt::Optional<u64> space_allocated;
+
+    for (usize round = 0; round < 20; ++round) {
+        const auto msgs = make_timestamps(50, /*first_seconds=*/round * 100000);
+        ASSERT_TRUE(writer.write_batch(msgs.begin(), msgs.end()).ok());
+
+        batt::StatusOr<usize> n_read = reader.read_batch(batch, /*max_count=*/msgs.size());
+        ASSERT_TRUE(n_read.ok()) << n_read.status();
+        ASSERT_EQ(*n_read, msgs.size());
+        expect_timestamps_eq(batch, msgs, 0);
+
+        for (const Timestamp* msg : batch) {
+            EXPECT_EQ(msg->GetArena(), &batch.arena());
+        }
+
+        // After the first round, the arena should not need any more memory.
+        //
+        if (!space_allocated) {
+            space_allocated = batch.arena().SpaceAllocated();
+        } else {
+            EXPECT_EQ(batch.arena().SpaceAllocated(), *space_allocated) << BATT_INSPECT(round);
+        }
+    }
+}
+
+TEST(DelimitedMessageStreamTest, MessageLargerThanBuffer)
+{
+    batt::StreamBuffer stream{64};
+    batt::DelimitedMessageWriter writer{stream};
+    batt::DelimitedMessageReader reader{stream};
+
+    // These three messages fit in the buffer together; `too_large` doesn't fit at all.
+    //
+    const auto msgs = make_timestamps(3, /*first_seconds=*/1LL << 40);
+
+    google::protobuf::Api too_large;
+    too_large.set_name(std::string(100, 'x'));
+
+    std::vector<const google::protobuf::MessageLite*> batch_msgs;
+    for (const auto& msg : msgs) {
+        batch_msgs.emplace_back(msg.get());
+    }
+    batch_msgs.emplace_back(&too_large);
+    batch_msgs.emplace_back(msgs.front().get());
+
+    // The messages before the one that can't fit are written.
+    //
+    EXPECT_EQ(writer.write_batch(batch_msgs.begin(), batch_msgs.end()), batt::StatusCode::kInvalidArgument);
+    EXPECT_EQ(writer.write(too_large), batt::StatusCode::kInvalidArgument);
+
+    stream.close_for_write();
+
+    batt::DelimitedMessageBatch<Timestamp> batch;
+
+    batt::StatusOr<usize> n_read = reader.read_batch(batch, /*max_count=*/100);
+    ASSERT_TRUE(n_read.ok()) << n_read.status();
+    EXPECT_EQ(*n_read, msgs.size());
+    expect_timestamps_eq(batch, msgs, 0);
+
+    n_read = reader.read_batch(batch, /*max_count=*/100);
+    EXPECT_EQ(n_read.status(), batt::StatusCode::kEndOfStream);
+}
+
+}  // namespace
+
+#endif  // BATT_PROTOBUF_AVAILABLE
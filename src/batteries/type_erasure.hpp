@@ -113,11 +113,13 @@ class TypeErasedStorage : public TypeErasedStorageBase<AbstractType, TypedImpl>
         this->emplace(static_type, BATT_FORWARD(args)...);
     }
 
-    TypeErasedStorage(const TypeErasedStorage& other) : impl_{other.impl_->copy_to(this->memory())}
+    TypeErasedStorage(const TypeErasedStorage& other)
+        : impl_{other.impl_ ? other.impl_->copy_to(this->memory()) : nullptr}
     {
     }
 
-    TypeErasedStorage(TypeErasedStorage&& other) : impl_{other.get_abstract()->move_to(this->memory())}
+    TypeErasedStorage(TypeErasedStorage&& other)
+        : impl_{other.impl_ ? other.get_abstract()->move_to(this->memory()) : nullptr}
     {
         other.clear();
     }
@@ -133,8 +135,10 @@ class TypeErasedStorage : public TypeErasedStorageBase<AbstractType, TypedImpl>
     {
         if (BATT_HINT_TRUE(this != &other)) {
             this->clear();
-            this->impl_ = other.get_abstract()->move_to(this->memory());
-            other.clear();
+            if (other.impl_) {
+                this->impl_ = other.get_abstract()->move_to(this->memory());
+                other.clear();
+            }
         }
         return *this;
     }
@@ -143,7 +147,9 @@ class TypeErasedStorage : public TypeErasedStorageBase<AbstractType, TypedImpl>
     {
         if (BATT_HINT_TRUE(this != &other)) {
             this->clear();
-            this->impl_ = other.impl_->copy_to(this->memory());
+            if (other.impl_) {
+                this->impl_ = other.impl_->copy_to(this->memory());
+            }
         }
         return *this;
     }
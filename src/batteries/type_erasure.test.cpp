@@ -231,4 +231,37 @@ TEST(TypeErasureTest, Basic)
     run_basic_tests<2000>();
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+TEST(TypeErasureTest, CopyAndMoveEmpty)
+{
+    using Storage = batt::TypeErasedStorage<AbstractMockValue, MockValueImpl>;
+
+    ::testing::StrictMock<MockValue> mock;
+
+    EXPECT_CALL(mock, default_construct(Val{7})).WillOnce(::testing::Return());
+    EXPECT_CALL(mock, move_construct(Val{7}, Gen{1})).WillOnce(::testing::Return());
+    EXPECT_CALL(mock, destruct(Val{7}, Gen{0})).WillOnce(::testing::Return());
+
+    Storage storage{batt::StaticType<ValueWrapper<0>>{}, ValueWrapper<0>{Val{7}, mock}};
+
+    EXPECT_CALL(mock, destruct(Val{7}, Gen{1})).WillOnce(::testing::Return());
+    EXPECT_TRUE(storage.is_valid());
+
+    const Storage empty;
+
+    Storage copied{empty};
+    EXPECT_FALSE(copied.is_valid());
+
+    Storage moved{Storage{}};
+    EXPECT_FALSE(moved.is_valid());
+
+    // Assigning an empty storage destroys the current value.
+    //
+    storage = Storage{};
+    EXPECT_FALSE(storage.is_valid());
+
+    storage = empty;
+    EXPECT_FALSE(storage.is_valid());
+}
+
 }  // namespace
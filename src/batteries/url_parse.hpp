@@ -12,6 +12,7 @@
 #include <batteries/status.hpp>
 #include <batteries/stream_util.hpp>
 
+#include <string>
 #include <string_view>
 
 namespace batt {
@@ -71,6 +72,10 @@ StatusOr<UrlParse> parse_url_fragment(std::string_view url, UrlParse&& parse);
 
 }  // namespace detail
 
+// Decodes %XX escapes in a URL component (e.g. a host or path); malformed escapes are left as-is.
+//
+std::string url_decode(std::string_view s);
+
 inline StatusOr<UrlParse> parse_url(std::string_view url)
 {
     UrlParse parse;
@@ -101,6 +106,38 @@ inline StatusOr<UrlParse> parse_url(std::string_view url)
     return detail::parse_url_path(url, std::move(parse));
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+inline std::string url_decode(std::string_view s)
+{
+    const auto hex_value = [](char ch) -> int {
+        if (ch >= '0' && ch <= '9') {
+            return ch - '0';
+        }
+        if (ch >= 'a' && ch <= 'f') {
+            return ch - 'a' + 10;
+        }
+        if (ch >= 'A' && ch <= 'F') {
+            return ch - 'A' + 10;
+        }
+        return -1;
+    };
+
+    std::string decoded;
+    decoded.reserve(s.size());
+
+    for (usize i = 0; i < s.size(); ++i) {
+        if (s[i] == '%' && i + 2 < s.size() && hex_value(s[i + 1]) >= 0 && hex_value(s[i + 2]) >= 0) {
+            decoded += static_cast<char>(hex_value(s[i + 1]) * 16 + hex_value(s[i + 2]));
+            i += 2;
+        } else {
+            decoded += s[i];
+        }
+    }
+
+    return decoded;
+}
+
 //#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
 
 namespace detail {
@@ -265,4 +265,39 @@ TEST(UrlParseTest, Examples)
               }));
 }
 
+
+TEST(UrlParseTest, UnixSocketUrls)
+{
+    EXPECT_EQ(batt::parse_url("unix:///var/run/app.sock"),  //
+              ok_value(batt::UrlParse{
+                  .scheme = "unix",
+                  .user = "",
+                  .host = "",
+                  .port = batt::None,
+                  .path = "/var/run/app.sock",
+                  .query = "",
+                  .fragment = "",
+              }));
+
+    EXPECT_EQ(batt::parse_url("unix://%2Fvar%2Frun%2Fapp.sock/v1/status?verbose=1"),  //
+              ok_value(batt::UrlParse{
+                  .scheme = "unix",
+                  .user = "",
+                  .host = "%2Fvar%2Frun%2Fapp.sock",
+                  .port = batt::None,
+                  .path = "/v1/status",
+                  .query = "verbose=1",
+                  .fragment = "",
+              }));
+}
+
+TEST(UrlParseTest, UrlDecode)
+{
+    EXPECT_EQ(batt::url_decode(""), "");
+    EXPECT_EQ(batt::url_decode("abc"), "abc");
+    EXPECT_EQ(batt::url_decode("%2Fvar%2frun%2Fapp.sock"), "/var/run/app.sock");
+    EXPECT_EQ(batt::url_decode("a%20b%"), "a b%");
+    EXPECT_EQ(batt::url_decode("%zz%4"), "%zz%4");
+}
+
 }  // namespace